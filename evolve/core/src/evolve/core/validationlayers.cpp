@@ -36,7 +36,30 @@
 #include <GLFW/glfw3.h>
 
 static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugReportFlagsEXT iFlags, VkDebugReportObjectTypeEXT iObjType, uint64_t iObj, size_t iLocation, int32_t iCode, const char* iLayerPrefix, const char* iMsg, void* iUserData) {
-	EVOLVE_LOG_ERROR("validation layer: " << iMsg);
+	if (!evolve::log::Logger::IsEnabled(evolve::log::LEVEL_ERROR)) {
+		return VK_FALSE;
+	}
+
+	//a bad command recorded every frame reports the same message each time: collapse repeats per (code, message, location),
+	//the message is part of the key since most layers report code and location 0, and labels the summaries of the key
+	unsigned long long aMessageHash = 14695981039346656037ULL;
+	for (const char* aChar = iMsg; aChar != nullptr && *aChar != '\0'; ++aChar) {
+		aMessageHash = (aMessageHash ^ static_cast<unsigned char>(*aChar)) * 1099511628211ULL;
+	}
+
+	static evolve::log::LogSuppressor aSuppressor;
+	unsigned long long aRepeated = 0;
+	if (!aSuppressor.admit(aMessageHash ^ static_cast<uint32_t>(iCode), static_cast<unsigned long long>(iLocation), aRepeated,
+		evolve::log::LEVEL_ERROR, __FILE__, __LINE__, __FUNCTION__, iMsg)) {
+		return VK_FALSE;
+	}
+
+	if (aRepeated != 0) {
+		EVOLVE_LOG_ERROR("validation layer: " << iMsg << " (repeated " << aRepeated << " times)");
+	}
+	else {
+		EVOLVE_LOG_ERROR("validation layer: " << iMsg);
+	}
 
 	return VK_FALSE;
 }
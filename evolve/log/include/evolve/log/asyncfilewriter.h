@@ -0,0 +1,180 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/asyncfilewriter.h
+ * \brief evolve/log background file writer, io_uring or thread pool
+ * \author
+ *
+ */
+
+#ifndef EVOLVE_ASYNC_FILE_WRITER_H
+#define EVOLVE_ASYNC_FILE_WRITER_H
+
+#include <evolve/log/export.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Number of threads writing when io_uring is not available
+ */
+#ifndef EVOLVE_LOG_ASYNC_WRITER_THREADS
+#define EVOLVE_LOG_ASYNC_WRITER_THREADS 2
+#endif
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		/**
+		 * \brief Writes filled buffers to a file in the background
+		 *
+		 * A small ring of buffers is written at explicit offsets, so buffers in
+		 * flight complete in any order and the file still reads in submission
+		 * order. On Linux the writes are submitted to an io_uring and the
+		 * completions are reaped without blocking by the owner thread; when
+		 * io_uring can't be set up (old kernel, seccomp filter, other platform),
+		 * or when the EVOLVE_LOG_IO_URING environment variable is "0", a pool of
+		 * EVOLVE_LOG_ASYNC_WRITER_THREADS threads writes them instead.
+		 *
+		 * Owned by one thread: only emergencyWrite() may be called from another
+		 * one. The caller blocks only when every buffer is in flight.
+		 *
+		 * A write failing for good (disk full, I/O error) disables the writer
+		 * until the next open(): later buffers are dropped, and once the writes
+		 * in flight are done the file is cut at the first byte not written, so
+		 * it never holds a hole of zero bytes.
+		 */
+		class EVOLVE_LOG_EXPORT AsyncFileWriter {
+		public:
+			/**
+			 * \brief Constructor
+			 *
+			 * \param[in] iBuffers number of buffers, at least 1
+			 * \param[in] iCapacity bytes reserved in each buffer
+			 */
+			AsyncFileWriter(unsigned int iBuffers, std::size_t iCapacity);
+
+			/**
+			 * \brief Destructor, waits for the buffers in flight
+			 */
+			~AsyncFileWriter();
+
+			/**
+			 * \brief Open a file, writes go after its current end
+			 *
+			 * \param[in] iPath complete file path
+			 * \return false if the file can't be opened
+			 */
+			bool open(const char* iPath);
+
+			/**
+			 * \brief Wait for the buffers in flight then close the file
+			 */
+			void close();
+
+			/**
+			 * \brief Queue bytes for writing
+			 *
+			 * ioBuffer is swapped with a free buffer, so no byte is copied and
+			 * the caller gets back an empty string with reserved capacity.
+			 *
+			 * \param[in,out] ioBuffer bytes to write, left empty
+			 */
+			void write(std::string& ioBuffer);
+
+			/**
+			 * \brief Wait until everything queued is in the file, or has failed
+			 */
+			void wait();
+
+			/**
+			 * \brief Check whether a write failed since the file was opened
+			 *
+			 * \return true if the writer drops what it is given
+			 */
+			bool hasFailed() const;
+
+			/**
+			 * \brief Write the buffers in flight then some bytes, from a fatal signal handler
+			 *
+			 * Buffers in flight are written again at their offset, which is
+			 * harmless if the background write already happened, so the file
+			 * is complete before the emergency drain appends to it.
+			 *
+			 * \param[in] iData bytes to write after everything queued
+			 * \param[in] iSize number of bytes
+			 */
+			void emergencyWrite(const char* iData, std::size_t iSize);
+
+			/**
+			 * \brief Check which back end writes
+			 *
+			 * \return true for io_uring, false for the thread pool
+			 */
+			bool isUring() const;
+
+		private:
+			struct Buffer;
+			struct Ring;
+
+			static Ring* CreateRing(unsigned int iEntries);
+			static void DestroyRing(Ring* iRing);
+
+			unsigned int acquire();
+			bool isFree(unsigned int iIndex) const;
+			void waitFree(unsigned int iIndex);
+			void submit(unsigned int iIndex);
+			void complete(unsigned int iIndex, long long iResult);
+			bool reap(bool iWait);
+			void fail(const Buffer& iBuffer, int iError);
+			void loopWrite();
+
+			Buffer* _buffers; ///< ring of buffers, free or in flight
+			unsigned int _count; ///< number of buffers
+			int _descriptor; ///< output file, not opened for appending
+			unsigned long long _offset; ///< file offset of the next write
+			std::atomic<unsigned long long> _failedOffset; ///< first byte a failed write left out, ~0 if none
+			Ring* _ring; ///< io_uring, NULL when the thread pool writes
+			std::mutex _mutex; ///< protects _jobs and the completion of pool writes
+			std::condition_variable _jobCondition; ///< notified when a job is queued or on closure
+			std::condition_variable _doneCondition; ///< notified when a pool write completes
+			std::deque<unsigned int> _jobs; ///< buffers waiting for a pool thread
+			std::vector<std::thread> _threads; ///< pool threads, empty with io_uring
+			bool _closing; ///< pool threads must stop
+		};
+    }
+}
+
+#endif
@@ -0,0 +1,183 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+
+/**
+ * \file evolve/log/binaryfileloggerreporter.h
+ * \brief evolve/log compact binary file reporter and reader header file
+ * \author
+ *
+ */
+
+#ifndef EVOLVE_BINARY_FILE_LOGGER_REPORTER_H
+#define EVOLVE_BINARY_FILE_LOGGER_REPORTER_H
+
+#include <evolve/log/loggerreporter.h>
+#include <evolve/log/export.h>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Magic bytes starting each logging session in a binary log file
+ */
+#define EVOLVE_BINARY_LOG_MAGIC "EVLOGBIN"
+
+/**
+ * Binary log format version, written after the magic bytes
+ */
+#define EVOLVE_BINARY_LOG_VERSION 1
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		/**
+		 * \brief Record types of the binary log format
+		 *
+		 * A session starts with EVOLVE_BINARY_LOG_MAGIC and a 32 bits version.
+		 * It is followed by records, each starting with its type byte:
+		 * - BINARY_RECORD_STRING: u32 id, u16 length, characters
+		 *   (interned file and function names, ids restart at 0 on each session)
+		 * - BINARY_RECORD_MESSAGE: u64 time (ns since epoch, UTC), u8 level,
+		 *   u32 file id, u32 function id, u32 line, u32 thread index,
+		 *   u64 thread id hash, u32 payload length, payload characters
+		 *
+		 * Values are stored in native byte order.
+		 */
+		enum BinaryLogRecordType {
+			BINARY_RECORD_STRING = 1,
+			BINARY_RECORD_MESSAGE = 2,
+		};
+
+		/**
+		 * \brief Decoded message record
+		 */
+		struct BinaryLogRecord {
+			unsigned long long _time; ///< nanoseconds since epoch (UTC)
+			LogLevel _level;
+			std::string _file;
+			std::string _func;
+			unsigned int _line;
+			unsigned int _threadIndex; ///< small thread index of the producer
+			unsigned long long _threadId; ///< hash of the producer std::thread::id
+			std::string _message;
+		};
+
+        /**
+         * \brief Binary file output reporter
+         *
+         * Writes fixed layout records instead of formatted text: no padding,
+         * no level string lookup, file and function names written only once.
+         * Use evolve_logdecode to turn the file back into text.
+         */
+        class EVOLVE_LOG_EXPORT BinaryFileLoggerReporter : public FileLoggerReporter {
+        public:
+            /**
+             * \brief Constructor with output file path
+             *
+             * \param[in] iFile complete file path, a new session is appended to existing files
+             * \param[in] iPolicy when buffered records are written to the file
+             */
+            BinaryFileLoggerReporter(const char* iFile, const FileFlushPolicy& iPolicy = FileFlushPolicy::Always());
+
+            /**
+             * \brief Destructor
+             */
+			virtual ~BinaryFileLoggerReporter();
+
+			/**
+			 * \brief No text lines in a binary file, only the pending records are written
+			 *
+			 * \return -1
+			 */
+			virtual int getEmergencyDescriptor() const;
+
+		protected:
+			/**
+			 * \brief Append the binary record of one message
+			 *
+			 * \param[in] iLogMessage the message to log
+			 * \param[in,out] ioBuffer pending output
+			 */
+			virtual void appendLogMessage(const LogMessage& iLogMessage, std::string& ioBuffer);
+
+        private:
+			unsigned int intern(const char* iString, std::string& ioBuffer);
+
+			std::unordered_map<const char*, unsigned int> _stringIds; ///< interned file and function names
+        };
+
+        /**
+         * \brief Sequential reader of binary log files
+         */
+		class EVOLVE_LOG_EXPORT BinaryLogReader {
+		public:
+			/**
+			 * \brief Constructor with input file path
+			 *
+			 * \param[in] iFile complete file path
+			 */
+			explicit BinaryLogReader(const char* iFile);
+
+			/**
+			 * \brief Destructor
+			 */
+			~BinaryLogReader();
+
+			/**
+			 * \brief Check if the file could be opened
+			 *
+			 * \return true if the file is open
+			 */
+			bool isOpen() const;
+
+			/**
+			 * \brief Read the next message record
+			 *
+			 * \param[out] oRecord the decoded record
+			 * \return false at end of file or on a corrupted record
+			 */
+			bool next(BinaryLogRecord& oRecord);
+
+		private:
+			template <class T>
+			bool read(T& oValue) {
+				return static_cast<bool>(_stream.read(reinterpret_cast<char*>(&oValue), sizeof(T)));
+			}
+			bool readString(std::string& oString, std::size_t iLength);
+			const std::string& lookup(unsigned int iId) const;
+
+			std::ifstream _stream; ///< input file stream
+			std::vector<std::string> _strings; ///< interned strings of the current session
+		};
+    }
+}
+
+#endif
@@ -0,0 +1,136 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/emergencywriter.h
+ * \brief evolve/log allocation free log line writer for fatal signal handlers
+ * \author
+ *
+ */
+
+#ifndef EVOLVE_EMERGENCY_WRITER_H
+#define EVOLVE_EMERGENCY_WRITER_H
+
+#include <evolve/log/logger.h>
+#include <evolve/log/export.h>
+#include <evolve/utils/clock.h>
+#include <evolve/utils/spscringbuffer.h>
+#include <cstddef>
+
+/**
+ * Size of the line buffer of the emergency writer, longer lines are truncated
+ */
+#ifndef EVOLVE_LOG_EMERGENCY_LINE_SIZE
+#define EVOLVE_LOG_EMERGENCY_LINE_SIZE 4096
+#endif
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		/**
+		 * \brief Writes log messages straight to a file descriptor
+		 *
+		 * Used when the process is about to die: nothing is allocated, no lock
+		 * is taken and only async-signal-safe system calls are made, so it can
+		 * run in a signal handler. Lines follow the default layout without the
+		 * column padding; deferred arguments and fields are rendered by hand.
+		 */
+		class EVOLVE_LOG_EXPORT EmergencyWriter {
+		public:
+			/**
+			 * \brief Constructor
+			 */
+			EmergencyWriter();
+
+			/**
+			 * \brief Format a message and write it as one line
+			 *
+			 * \param[in] iLogMessage the message
+			 * \param[in] iDescriptor output file descriptor
+			 */
+			void write(const LogMessage& iLogMessage, int iDescriptor);
+
+			/**
+			 * \brief Pop one message without freeing anything
+			 *
+			 * The message is moved into fresh storage each time and never
+			 * destroyed: the text it owns is leaked instead of freed.
+			 *
+			 * \param[in,out] ioQueue queue to pop from, may still have a consumer thread
+			 * \return the popped message, valid until the next call, NULL if the queue is empty
+			 */
+			const LogMessage* pop(evolve::utils::SpscRingBuffer<LogMessage>& ioQueue);
+
+			/**
+			 * \brief Write all bytes, retrying on partial writes and interruptions
+			 *
+			 * \param[in] iDescriptor output file descriptor, ignored if negative
+			 * \param[in] iData bytes to write
+			 * \param[in] iSize number of bytes
+			 * \return false if the descriptor refused the data
+			 */
+			static bool Write(int iDescriptor, const char* iData, std::size_t iSize);
+
+			/**
+			 * \brief Open a file for appending, next to a stream already writing it
+			 *
+			 * \param[in] iPath complete file path
+			 * \return file descriptor, -1 on error
+			 */
+			static int Open(const char* iPath);
+
+			/**
+			 * \brief Close a descriptor returned by Open()
+			 *
+			 * \param[in] iDescriptor file descriptor, ignored if negative
+			 */
+			static void Close(int iDescriptor);
+
+			/**
+			 * \brief Sleep without touching the C++ runtime
+			 *
+			 * \param[in] iMilliseconds sleep duration
+			 */
+			static void Sleep(unsigned int iMilliseconds);
+
+		private:
+			void append(const char* iText, std::size_t iLength);
+			void append(const char* iText);
+			void appendNumber(unsigned long long iValue);
+			void appendArgument(const LogArgument& iArgument);
+
+			evolve::utils::Clock _clock; ///< timestamp formatting, caches the current second
+			alignas(LogMessage) unsigned char _message[sizeof(LogMessage)]; ///< storage of the last popped message
+			std::size_t _size; ///< bytes used in _line
+			char _line[EVOLVE_LOG_EMERGENCY_LINE_SIZE]; ///< line being built
+		};
+    }
+}
+
+#endif
@@ -0,0 +1,142 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/flightrecorder.h
+ * \brief evolve/log per-thread in-memory flight recorder
+ * \author
+ *
+ */
+
+#ifndef EVOLVE_FLIGHT_RECORDER_H
+#define EVOLVE_FLIGHT_RECORDER_H
+
+#include <evolve/log/logger.h>
+#include <evolve/log/export.h>
+#include <cstddef>
+
+/**
+ * Default memory of the flight recorder of each thread, in bytes
+ */
+#ifndef EVOLVE_LOG_FLIGHT_RECORDER_SIZE
+#define EVOLVE_LOG_FLIGHT_RECORDER_SIZE (64 << 10)
+#endif
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		/**
+		 * \brief Always-on record of the last messages of each thread, dumped on failure
+		 *
+		 * Once enabled, every message at or above the recorder level is copied,
+		 * in binary form, into a fixed-size circular buffer owned by the calling
+		 * thread: deferred messages (EVOLVE_LOGF) are recorded even when the
+		 * runtime level keeps them away from the reporters, and cost a copy of
+		 * their raw arguments only. Streamed messages are recorded when they are
+		 * logged, their text truncated to EVOLVE_LOG_INLINE_TEXT_SIZE - 1 bytes;
+		 * structured fields are not kept.
+		 *
+		 * Nothing is written until a dump: on request (Dump), when a
+		 * LEVEL_CRITICAL message is logged and from the crash handler (see
+		 * Logger::InstallCrashHandler). Dumps merge the threads in timestamp
+		 * order; they allocate nothing and take no lock, so they are safe in a
+		 * signal handler. Automatic dumps only write the records not written by
+		 * a previous automatic dump.
+		 *
+		 * Recorders of exited threads are kept with their records, a thread
+		 * taking the same index later records into the same buffer. Threads
+		 * without an index, past EVOLVE_THREAD_REGISTRY_SIZE living ones, are not recorded.
+		 */
+		class EVOLVE_LOG_EXPORT FlightRecorder {
+		public:
+			/**
+			 * \brief Start recording
+			 *
+			 * \param[in] iLevel minimum level recorded
+			 * \param[in] iSize memory of each thread recorder, for threads not recording yet
+			 */
+			static void Enable(LogLevel iLevel = LEVEL_DEBUG, std::size_t iSize = EVOLVE_LOG_FLIGHT_RECORDER_SIZE);
+
+			/**
+			 * \brief Stop recording, recorded messages are kept
+			 */
+			static void Disable();
+
+			/**
+			 * \brief Set where automatic dumps are written, standard error by default
+			 *
+			 * \param[in] iPath file appended to, NULL to go back to standard error
+			 * \return false if the file can't be opened
+			 */
+			static bool SetDumpFile(const char* iPath);
+
+			/**
+			 * \brief Write every recorded message, oldest first
+			 *
+			 * \param[in] iDescriptor output file descriptor
+			 * \param[in] iReason written in the dump header
+			 * \return number of written messages
+			 */
+			static std::size_t Dump(int iDescriptor, const char* iReason);
+
+			/**
+			 * \brief Append every recorded message to a file, oldest first
+			 *
+			 * \param[in] iPath file appended to
+			 * \param[in] iReason written in the dump header
+			 * \return number of written messages
+			 */
+			static std::size_t Dump(const char* iPath, const char* iReason);
+
+			/**
+			 * \brief Write the messages recorded since the previous automatic dump to the dump file
+			 *
+			 * Called when a critical message is logged and by the crash handler.
+			 *
+			 * \param[in] iReason written in the dump header
+			 * \return number of written messages
+			 */
+			static std::size_t DumpAutomatic(const char* iReason);
+
+			/**
+			 * \brief Record a message in the buffer of the calling thread
+			 *
+			 * Called through Logger::Record and Logger::log, the level is not checked again.
+			 *
+			 * \param[in] iLogMessage the message, from the calling thread
+			 */
+			static void Record(const LogMessage& iLogMessage);
+
+		private:
+			static std::size_t Dump(int iDescriptor, const char* iReason, bool iNewOnly);
+		};
+    }
+}
+
+#endif
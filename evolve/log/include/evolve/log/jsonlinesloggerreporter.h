@@ -0,0 +1,97 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/jsonlinesloggerreporter.h
+ * \brief evolve/log JSON lines file reporter header file
+ * \author
+ *
+ */
+
+#ifndef EVOLVE_JSON_LINES_LOGGER_REPORTER_H
+#define EVOLVE_JSON_LINES_LOGGER_REPORTER_H
+
+#include <evolve/log/loggerreporter.h>
+#include <evolve/log/export.h>
+#include <evolve/utils/clock.h>
+#include <string>
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		/**
+		 * \brief JSON lines output reporter
+		 *
+		 * Writes one JSON object per message and per line, with the structured
+		 * fields in a nested "fields" object:
+		 * {"time":"...","time_ns":...,"level":"INFO","thread":0,"file":"...","line":1,
+		 *  "func":"...","message":"...","fields":{"frame":12,"cpu_ms":3.5}}
+		 *
+		 * The encoder writes straight into the reporter's pending buffer, so
+		 * nothing is allocated once the buffer has reached its working size.
+		 */
+		class EVOLVE_LOG_EXPORT JsonLinesLoggerReporter : public FileLoggerReporter {
+		public:
+			/**
+			 * \brief Constructor with output file path
+			 *
+			 * \param[in] iFile complete file path
+			 * \param[in] iPolicy when buffered lines are written to the file
+			 */
+			JsonLinesLoggerReporter(const char* iFile, const FileFlushPolicy& iPolicy = FileFlushPolicy::Always());
+
+			/**
+			 * \brief Destructor
+			 */
+			virtual ~JsonLinesLoggerReporter();
+
+			/**
+			 * \brief No plain text lines in a JSON lines file, only the pending lines are written
+			 *
+			 * \return -1
+			 */
+			virtual int getEmergencyDescriptor() const;
+
+		protected:
+			/**
+			 * \brief Append the JSON object of one message and a new line
+			 *
+			 * \param[in] iLogMessage the message to log
+			 * \param[in,out] ioBuffer pending output
+			 */
+			virtual void appendLogMessage(const LogMessage& iLogMessage, std::string& ioBuffer);
+
+		private:
+			evolve::utils::Clock _jsonClock; ///< formats the "time" member, microsecond precision
+			std::string _threadName; ///< reusable thread name
+		};
+    }
+}
+
+#endif
@@ -32,6 +32,20 @@
 #define EVOLVE_LOG_H
 
 #include <evolve/log/logger.h>
+#include <evolve/log/loglayout.h>
+#include <evolve/log/logtext.h>
+#include <evolve/log/logindex.h>
 #include <evolve/log/loggerreporter.h>
+#include <evolve/log/loggersink.h>
+#include <evolve/log/emergencywriter.h>
+#include <evolve/log/asyncfilewriter.h>
+#include <evolve/log/logsuppressor.h>
+#include <evolve/log/logsampler.h>
+#include <evolve/log/flightrecorder.h>
+#include <evolve/log/binaryfileloggerreporter.h>
+#include <evolve/log/jsonlinesloggerreporter.h>
+#include <evolve/log/mappedfileloggerreporter.h>
+#include <evolve/log/rotatingfileloggerreporter.h>
+#include <evolve/log/sharedmemoryloggerreporter.h>
 
 #endif
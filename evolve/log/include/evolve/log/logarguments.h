@@ -0,0 +1,216 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+
+/**
+ * \file evolve/log/logarguments.h
+ * \brief evolve/log raw argument capture for deferred formatting
+ * \author
+ *
+ */
+
+#ifndef EVOLVE_LOG_ARGUMENTS_H
+#define EVOLVE_LOG_ARGUMENTS_H
+
+#include <evolve/log/export.h>
+#include <evolve/log/logtext.h>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+/**
+ * Number of bytes available to store the raw arguments of one message
+ */
+#ifndef EVOLVE_LOG_ARGUMENTS_SIZE
+#define EVOLVE_LOG_ARGUMENTS_SIZE 128
+#endif
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		/**
+		 * \brief Type tag stored before each raw argument
+		 */
+		enum LogArgumentType {
+			ARGUMENT_INT,
+			ARGUMENT_UINT,
+			ARGUMENT_DOUBLE,
+			ARGUMENT_BOOL,
+			ARGUMENT_CHAR,
+			ARGUMENT_POINTER,
+			ARGUMENT_STRING,
+		};
+
+		/**
+		 * \brief One decoded argument, strings point into the LogArguments storage
+		 */
+		struct LogArgument {
+			LogArgumentType _type; ///< which member holds the value
+			union {
+				long long _int; ///< ARGUMENT_INT
+				unsigned long long _uint; ///< ARGUMENT_UINT
+				double _double; ///< ARGUMENT_DOUBLE
+				bool _bool; ///< ARGUMENT_BOOL
+				char _char; ///< ARGUMENT_CHAR
+				const void* _pointer; ///< ARGUMENT_POINTER
+			};
+			const char* _string; ///< ARGUMENT_STRING, not null terminated
+			std::size_t _length; ///< ARGUMENT_STRING length
+		};
+
+		/**
+		 * \brief Compact record of raw log arguments
+		 *
+		 * The call site only copies the argument bytes (integers, floating point
+		 * values, pointers and small strings) in a fixed inline buffer.
+		 * The text is built later, on the logger thread, by format().
+		 * Strings are copied (up to 255 bytes) since the pointed memory may not
+		 * outlive the call. Arguments not fitting in the buffer are dropped and
+		 * rendered as "...".
+		 */
+		class EVOLVE_LOG_EXPORT LogArguments {
+		public:
+			/**
+			 * \brief Default constructor
+			 */
+			LogArguments()
+				:_size(0), _truncated(false) {}
+
+			/**
+			 * \brief Capture the raw bytes of all arguments
+			 *
+			 * \param[in] iArgs arguments to capture
+			 */
+			template <class... TArgs>
+			void pack(const TArgs&... iArgs) {
+				int aUnused[] = { 0, (write(iArgs), 0)... };
+				(void)aUnused;
+			}
+
+			/**
+			 * \brief Build the text of a deferred message
+			 *
+			 * Each "{}" in the format is replaced by the next captured argument.
+			 *
+			 * \param[in] iFormat static format string
+			 * \param[out] oText the formatted text
+			 */
+			void format(const char* iFormat, LogText& oText) const;
+
+			/**
+			 * \brief Decode the next captured argument
+			 *
+			 * \param[in,out] ioOffset read position, 0 for the first argument
+			 * \param[out] oArgument the decoded argument
+			 * \return false once all arguments have been read
+			 */
+			bool read(std::size_t& ioOffset, LogArgument& oArgument) const;
+
+			/**
+			 * \brief Remove all captured arguments
+			 */
+			void clear() {
+				_size = 0;
+				_truncated = false;
+			}
+
+			/**
+			 * \brief Check if some arguments did not fit
+			 *
+			 * \return true if arguments have been dropped
+			 */
+			bool isTruncated() const {
+				return _truncated;
+			}
+
+		private:
+			friend class LogFields;
+
+			void write(bool iValue) { writeScalar(ARGUMENT_BOOL, iValue); }
+			void write(char iValue) { writeScalar(ARGUMENT_CHAR, iValue); }
+			void write(signed char iValue) { writeScalar(ARGUMENT_INT, static_cast<long long>(iValue)); }
+			void write(unsigned char iValue) { writeScalar(ARGUMENT_UINT, static_cast<unsigned long long>(iValue)); }
+			void write(short iValue) { writeScalar(ARGUMENT_INT, static_cast<long long>(iValue)); }
+			void write(unsigned short iValue) { writeScalar(ARGUMENT_UINT, static_cast<unsigned long long>(iValue)); }
+			void write(int iValue) { writeScalar(ARGUMENT_INT, static_cast<long long>(iValue)); }
+			void write(unsigned int iValue) { writeScalar(ARGUMENT_UINT, static_cast<unsigned long long>(iValue)); }
+			void write(long iValue) { writeScalar(ARGUMENT_INT, static_cast<long long>(iValue)); }
+			void write(unsigned long iValue) { writeScalar(ARGUMENT_UINT, static_cast<unsigned long long>(iValue)); }
+			void write(long long iValue) { writeScalar(ARGUMENT_INT, iValue); }
+			void write(unsigned long long iValue) { writeScalar(ARGUMENT_UINT, iValue); }
+			void write(float iValue) { writeScalar(ARGUMENT_DOUBLE, static_cast<double>(iValue)); }
+			void write(double iValue) { writeScalar(ARGUMENT_DOUBLE, iValue); }
+			void write(const void* iValue) { writeScalar(ARGUMENT_POINTER, iValue); }
+			void write(const char* iValue) { writeString(iValue, iValue != NULL ? std::strlen(iValue) : 0); }
+			void write(char* iValue) { write(static_cast<const char*>(iValue)); }
+			void write(const std::string& iValue) { writeString(iValue.data(), iValue.size()); }
+
+			template <class T>
+			void write(T* iValue) { writeScalar(ARGUMENT_POINTER, static_cast<const void*>(iValue)); }
+
+			template <class T>
+			typename std::enable_if<std::is_enum<T>::value>::type write(T iValue) {
+				writeScalar(ARGUMENT_INT, static_cast<long long>(iValue));
+			}
+
+			template <class T>
+			void writeScalar(LogArgumentType iType, const T& iValue) {
+				if (_size + 1 + sizeof(T) > EVOLVE_LOG_ARGUMENTS_SIZE) {
+					_truncated = true;
+					return;
+				}
+				_data[_size] = static_cast<unsigned char>(iType);
+				std::memcpy(_data + _size + 1, &iValue, sizeof(T));
+				_size = static_cast<unsigned short>(_size + 1 + sizeof(T));
+			}
+
+			void writeString(const char* iValue, std::size_t iLength) {
+				if (_size + 2 > EVOLVE_LOG_ARGUMENTS_SIZE) {
+					_truncated = true;
+					return;
+				}
+				const std::size_t aAvailable = EVOLVE_LOG_ARGUMENTS_SIZE - _size - 2;
+				std::size_t aLength = iLength < 255 ? iLength : 255;
+				if (aLength > aAvailable) {
+					aLength = aAvailable;
+				}
+				_data[_size] = static_cast<unsigned char>(ARGUMENT_STRING);
+				_data[_size + 1] = static_cast<unsigned char>(aLength);
+				std::memcpy(_data + _size + 2, iValue, aLength);
+				_size = static_cast<unsigned short>(_size + 2 + aLength);
+			}
+
+			unsigned char _data[EVOLVE_LOG_ARGUMENTS_SIZE]; ///< tagged raw argument bytes
+			unsigned short _size; ///< used bytes in _data
+			bool _truncated; ///< some arguments did not fit in _data
+		};
+    }
+}
+
+#endif
@@ -0,0 +1,165 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/logfields.h
+ * \brief evolve/log structured key/value fields header file
+ * \author
+ *
+ */
+
+#ifndef EVOLVE_LOG_FIELDS_H
+#define EVOLVE_LOG_FIELDS_H
+
+#include <evolve/log/export.h>
+#include <evolve/log/logarguments.h>
+#include <cstddef>
+
+/**
+ * Maximum number of key/value fields of one message
+ */
+#ifndef EVOLVE_LOG_FIELDS_COUNT
+#define EVOLVE_LOG_FIELDS_COUNT 8
+#endif
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		/**
+		 * \brief One decoded field
+		 */
+		struct LogField {
+			const char* _key; ///< static key
+			LogArgument _value; ///< typed value
+		};
+
+		/**
+		 * \brief Typed key/value fields of a structured message
+		 *
+		 * Keys are static strings, only their pointer is stored; values are kept
+		 * in their binary form, with the same encoding as deferred arguments.
+		 * Fields not fitting are dropped.
+		 */
+		class EVOLVE_LOG_EXPORT LogFields {
+		public:
+			/**
+			 * \brief Default constructor
+			 */
+			LogFields()
+				:_keys(), _count(0), _values() {}
+
+			/**
+			 * \brief Capture key/value pairs
+			 *
+			 * \param[in] iKey static key of the first field
+			 * \param[in] iValue value of the first field
+			 * \param[in] iOthers following keys and values, alternated
+			 */
+			template <class T, class... TOthers>
+			void pack(const char* iKey, const T& iValue, const TOthers&... iOthers) {
+				add(iKey, iValue);
+				pack(iOthers...);
+			}
+
+			/**
+			 * \brief End of pack() recursion
+			 */
+			void pack() {}
+
+			/**
+			 * \brief Capture one key/value pair
+			 *
+			 * \param[in] iKey static key, must outlive the logger
+			 * \param[in] iValue value
+			 * \return this, to chain calls
+			 */
+			template <class T>
+			LogFields& add(const char* iKey, const T& iValue) {
+				if (_count >= EVOLVE_LOG_FIELDS_COUNT) {
+					return *this;
+				}
+				const unsigned short aSize = _values._size;
+				_values.write(iValue);
+				if (_values._size != aSize) {
+					_keys[_count++] = iKey;
+				}
+				return *this;
+			}
+
+			/**
+			 * \brief Decode the next field
+			 *
+			 * \param[in,out] ioIndex field index, 0 for the first field
+			 * \param[in,out] ioOffset value read position, 0 for the first field
+			 * \param[out] oField the decoded field
+			 * \return false once all fields have been read
+			 */
+			bool read(std::size_t& ioIndex, std::size_t& ioOffset, LogField& oField) const {
+				if (ioIndex >= _count || !_values.read(ioOffset, oField._value)) {
+					return false;
+				}
+				oField._key = _keys[ioIndex++];
+				return true;
+			}
+
+			/**
+			 * \brief Get the number of fields
+			 *
+			 * \return field count
+			 */
+			std::size_t size() const {
+				return _count;
+			}
+
+			/**
+			 * \brief Check if there is no field
+			 *
+			 * \return true if there is no field
+			 */
+			bool empty() const {
+				return _count == 0;
+			}
+
+			/**
+			 * \brief Remove all fields
+			 */
+			void clear() {
+				_count = 0;
+				_values.clear();
+			}
+
+		private:
+			const char* _keys[EVOLVE_LOG_FIELDS_COUNT]; ///< static keys
+			unsigned char _count; ///< number of fields
+			LogArguments _values; ///< tagged raw values
+		};
+    }
+}
+
+#endif
@@ -32,10 +32,79 @@
 #define EVOLVE_LOGGER_H
 
 #include <evolve/utils/singleton.h>
-#include <evolve/utils/waitqueue.h>
+#include <evolve/utils/spscringbuffer.h>
+#include <evolve/utils/clock.h>
+#include <evolve/utils/threadutils.h>
 #include <evolve/log/export.h>
+#include <evolve/log/logarguments.h>
+#include <evolve/log/logfields.h>
+#include <evolve/log/logtext.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <sstream>
 #include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * Default number of pending messages each logging thread's staging buffer can hold
+ */
+#ifndef EVOLVE_LOG_QUEUE_CAPACITY
+#define EVOLVE_LOG_QUEUE_CAPACITY 1024
+#endif
+
+/**
+ * Maximum number of messages the logger thread hands to the reporter at once
+ */
+#ifndef EVOLVE_LOG_BATCH_SIZE
+#define EVOLVE_LOG_BATCH_SIZE 1024
+#endif
+
+/**
+ * Default number of pending messages a reporter queue can hold before new ones are dropped
+ */
+#ifndef EVOLVE_LOG_SINK_CAPACITY
+#define EVOLVE_LOG_SINK_CAPACITY 8192
+#endif
+
+/**
+ * Default time a fatal signal handler may spend draining the log, in milliseconds
+ */
+#ifndef EVOLVE_LOG_EMERGENCY_TIMEOUT_MS
+#define EVOLVE_LOG_EMERGENCY_TIMEOUT_MS 500
+#endif
+
+/**
+ * Size of the alternate stack the crash handler runs on, so a stack overflow can be drained
+ */
+#ifndef EVOLVE_LOG_CRASH_STACK_SIZE
+#define EVOLVE_LOG_CRASH_STACK_SIZE 65536
+#endif
+
+/**
+ * Maximum number of reporters reached by the emergency drain
+ */
+#ifndef EVOLVE_LOG_EMERGENCY_REPORTERS
+#define EVOLVE_LOG_EMERGENCY_REPORTERS 16
+#endif
+
+/**
+ * Maximum number of log channels, the default one included
+ */
+#ifndef EVOLVE_LOG_MAX_CHANNELS
+#define EVOLVE_LOG_MAX_CHANNELS 64
+#endif
+
+/**
+ * Maximum length of a channel name, longer names are truncated
+ */
+#ifndef EVOLVE_LOG_CHANNEL_NAME_SIZE
+#define EVOLVE_LOG_CHANNEL_NAME_SIZE 32
+#endif
 
 /**
  * Namespace for all evolve classes
@@ -58,15 +127,51 @@ namespace evolve {
 			LEVEL_OFF,
 		};
 
+		/**
+		* \brief What happens when a bounded queue of the pipeline is full
+		*
+		* Chosen for the staging buffers of the logging threads with
+		* Logger::setOverflowPolicy, and for each reporter queue when the
+		* reporter is attached, see Logger::attachReporter.
+		*/
+		enum LogOverflowPolicy {
+			OVERFLOW_BLOCK = 0, ///< wait for the consumer: no message is dropped, but on a reporter queue the logger thread waits for that reporter and holds up all the others
+			OVERFLOW_DROP_NEWEST, ///< drop the message being logged
+			OVERFLOW_DROP_OLDEST, ///< overwrite the oldest pending message
+			OVERFLOW_SAMPLE, ///< past half capacity keep one message out of N below LEVEL_ERROR, then drop the newest
+		};
+
+		/**
+		* \brief Compact identifier of a named log channel, see Logger::RegisterChannel
+		*/
+		typedef unsigned short LogChannel;
+
+		/**
+		* \brief Channel of the messages logged without one, its level is the global level
+		*/
+		static const LogChannel CHANNEL_DEFAULT = 0;
+
         class LoggerReporter;
+        class LoggerSink;
+        struct LoggerSinkStatistics;
 
 		struct LogMessage {
+			LogMessage()
+				:_level(LEVEL_OFF), _time(0), _message(), _file(NULL), _line(0), _func(NULL), _threadId(), _threadIndex(0),
+				 _channel(CHANNEL_DEFAULT), _format(NULL), _arguments(), _fields() {}
+
 			LogLevel _level;
-			std::string _message;
+			unsigned long long _time; ///< nanoseconds since epoch (UTC), taken on the calling thread
+			LogText _message; ///< message text, built on the logger thread for deferred messages
 			const char* _file;
 			unsigned int _line;
 			const char* _func;
 			std::thread::id _threadId;
+			unsigned int _threadIndex; ///< dense index of the calling thread, see evolve::utils::GetCurrentThreadIndex
+			LogChannel _channel; ///< channel the message was logged on
+			const char* _format; ///< static format string of a deferred message, NULL otherwise
+			LogArguments _arguments; ///< raw arguments of a deferred message
+			LogFields _fields; ///< typed key/value fields of a structured message
 		};
 
         /**
@@ -74,6 +179,11 @@ namespace evolve {
          *
          * Must be used with log macros (EVOLVE_ATTACH_LOGGER_REPORTER,
          * EVOLVE_LOG_DEBUG, EVOLVE_LOG_INFO, EVOLVE_LOG_WARNING, EVOLVE_LOG_ERROR)
+         *
+         * Each logging thread pushes into its own single-producer staging buffer,
+         * registered on its first message, so producers never contend with each
+         * other. The logger thread polls every buffer and merges what it drained
+         * in timestamp order before handing it to the reporter.
          */
         class EVOLVE_LOG_EXPORT Logger : public evolve::utils::UniqueSingleton<Logger> {
 			SINGLETON_DECL(UniqueSingleton, Logger)
@@ -81,13 +191,61 @@ namespace evolve {
 				friend std::thread;
         public:
             /**
-             * \brief Attach a specific reporter
+             * \brief Attach a reporter, next to the already attached ones
              *
-             * Please attach the reporter you need at beginning of main function
+             * Please attach the reporters you need at beginning of main function.
+             * Each reporter is fed by its own queue and thread, so a slow one
+             * does not hold up the others, unless its queue uses OVERFLOW_BLOCK.
+             * The logger owns the reporter.
              *
              * \param[in] iReporter The reporter to attach
+             * \param[in] iLevel minimum level delivered to this reporter
+             * \param[in] iCapacity pending messages for this reporter before the overflow policy applies
+             * \param[in] iPolicy what happens when this reporter queue is full
+             * \param[in] iSampleRate for OVERFLOW_SAMPLE, one message kept out of iSampleRate
              */
-            void attachReporter(LoggerReporter* iReporter);
+            void attachReporter(LoggerReporter* iReporter, LogLevel iLevel = LEVEL_DEBUG,
+				std::size_t iCapacity = EVOLVE_LOG_SINK_CAPACITY, LogOverflowPolicy iPolicy = OVERFLOW_DROP_NEWEST,
+				unsigned int iSampleRate = 16);
+
+			/**
+			 * \brief Detach a reporter, delivering its pending messages first
+			 *
+			 * \param[in] iReporter The reporter to detach and delete
+			 */
+			void detachReporter(LoggerReporter* iReporter);
+
+			/**
+			 * \brief Get the delivery counters of an attached reporter
+			 *
+			 * \param[in] iReporter The attached reporter
+			 * \param[out] oStatistics delivered and dropped message counts
+			 * \return false if the reporter is not attached
+			 */
+			bool getStatistics(const LoggerReporter* iReporter, LoggerSinkStatistics& oStatistics);
+
+			/**
+			 * \brief Bound the staging buffers and choose what happens when one is full
+			 *
+			 * The reporter queues have their own policy, see attachReporter.
+			 * The capacity applies to the threads logging for the first time after
+			 * the call, so call it at beginning of main function. The memory used by
+			 * pending messages is bounded by the number of logging threads times
+			 * iCapacity, plus the capacity of each reporter queue.
+			 *
+			 * \param[in] iPolicy overflow policy
+			 * \param[in] iCapacity pending messages per logging thread
+			 * \param[in] iSampleRate for OVERFLOW_SAMPLE, one message kept out of iSampleRate
+			 */
+			void setOverflowPolicy(LogOverflowPolicy iPolicy, std::size_t iCapacity = EVOLVE_LOG_QUEUE_CAPACITY,
+				unsigned int iSampleRate = 16);
+
+			/**
+			 * \brief Get the number of messages dropped on full staging buffers
+			 *
+			 * \return dropped messages already accounted by the logger thread
+			 */
+			unsigned long long getDroppedCount() const;
 
             /**
              * \brief Log a debug message
@@ -96,8 +254,239 @@ namespace evolve {
              */
 			void log(const LogMessage& iLogMessage);
 
+			/**
+			 * \brief Log a message by moving it into the staging buffer
+			 *
+			 * \param[in,out] ioLogMessage the message to log, left empty
+			 */
+			void log(LogMessage&& ioLogMessage);
+
+			/**
+			 * \brief Wait until the reporters have written what was logged before the call
+			 *
+			 * Messages of the calling thread are handed to every reporter, then
+			 * each reporter is flushed by its own thread.
+			 *
+			 * \param[in] iTimeoutMs maximum wait
+			 * \return false if the timeout expired first
+			 */
+			bool sync(unsigned int iTimeoutMs);
+
+			/**
+			 * \brief Sync before a critical exception is thrown, if enabled by SetCriticalSyncTimeout
+			 */
+			void syncCritical();
+
+			/**
+			 * \brief Last chance drain, called from a fatal signal handler
+			 *
+			 * First lets the logger and reporter threads deliver and flush, as
+			 * sync() does, without taking any lock. Once iTimeoutMs has expired,
+			 * or right away if the calling thread is one of them, whatever is
+			 * still pending is written straight to the reporter descriptors by
+			 * an EmergencyWriter, racing with threads that may still run: output
+			 * may then be interleaved, but nothing is allocated or locked.
+			 * Reporters without descriptor only get their own buffer written.
+			 *
+			 * \param[in] iTimeoutMs maximum time left to the logger and reporter threads
+			 * \param[in] iReason static text logged last as a critical message, may be NULL
+			 * \return true if the threads delivered everything in time
+			 */
+			bool emergencyDrain(unsigned int iTimeoutMs, const char* iReason);
+
+			/**
+			 * \brief Drain the log on SIGSEGV, SIGABRT and SIGBUS
+			 *
+			 * The handlers call emergencyDrain() then hand the signal back to
+			 * the previous handler (the default one ends the process). They run
+			 * on an alternate stack, so a stack overflow can be drained too: the
+			 * calling thread, the logger threads and every thread logging for
+			 * the first time afterwards get one, see InstallCrashStack().
+			 *
+			 * \param[in] iTimeoutMs maximum time spent draining
+			 */
+			static void InstallCrashHandler(unsigned int iTimeoutMs = EVOLVE_LOG_EMERGENCY_TIMEOUT_MS);
+
+			/**
+			 * \brief Give the calling thread an alternate signal stack for the crash handler
+			 *
+			 * Only needed by threads that never log, or that logged before
+			 * InstallCrashHandler(). Freed when the thread exits, does nothing if
+			 * the thread already has an alternate stack, or on Windows.
+			 */
+			static void InstallCrashStack();
+
+			/**
+			 * \brief Restore the handlers replaced by InstallCrashHandler
+			 */
+			static void UninstallCrashHandler();
+
+			/**
+			 * \brief Make EVOLVE_CRITICAL_EXCEPTION wait for its message to be written before throwing
+			 *
+			 * \param[in] iTimeoutMs maximum wait, 0 to throw right away (default)
+			 */
+			static void SetCriticalSyncTimeout(unsigned int iTimeoutMs);
+
+			/**
+			 * \brief Set the runtime level threshold
+			 *
+			 * Messages below this level are discarded at the call site, before
+			 * the message is built. Compile-time filtering (USE_EVOLVE_LOG_*)
+			 * still applies on top of it.
+			 *
+			 * \param[in] iLevel the minimum level to log
+			 */
+			static void SetLevel(LogLevel iLevel);
+
+			/**
+			 * \brief Get the runtime level threshold
+			 *
+			 * \return the minimum level to log
+			 */
+			static LogLevel GetLevel();
+
+			/**
+			 * \brief Check a level against the runtime threshold
+			 *
+			 * Only one relaxed atomic load, used by the log macros.
+			 *
+			 * \param[in] iLevel the message level
+			 * \return true if a message of this level must be logged
+			 */
+			static bool IsEnabled(LogLevel iLevel) {
+				return static_cast<int>(iLevel) >= _Level.load(std::memory_order_relaxed);
+			}
+
+			/**
+			 * \brief Register a named channel, or get the identifier of an already registered one
+			 *
+			 * A new channel follows the global level until a level is set for it.
+			 * Typically called once per subsystem, see EVOLVE_LOG_DEFINE_CHANNEL.
+			 *
+			 * \param[in] iName channel name, such as "vulkan"
+			 * \return the channel, CHANNEL_DEFAULT if EVOLVE_LOG_MAX_CHANNELS are already registered
+			 */
+			static LogChannel RegisterChannel(const char* iName);
+
+			/**
+			 * \brief Get the name of a channel
+			 *
+			 * \param[in] iChannel a registered channel
+			 * \return the channel name, "default" for CHANNEL_DEFAULT
+			 */
+			static const char* GetChannelName(LogChannel iChannel);
+
+			/**
+			 * \brief Set the runtime level threshold of one channel
+			 *
+			 * The channel no longer follows the global level. Setting the level
+			 * of CHANNEL_DEFAULT is the same as SetLevel.
+			 *
+			 * \param[in] iChannel a registered channel
+			 * \param[in] iLevel the minimum level to log on this channel
+			 */
+			static void SetChannelLevel(LogChannel iChannel, LogLevel iLevel);
+
+			/**
+			 * \brief Make a channel follow the global level again
+			 *
+			 * \param[in] iChannel a registered channel
+			 */
+			static void ResetChannelLevel(LogChannel iChannel);
+
+			/**
+			 * \brief Get the runtime level threshold of a channel
+			 *
+			 * \param[in] iChannel a registered channel
+			 * \return the minimum level to log on this channel
+			 */
+			static LogLevel GetChannelLevel(LogChannel iChannel);
+
+			/**
+			 * \brief Set channel levels from a list such as "vulkan=DEBUG,meshing=WARNING"
+			 *
+			 * Channels not registered yet are registered. The EVOLVE_LOG_CHANNELS
+			 * environment variable is applied this way on startup.
+			 *
+			 * \param[in] iLevels comma separated name=level pairs
+			 * \return false if an entry could not be parsed, the others are applied
+			 */
+			static bool SetChannelLevels(const char* iLevels);
+
+			/**
+			 * \brief Check a level against the runtime threshold of a channel
+			 *
+			 * Only one relaxed atomic load, used by the channel log macros.
+			 *
+			 * \param[in] iLevel the message level
+			 * \param[in] iChannel the message channel
+			 * \return true if a message of this level must be logged on this channel
+			 */
+			static bool IsEnabled(LogLevel iLevel, LogChannel iChannel) {
+				return static_cast<int>(iLevel) >= _ChannelLevels[iChannel].load(std::memory_order_relaxed);
+			}
+
+			/**
+			 * \brief Check a level against the flight recorder threshold
+			 *
+			 * Only one relaxed atomic load, used by the deferred log macros.
+			 *
+			 * \param[in] iLevel the message level
+			 * \return true if a message of this level must be kept by the flight recorder
+			 */
+			static bool IsRecorded(LogLevel iLevel) {
+				return static_cast<int>(iLevel) >= _RecordLevel.load(std::memory_order_relaxed);
+			}
+
+			/**
+			 * \brief Keep a message in the flight recorder of the calling thread without logging it
+			 *
+			 * Messages passed to log() are recorded there, see FlightRecorder.
+			 *
+			 * \param[in] iLogMessage the message, its level already checked by IsRecorded
+			 */
+			static void Record(const LogMessage& iLogMessage);
+
+			/**
+			 * \brief Parse a level name (DEBUG, INFO, ...) or number
+			 *
+			 * \param[in] iText the level text, case insensitive
+			 * \param[in] iDefault returned if iText is NULL or not a level
+			 * \return the parsed level
+			 */
+			static LogLevel ParseLevel(const char* iText, LogLevel iDefault);
+
+			/**
+			 * \brief Select the clock used to timestamp messages
+			 *
+			 * \param[in] iCoarse true for the cheapest, tick-resolution clock
+			 */
+			static void SetCoarseClock(bool iCoarse);
+
+			/**
+			 * \brief Timestamp a message
+			 *
+			 * \return nanoseconds since epoch (UTC)
+			 */
+			static unsigned long long Now() {
+				return evolve::utils::Clock::Now(_CoarseClock.load(std::memory_order_relaxed));
+			}
+
 			static std::vector<std::string> _LogLevelStringMap;
+			static std::atomic<int> _Level; ///< runtime threshold, initialised from EVOLVE_LOG_LEVEL
+			static std::atomic<int> _ChannelLevels[EVOLVE_LOG_MAX_CHANNELS]; ///< runtime threshold of each channel
+			static std::atomic<int> _RecordLevel; ///< flight recorder threshold, initialised from EVOLVE_LOG_RECORDER_LEVEL
+			static std::atomic<bool> _CoarseClock; ///< use the coarse clock for timestamps
+			static std::atomic<unsigned int> _CriticalSyncTimeout; ///< sync timeout before critical exceptions, 0 to disable
         private:
+			struct ThreadBuffer;
+
+			static void HandleFatalSignal(int iSignal);
+
+			static std::atomic<Logger*> _EmergencyInstance; ///< live instance, reached from signal handlers
+			static std::atomic<unsigned int> _CrashTimeout; ///< emergency drain timeout of the crash handler
+
             /**
              * \brief Default constructor
              */
@@ -108,93 +497,275 @@ namespace evolve {
              */
             ~Logger();
 
-            LoggerReporter* _reporter; ///< reporter instance
-			evolve::utils::WaitQueue<LogMessage> _logQueue;
-			std::thread _logThread;
-			bool _closureCondition;
+            std::vector<std::shared_ptr<LoggerSink> > _sinks; ///< one asynchronous sink per attached reporter
+			std::mutex _sinksMutex; ///< protects _sinks
+			std::atomic<std::size_t> _sinksVersion; ///< bumped whenever _sinks changes
+			std::vector<std::shared_ptr<LoggerSink> > _deliverySinks; ///< copy of _sinks pushed to without lock, logger thread only
+			std::size_t _deliverySinksVersion; ///< version of _deliverySinks, logger thread only
+			std::vector<std::shared_ptr<ThreadBuffer> > _buffers; ///< staging buffers of every thread that logged
+			std::mutex _buffersMutex; ///< protects _buffers
+			std::atomic<std::size_t> _buffersVersion; ///< bumped whenever _buffers changes
+			std::atomic<bool> _sleeping; ///< consumer sleeping flag
+			std::mutex _wakeMutex; ///< mutex for consumer sleep
+			std::condition_variable _wakeCondition; ///< consumer wake up condition
+			std::atomic<int> _overflowPolicy; ///< LogOverflowPolicy of the staging buffers
+			std::atomic<std::size_t> _queueCapacity; ///< capacity of new staging buffers
+			std::atomic<unsigned int> _sampleRate; ///< one message kept out of _sampleRate when sampling
+			std::atomic<unsigned long long> _droppedCount; ///< dropped messages reported so far
+			unsigned long long _nextSuppressedReport; ///< next check of LogSuppressor counts, logger thread only
+			std::atomic<unsigned long long> _syncRequested; ///< last sync request
+			std::atomic<unsigned long long> _syncForwarded; ///< last sync request handed to the sinks
+			std::atomic<bool> _emergency; ///< set by the first emergency drain, nothing is freed anymore
+			std::atomic<bool> _emergencyDone; ///< set once the emergency drain completed
+			std::atomic<ThreadBuffer*> _emergencyBuffers[EVOLVE_THREAD_REGISTRY_SIZE]; ///< _buffers, reachable without lock
+			std::atomic<LoggerSink*> _emergencySinks[EVOLVE_LOG_EMERGENCY_REPORTERS]; ///< _sinks, reachable without lock
+			std::atomic<bool> _closureCondition; ///< set on destruction to stop _logThread
+			std::thread _logThread; ///< consumer thread
 
+			ThreadBuffer& localBuffer();
+			bool push(ThreadBuffer& ioBuffer, LogMessage& ioLogMessage);
+			void reportDropped(const std::vector<std::shared_ptr<ThreadBuffer> >& iBuffers);
+			void reportSuppressed(bool iAll);
+			void wake();
+			void wait(const std::vector<std::shared_ptr<ThreadBuffer> >& iBuffers, std::size_t iVersion);
+			void releaseRetiredBuffers();
+			void refreshSinks();
 			void loopMessageLogs();
+			void reportMessages(LogMessage* ioMessages, std::size_t iCount);
+			void forwardSync(unsigned long long iTicket);
         };
     }
 }
 
 #define EVOLVE_ATTACH_LOGGER_REPORTER(r) evolve::log::Logger::Instance()->attachReporter((r));
+#define EVOLVE_ATTACH_LOGGER_REPORTER_LEVEL(r, level) evolve::log::Logger::Instance()->attachReporter((r), (level));
+
+/**
+ * Fill the call site fields of a message, the timestamp is taken on the calling thread
+ */
+#define EVOLVE_LOG_INIT_(logMessage, level, file, line, func) \
+	do{ \
+		(logMessage)._level = level; \
+		(logMessage)._time = evolve::log::Logger::Now(); \
+		(logMessage)._file = file; \
+		(logMessage)._line = line; \
+		(logMessage)._func = func; \
+		(logMessage)._threadId = std::this_thread::get_id(); \
+		(logMessage)._threadIndex = evolve::utils::GetCurrentThreadIndex(); \
+	} while(0)
 
 #define EVOLVE_LOG(level, message) EVOLVE_LOG_(level, message, __FILE__, __LINE__, __FUNCTION__)
 #define EVOLVE_LOG_(level, message, file, line, func) \
 	do{ \
-		evolve::log::LogMessage aLogMesssage; \
-		aLogMesssage._level = level; \
-		std::stringstream _ss; \
-		_ss << message; \
-		aLogMesssage._message = _ss.str(); \
-		aLogMesssage._file = file; \
-		aLogMesssage._line = line; \
-		aLogMesssage._func = func; \
-		aLogMesssage._threadId = std::this_thread::get_id(); \
-		evolve::log::Logger::Instance()->log(aLogMesssage); \
+		if (evolve::log::Logger::IsEnabled(level)) { \
+			evolve::log::LogMessage aLogMesssage; \
+			EVOLVE_LOG_INIT_(aLogMesssage, level, file, line, func); \
+			{ \
+				evolve::log::LogStream::Scope _ss(aLogMesssage._message); \
+				_ss.get() << message; \
+			} \
+			evolve::log::Logger::Instance()->log(std::move(aLogMesssage)); \
+		} \
 	} while(0)
 
-#define EVOLVE_LOG_IF(level, condition, message) EVOLVE_LOG_(level, condition, message, __FILE__, __LINE__, __FUNCTION__)
+#define EVOLVE_LOG_IF(level, condition, message) EVOLVE_LOG_IF_(level, condition, message, __FILE__, __LINE__, __FUNCTION__)
 #define EVOLVE_LOG_IF_(level, condition, message, file, line, func) \
 	do{ \
-		if(condition) { \
+		if(evolve::log::Logger::IsEnabled(level) && (condition)) { \
 			evolve::log::LogMessage aLogMesssage; \
-			aLogMesssage._level = level; \
-			std::stringstream _ss; \
-			_ss << message; \
-			aLogMesssage._message = _ss.str(); \
-			aLogMesssage._file = file; \
-			aLogMesssage._line = line; \
-			aLogMesssage._func = func; \
-			aLogMesssage._threadId = std::this_thread::get_id(); \
-			evolve::log::Logger::Instance()->log(aLogMesssage); \
+			EVOLVE_LOG_INIT_(aLogMesssage, level, file, line, func); \
+			{ \
+				evolve::log::LogStream::Scope _ss(aLogMesssage._message); \
+				_ss.get() << message; \
+			} \
+			evolve::log::Logger::Instance()->log(std::move(aLogMesssage)); \
+		} \
+	} while(0)
+
+/**
+ * Deferred formatting: only the static format string and the raw argument bytes
+ * are captured on the calling thread, "{}" placeholders are replaced on the logger thread.
+ * The format must be a string literal (or any string outliving the logger).
+ * Below the runtime level, the message is still built for the flight recorder if it records this level.
+ */
+#define EVOLVE_LOGF(level, format, ...) EVOLVE_LOGF_(level, __FILE__, __LINE__, __FUNCTION__, format, ##__VA_ARGS__)
+#define EVOLVE_LOGF_(level, file, line, func, format, ...) \
+	do{ \
+		const bool aLogEnabled = evolve::log::Logger::IsEnabled(level); \
+		if (aLogEnabled || evolve::log::Logger::IsRecorded(level)) { \
+			evolve::log::LogMessage aLogMesssage; \
+			EVOLVE_LOG_INIT_(aLogMesssage, level, file, line, func); \
+			aLogMesssage._format = format; \
+			aLogMesssage._arguments.pack(__VA_ARGS__); \
+			if (aLogEnabled) { \
+				evolve::log::Logger::Instance()->log(std::move(aLogMesssage)); \
+			} \
+			else { \
+				evolve::log::Logger::Record(aLogMesssage); \
+			} \
+		} \
+	} while(0)
+
+/**
+ * Structured message: a static text followed by alternated static keys and typed values,
+ * e.g. EVOLVE_LOGS(level, "frame", "index", aFrame, "cpu_ms", aCpuMs)
+ */
+#define EVOLVE_LOGS(level, message, ...) EVOLVE_LOGS_(level, __FILE__, __LINE__, __FUNCTION__, message, ##__VA_ARGS__)
+#define EVOLVE_LOGS_(level, file, line, func, message, ...) \
+	do{ \
+		if (evolve::log::Logger::IsEnabled(level)) { \
+			evolve::log::LogMessage aLogMesssage; \
+			EVOLVE_LOG_INIT_(aLogMesssage, level, file, line, func); \
+			aLogMesssage._format = message; \
+			aLogMesssage._fields.pack(__VA_ARGS__); \
+			evolve::log::Logger::Instance()->log(std::move(aLogMesssage)); \
+		} \
+	} while(0)
+
+/**
+ * Register a channel on startup, at namespace scope of a source file,
+ * e.g. EVOLVE_LOG_DEFINE_CHANNEL(VulkanChannel, "vulkan");
+ */
+#define EVOLVE_LOG_DEFINE_CHANNEL(variable, name) \
+	static const evolve::log::LogChannel variable = evolve::log::Logger::RegisterChannel(name)
+
+/**
+ * Channel variants of EVOLVE_LOG, EVOLVE_LOGF and EVOLVE_LOGS: the level is checked
+ * against the runtime threshold of the channel instead of the global one
+ */
+#define EVOLVE_CLOG(channel, level, message) EVOLVE_CLOG_(channel, level, message, __FILE__, __LINE__, __FUNCTION__)
+#define EVOLVE_CLOG_(channel, level, message, file, line, func) \
+	do{ \
+		const evolve::log::LogChannel aLogChannel = (channel); \
+		if (evolve::log::Logger::IsEnabled(level, aLogChannel)) { \
+			evolve::log::LogMessage aLogMesssage; \
+			EVOLVE_LOG_INIT_(aLogMesssage, level, file, line, func); \
+			aLogMesssage._channel = aLogChannel; \
+			{ \
+				evolve::log::LogStream::Scope _ss(aLogMesssage._message); \
+				_ss.get() << message; \
+			} \
+			evolve::log::Logger::Instance()->log(std::move(aLogMesssage)); \
+		} \
+	} while(0)
+
+#define EVOLVE_CLOGF(channel, level, format, ...) EVOLVE_CLOGF_(channel, level, __FILE__, __LINE__, __FUNCTION__, format, ##__VA_ARGS__)
+#define EVOLVE_CLOGF_(channel, level, file, line, func, format, ...) \
+	do{ \
+		const evolve::log::LogChannel aLogChannel = (channel); \
+		const bool aLogEnabled = evolve::log::Logger::IsEnabled(level, aLogChannel); \
+		if (aLogEnabled || evolve::log::Logger::IsRecorded(level)) { \
+			evolve::log::LogMessage aLogMesssage; \
+			EVOLVE_LOG_INIT_(aLogMesssage, level, file, line, func); \
+			aLogMesssage._channel = aLogChannel; \
+			aLogMesssage._format = format; \
+			aLogMesssage._arguments.pack(__VA_ARGS__); \
+			if (aLogEnabled) { \
+				evolve::log::Logger::Instance()->log(std::move(aLogMesssage)); \
+			} \
+			else { \
+				evolve::log::Logger::Record(aLogMesssage); \
+			} \
+		} \
+	} while(0)
+
+#define EVOLVE_CLOGS(channel, level, message, ...) EVOLVE_CLOGS_(channel, level, __FILE__, __LINE__, __FUNCTION__, message, ##__VA_ARGS__)
+#define EVOLVE_CLOGS_(channel, level, file, line, func, message, ...) \
+	do{ \
+		const evolve::log::LogChannel aLogChannel = (channel); \
+		if (evolve::log::Logger::IsEnabled(level, aLogChannel)) { \
+			evolve::log::LogMessage aLogMesssage; \
+			EVOLVE_LOG_INIT_(aLogMesssage, level, file, line, func); \
+			aLogMesssage._channel = aLogChannel; \
+			aLogMesssage._format = message; \
+			aLogMesssage._fields.pack(__VA_ARGS__); \
+			evolve::log::Logger::Instance()->log(std::move(aLogMesssage)); \
 		} \
 	} while(0)
 
 # if defined(USE_EVOLVE_LOG_DEBUG)
 #  define EVOLVE_LOG_DEBUG(message)	EVOLVE_LOG(evolve::log::LEVEL_DEBUG, message)
 #  define EVOLVE_LOG_DEBUG_IF(condition, message)	EVOLVE_LOG_IF(evolve::log::LEVEL_DEBUG, condition, message)
+#  define EVOLVE_LOGF_DEBUG(format, ...)	EVOLVE_LOGF(evolve::log::LEVEL_DEBUG, format, ##__VA_ARGS__)
+#  define EVOLVE_LOGS_DEBUG(message, ...)	EVOLVE_LOGS(evolve::log::LEVEL_DEBUG, message, ##__VA_ARGS__)
+#  define EVOLVE_CLOG_DEBUG(channel, message)	EVOLVE_CLOG(channel, evolve::log::LEVEL_DEBUG, message)
+#  define EVOLVE_CLOGF_DEBUG(channel, format, ...)	EVOLVE_CLOGF(channel, evolve::log::LEVEL_DEBUG, format, ##__VA_ARGS__)
+#  define EVOLVE_CLOGS_DEBUG(channel, message, ...)	EVOLVE_CLOGS(channel, evolve::log::LEVEL_DEBUG, message, ##__VA_ARGS__)
 # else
 #  define EVOLVE_LOG_DEBUG(message)
 #  define EVOLVE_LOG_DEBUG_IF(condition, message)
+#  define EVOLVE_LOGF_DEBUG(format, ...)
+#  define EVOLVE_LOGS_DEBUG(message, ...)
+#  define EVOLVE_CLOG_DEBUG(channel, message)
+#  define EVOLVE_CLOGF_DEBUG(channel, format, ...)
+#  define EVOLVE_CLOGS_DEBUG(channel, message, ...)
 # endif
 
 # if defined(USE_EVOLVE_LOG_DEBUG) || defined(USE_EVOLVE_LOG_INFO)
 #  define EVOLVE_LOG_INFO(message)	EVOLVE_LOG(evolve::log::LEVEL_INFO, message)
 #  define EVOLVE_LOG_INFO_IF(condition, message)	EVOLVE_LOG_IF(evolve::log::LEVEL_INFO, condition, message)
+#  define EVOLVE_LOGF_INFO(format, ...)	EVOLVE_LOGF(evolve::log::LEVEL_INFO, format, ##__VA_ARGS__)
+#  define EVOLVE_LOGS_INFO(message, ...)	EVOLVE_LOGS(evolve::log::LEVEL_INFO, message, ##__VA_ARGS__)
+#  define EVOLVE_CLOG_INFO(channel, message)	EVOLVE_CLOG(channel, evolve::log::LEVEL_INFO, message)
+#  define EVOLVE_CLOGF_INFO(channel, format, ...)	EVOLVE_CLOGF(channel, evolve::log::LEVEL_INFO, format, ##__VA_ARGS__)
+#  define EVOLVE_CLOGS_INFO(channel, message, ...)	EVOLVE_CLOGS(channel, evolve::log::LEVEL_INFO, message, ##__VA_ARGS__)
 # else
 #  define EVOLVE_LOG_INFO(message)
 #  define EVOLVE_LOG_INFO_IF(condition, message)
+#  define EVOLVE_LOGF_INFO(format, ...)
+#  define EVOLVE_LOGS_INFO(message, ...)
+#  define EVOLVE_CLOG_INFO(channel, message)
+#  define EVOLVE_CLOGF_INFO(channel, format, ...)
+#  define EVOLVE_CLOGS_INFO(channel, message, ...)
 # endif
 
 # if defined(USE_EVOLVE_LOG_DEBUG) || defined(USE_EVOLVE_LOG_INFO) || defined(USE_EVOLVE_LOG_WARNING)
 #  define EVOLVE_LOG_WARNING(message)	EVOLVE_LOG(evolve::log::LEVEL_WARNING, message)
 #  define EVOLVE_LOG_WARNING_IF(condition, message)	EVOLVE_LOG_IF(evolve::log::LEVEL_WARNING, condition, message)
+#  define EVOLVE_LOGF_WARNING(format, ...)	EVOLVE_LOGF(evolve::log::LEVEL_WARNING, format, ##__VA_ARGS__)
+#  define EVOLVE_LOGS_WARNING(message, ...)	EVOLVE_LOGS(evolve::log::LEVEL_WARNING, message, ##__VA_ARGS__)
+#  define EVOLVE_CLOG_WARNING(channel, message)	EVOLVE_CLOG(channel, evolve::log::LEVEL_WARNING, message)
+#  define EVOLVE_CLOGF_WARNING(channel, format, ...)	EVOLVE_CLOGF(channel, evolve::log::LEVEL_WARNING, format, ##__VA_ARGS__)
+#  define EVOLVE_CLOGS_WARNING(channel, message, ...)	EVOLVE_CLOGS(channel, evolve::log::LEVEL_WARNING, message, ##__VA_ARGS__)
 # else
 #  define EVOLVE_LOG_WARNING(message)
 #  define EVOLVE_LOG_WARNING_IF(condition, message)
+#  define EVOLVE_LOGF_WARNING(format, ...)
+#  define EVOLVE_LOGS_WARNING(message, ...)
+#  define EVOLVE_CLOG_WARNING(channel, message)
+#  define EVOLVE_CLOGF_WARNING(channel, format, ...)
+#  define EVOLVE_CLOGS_WARNING(channel, message, ...)
 # endif
 
 #define EVOLVE_LOG_ERROR(message)	EVOLVE_LOG(evolve::log::LEVEL_ERROR, message)
 #define EVOLVE_LOG_ERROR_IF(condition, message)	EVOLVE_LOG_IF(evolve::log::LEVEL_ERROR, condition, message)
+#define EVOLVE_LOGF_ERROR(format, ...)	EVOLVE_LOGF(evolve::log::LEVEL_ERROR, format, ##__VA_ARGS__)
+#define EVOLVE_LOGS_ERROR(message, ...)	EVOLVE_LOGS(evolve::log::LEVEL_ERROR, message, ##__VA_ARGS__)
+#define EVOLVE_CLOG_ERROR(channel, message)	EVOLVE_CLOG(channel, evolve::log::LEVEL_ERROR, message)
+#define EVOLVE_CLOGF_ERROR(channel, format, ...)	EVOLVE_CLOGF(channel, evolve::log::LEVEL_ERROR, format, ##__VA_ARGS__)
+#define EVOLVE_CLOGS_ERROR(channel, message, ...)	EVOLVE_CLOGS(channel, evolve::log::LEVEL_ERROR, message, ##__VA_ARGS__)
 
 #define EVOLVE_LOG_CRITICAL(message)	EVOLVE_LOG(evolve::log::LEVEL_CRITICAL, message)
 #define EVOLVE_LOG_CRITICAL_IF(condition, message)	EVOLVE_LOG_IF(evolve::log::LEVEL_CRITICAL, condition, message)
+#define EVOLVE_LOGF_CRITICAL(format, ...)	EVOLVE_LOGF(evolve::log::LEVEL_CRITICAL, format, ##__VA_ARGS__)
+#define EVOLVE_LOGS_CRITICAL(message, ...)	EVOLVE_LOGS(evolve::log::LEVEL_CRITICAL, message, ##__VA_ARGS__)
+#define EVOLVE_CLOG_CRITICAL(channel, message)	EVOLVE_CLOG(channel, evolve::log::LEVEL_CRITICAL, message)
+#define EVOLVE_CLOGF_CRITICAL(channel, format, ...)	EVOLVE_CLOGF(channel, evolve::log::LEVEL_CRITICAL, format, ##__VA_ARGS__)
+#define EVOLVE_CLOGS_CRITICAL(channel, message, ...)	EVOLVE_CLOGS(channel, evolve::log::LEVEL_CRITICAL, message, ##__VA_ARGS__)
 
 #define EVOLVE_CRITICAL_EXCEPTION(message)	EVOLVE_CRITICAL_EXCEPTION_(evolve::log::LEVEL_CRITICAL, message, __FILE__, __LINE__, __FUNCTION__)
 #define EVOLVE_CRITICAL_EXCEPTION_(level, message, file, line, func) \
 	do { \
-		evolve::log::LogMessage aLogMesssage; \
-		aLogMesssage._level = level; \
-		std::stringstream _ss; \
-		_ss << message; \
-		aLogMesssage._message = _ss.str(); \
-		aLogMesssage._file = file; \
-		aLogMesssage._line = line; \
-		aLogMesssage._func = func; \
-		aLogMesssage._threadId = std::this_thread::get_id(); \
-		evolve::log::Logger::Instance()->log(aLogMesssage); \
+		if (evolve::log::Logger::IsEnabled(level)) { \
+			evolve::log::LogMessage aLogMesssage; \
+			EVOLVE_LOG_INIT_(aLogMesssage, level, file, line, func); \
+			{ \
+				evolve::log::LogStream::Scope _ss(aLogMesssage._message); \
+				_ss.get() << message; \
+			} \
+			evolve::log::Logger::Instance()->log(std::move(aLogMesssage)); \
+			evolve::log::Logger::Instance()->syncCritical(); \
+		} \
 		throw std::runtime_error(message); \
 	} while (0)
 
@@ -203,16 +774,16 @@ namespace evolve {
 #define EVOLVE_CRITICAL_EXCEPTION_IF_(level, condition, message, file, line, func) \
 	do { \
 		if (condition) { \
-			evolve::log::LogMessage aLogMesssage; \
-			aLogMesssage._level = level; \
-			std::stringstream _ss; \
-			_ss << message; \
-			aLogMesssage._message = _ss.str(); \
-			aLogMesssage._file = file; \
-			aLogMesssage._line = line; \
-			aLogMesssage._func = func; \
-			aLogMesssage._threadId = std::this_thread::get_id(); \
-			evolve::log::Logger::Instance()->log(aLogMesssage); \
+			if (evolve::log::Logger::IsEnabled(level)) { \
+				evolve::log::LogMessage aLogMesssage; \
+				EVOLVE_LOG_INIT_(aLogMesssage, level, file, line, func); \
+				{ \
+					evolve::log::LogStream::Scope _ss(aLogMesssage._message); \
+					_ss.get() << message; \
+				} \
+				evolve::log::Logger::Instance()->log(std::move(aLogMesssage)); \
+				evolve::log::Logger::Instance()->syncCritical(); \
+			} \
 			throw std::runtime_error(message); \
 		} \
 	} while (0)
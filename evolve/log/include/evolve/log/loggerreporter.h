@@ -32,8 +32,10 @@
 #define EVOLVE_LOGGER_REPORTER_H
 
 #include <evolve/log/logger.h>
-#include <evolve/utils/clock.h>
+#include <evolve/log/loglayout.h>
+#include <evolve/log/logindex.h>
 #include <evolve/log/export.h>
+#include <chrono>
 #include <string>
 #include <fstream>
 
@@ -46,15 +48,19 @@ namespace evolve {
      */
     namespace log {
 
+		class AsyncFileWriter;
+
         /**
          * \brief Interface for all log reporters
          */
 		class EVOLVE_LOG_EXPORT LoggerReporter {
 		public:
 			/**
-			 * \brief Default constructor
+			 * \brief Constructor
+			 *
+			 * \param[in] iPattern line layout used by formatLogMessage, see LogLayout
 			 */
-			LoggerReporter();
+			explicit LoggerReporter(const char* iPattern = EVOLVE_LOG_DEFAULT_PATTERN);
 
 			/**
 			 * \brief Destructor
@@ -67,16 +73,67 @@ namespace evolve {
 			* \param[in] iLogMessage the message to log
 			*/
 			virtual void log(const LogMessage& iLogMessage) = 0;
+
+			/**
+			* \brief Log a batch of messages
+			*
+			* Called by the logger thread with everything drained from the queue at once.
+			* Default implementation calls log() for each message.
+			*
+			* \param[in] iLogMessages contiguous messages to log
+			* \param[in] iCount number of messages
+			*/
+			virtual void logBatch(const LogMessage* iLogMessages, std::size_t iCount);
+
+			/**
+			* \brief Called by the logger thread each time the queue is empty
+			*
+			* Gives buffered reporters a chance to apply time based policies.
+			* Default implementation does nothing.
+			*/
+			virtual void idle();
+
+			/**
+			* \brief Write out any buffered output
+			*
+			* Default implementation does nothing.
+			*/
+			virtual void flush();
+
+			/**
+			* \brief Wait until the flushed output has been written
+			*
+			* Called after flush() when the logger syncs or closes, for reporters
+			* whose flush only starts a write. Default implementation does nothing.
+			*/
+			virtual void sync();
+
+			/**
+			* \brief Get the descriptor the emergency drain writes text lines to
+			*
+			* See Logger::emergencyDrain. Default implementation returns -1.
+			*
+			* \return file descriptor accepting plain text lines, -1 if none
+			*/
+			virtual int getEmergencyDescriptor() const;
+
+			/**
+			* \brief Write output the reporter still buffers, from a fatal signal handler
+			*
+			* Must not allocate nor lock: the reporter thread may be stuck or dead.
+			* Default implementation does nothing.
+			*/
+			virtual void emergencyFlush();
 		protected:
 			/**
-			* \brief Helper method to fo)=
+			* \brief Format a message with the reporter layout
 			*
 			* \param[in] iLogMessage the message to log
 			* \param[out] oLog the formatted log
 			*/
 			virtual void formatLogMessage(const LogMessage& iLogMessage, std::string& oLog);
 
-			evolve::utils::Clock _clock;
+			LogLayout _layout; ///< line layout, parsed once
 		};
 
         /**
@@ -87,9 +144,11 @@ namespace evolve {
         class EVOLVE_LOG_EXPORT CoutLoggerReporter : public LoggerReporter {
         public:
             /**
-             * \brief Default constructor
+             * \brief Constructor
+             *
+             * \param[in] iPattern line layout, see LogLayout
              */
-            CoutLoggerReporter();
+            explicit CoutLoggerReporter(const char* iPattern = EVOLVE_LOG_DEFAULT_PATTERN);
 
             /**
              * \brief Destructor
@@ -102,12 +161,93 @@ namespace evolve {
 			* \param[in] iLogMessage the message to log
 			*/
 			virtual void log(const LogMessage& iLogMessage);
+
+			/**
+			* \brief Log a batch of messages with a single console write
+			*
+			* \param[in] iLogMessages contiguous messages to log
+			* \param[in] iCount number of messages
+			*/
+			virtual void logBatch(const LogMessage* iLogMessages, std::size_t iCount);
+
+			/**
+			* \brief Get the standard output descriptor
+			*
+			* \return standard output file descriptor
+			*/
+			virtual int getEmergencyDescriptor() const;
+
+		private:
+			std::string _line; ///< reusable formatted line
+			std::string _buffer; ///< reusable batch output buffer
         };
         
+        /**
+         * \brief Flush policy of buffered file reporters
+         *
+         * Formatted lines are kept in memory and written with a single call when
+         * any of the enabled conditions is met.
+         */
+		struct EVOLVE_LOG_EXPORT FileFlushPolicy {
+			/**
+			 * \brief Default constructor, flush after each batch of messages
+			 */
+			FileFlushPolicy();
+
+			/**
+			 * \brief Flush after each batch of messages (unbuffered behaviour)
+			 *
+			 * \return the policy
+			 */
+			static FileFlushPolicy Always();
+
+			/**
+			 * \brief Buffered policy
+			 *
+			 * \param[in] iBytes flush once this many bytes are pending
+			 * \param[in] iIntervalMs flush once the oldest pending line is this old, 0 to disable
+			 * \param[in] iLevel flush right away on messages at or above this level
+			 * \return the policy
+			 */
+			static FileFlushPolicy Buffered(std::size_t iBytes = 1 << 20, unsigned int iIntervalMs = 1000, LogLevel iLevel = LEVEL_ERROR);
+
+			/**
+			 * \brief Buffered policy where flushes are written in the background, see AsyncFileWriter
+			 *
+			 * The reporter thread keeps formatting while the kernel writes, and
+			 * only blocks when all iBuffers are in flight.
+			 *
+			 * \param[in] iBytes flush once this many bytes are pending
+			 * \param[in] iIntervalMs flush once the oldest pending line is this old, 0 to disable
+			 * \param[in] iLevel flush right away on messages at or above this level
+			 * \param[in] iBuffers number of flushed buffers in flight
+			 * \return the policy
+			 */
+			static FileFlushPolicy Asynchronous(std::size_t iBytes = 1 << 20, unsigned int iIntervalMs = 1000, LogLevel iLevel = LEVEL_ERROR,
+				unsigned int iBuffers = 4);
+
+			/**
+			 * \brief Same policy, also writing a sidecar index next to the file, see LogIndexEntry
+			 *
+			 * Each index entry describes about iBlockBytes of log, evolve_logquery
+			 * uses the index to read only the blocks matching a query.
+			 *
+			 * \param[in] iBlockBytes log bytes described by each index entry
+			 * \return the policy
+			 */
+			FileFlushPolicy withIndex(std::size_t iBlockBytes = EVOLVE_LOG_INDEX_BLOCK_SIZE) const;
+
+			std::size_t _bytes; ///< pending bytes threshold, 0 to flush after each batch
+			unsigned int _intervalMs; ///< pending age threshold in milliseconds, 0 to disable
+			LogLevel _level; ///< level threshold, LEVEL_OFF to disable
+			unsigned int _asyncBuffers; ///< buffers written in the background, 0 to write on the reporter thread
+			std::size_t _indexBlockBytes; ///< log bytes per sidecar index entry, 0 for no index
+		};
+
         /**
          * \brief File output reporter
          *
-         * Writes the log messages into a given file
+         * Writes the log messages into a given file, following a FileFlushPolicy
          */
         class EVOLVE_LOG_EXPORT FileLoggerReporter : public LoggerReporter {
         public:
@@ -115,8 +255,11 @@ namespace evolve {
              * \brief Constructor with output file path
              *
              * \param[in] iFile complete file path
+             * \param[in] iPolicy when buffered lines are written to the file
+             * \param[in] iPattern line layout, see LogLayout
              */
-            FileLoggerReporter(const char* iFile);
+            FileLoggerReporter(const char* iFile, const FileFlushPolicy& iPolicy = FileFlushPolicy::Always(),
+				const char* iPattern = EVOLVE_LOG_DEFAULT_PATTERN);
 
             /**
              * \brief Destructor
@@ -130,8 +273,110 @@ namespace evolve {
 			*/
 			virtual void log(const LogMessage& iLogMessage);
 
+			/**
+			* \brief Log a batch of messages with a single file write
+			*
+			* \param[in] iLogMessages contiguous messages to log
+			* \param[in] iCount number of messages
+			*/
+			virtual void logBatch(const LogMessage* iLogMessages, std::size_t iCount);
+
+			/**
+			* \brief Flush pending lines older than the policy interval
+			*/
+			virtual void idle();
+
+			/**
+			* \brief Write all pending lines to the file
+			*/
+			virtual void flush();
+
+			/**
+			* \brief Wait for the background writes of an asynchronous policy
+			*/
+			virtual void sync();
+
+			/**
+			* \brief Get the descriptor opened next to the file stream
+			*
+			* \return file descriptor, -1 if the file could not be opened
+			*/
+			virtual int getEmergencyDescriptor() const;
+
+			/**
+			* \brief Write the pending buffer straight to the file
+			*/
+			virtual void emergencyFlush();
+
+		protected:
+			/**
+			 * \brief Constructor for derived file formats
+			 *
+			 * \param[in] iFile complete file path
+			 * \param[in] iPolicy when buffered data is written to the file
+			 * \param[in] iMode open mode added to std::ofstream::out | std::ofstream::app | std::ofstream::binary
+			 */
+			FileLoggerReporter(const char* iFile, const FileFlushPolicy& iPolicy, std::ios_base::openmode iMode);
+
+			/**
+			 * \brief Append the output of one message to the pending buffer
+			 *
+			 * Default implementation appends the formatted line and a new line.
+			 *
+			 * \param[in] iLogMessage the message to log
+			 * \param[in,out] ioBuffer pending output
+			 */
+			virtual void appendLogMessage(const LogMessage& iLogMessage, std::string& ioBuffer);
+
+			/**
+			 * \brief Write raw bytes to the pending buffer
+			 *
+			 * \param[in] iData bytes to write
+			 * \param[in] iSize number of bytes
+			 */
+			void appendRaw(const char* iData, std::size_t iSize);
+
+			/**
+			 * \brief Close the output file, pending data is not written
+			 */
+			void closeFile();
+
+			/**
+			 * \brief Open the output file again after closeFile()
+			 */
+			void openFile();
+
+			/**
+			 * \brief Get the output file path
+			 *
+			 * \return complete file path
+			 */
+			const std::string& getFile() const;
+
+			/**
+			 * \brief Get the number of bytes waiting for the next flush
+			 *
+			 * \return pending bytes
+			 */
+			std::size_t getPendingSize() const;
+
         private:
-            std::ofstream _fileStream; ///< output file stream
+			void indexLogMessage(const LogMessage& iLogMessage);
+			void closeIndexEntry();
+
+			std::string _file; ///< output file path
+			std::ios_base::openmode _mode; ///< output file open mode
+            std::ofstream _fileStream; ///< output file stream, unbuffered
+			AsyncFileWriter* _asyncWriter; ///< background writer replacing _fileStream, NULL if the policy is synchronous
+			int _emergencyDescriptor; ///< same file opened for the emergency drain
+			FileFlushPolicy _policy; ///< flush policy
+			std::string _line; ///< reusable formatted line
+			std::string _buffer; ///< preallocated pending output
+			std::chrono::steady_clock::time_point _pendingSince; ///< time of the oldest pending line
+			unsigned long long _fileEnd; ///< file size once the pending buffer is written, excluded
+			LogIndexWriter _index; ///< sidecar index, if the policy asks for it
+			LogIndexEntry _indexEntry; ///< block being filled
+			std::vector<LogIndexEntry> _indexEntries; ///< complete blocks, written to the index after their data
         };
     }
 }
@@ -0,0 +1,205 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/loggersink.h
+ * \brief evolve/log asynchronous reporter delivery header file
+ * \author
+ *
+ */
+
+#ifndef EVOLVE_LOGGER_SINK_H
+#define EVOLVE_LOGGER_SINK_H
+
+#include <evolve/log/logger.h>
+#include <evolve/log/export.h>
+#include <evolve/utils/spscringbuffer.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		class LoggerReporter;
+		class EmergencyWriter;
+
+		/**
+		 * \brief Delivery counters of one reporter
+		 */
+		struct LoggerSinkStatistics {
+			LoggerSinkStatistics()
+				:_delivered(0), _dropped(0) {}
+
+			unsigned long long _delivered; ///< messages handed to the reporter
+			unsigned long long _dropped; ///< messages lost because the reporter queue was full, never with OVERFLOW_BLOCK
+		};
+
+		/**
+		 * \brief Asynchronous delivery of messages to one reporter
+		 *
+		 * The logger thread pushes every message at or above the sink level into
+		 * a bounded queue, drained by a dedicated delivery thread. A full queue
+		 * is handled with the sink own overflow policy: with OVERFLOW_BLOCK the
+		 * logger thread waits for the slow reporter, the other policies drop
+		 * messages as the staging buffers do. Dropped messages are counted and
+		 * the delivery thread reports the loss to its reporter as soon as it
+		 * catches up.
+		 */
+		class EVOLVE_LOG_EXPORT LoggerSink {
+		public:
+			/**
+			 * \brief Constructor, starts the delivery thread
+			 *
+			 * \param[in] iReporter reporter to feed, owned by the sink
+			 * \param[in] iLevel minimum level delivered to the reporter
+			 * \param[in] iCapacity number of pending messages before the overflow policy applies
+			 * \param[in] iPolicy what to do when the queue is full
+			 * \param[in] iSampleRate for OVERFLOW_SAMPLE, one message kept out of iSampleRate
+			 */
+			LoggerSink(LoggerReporter* iReporter, LogLevel iLevel, std::size_t iCapacity, LogOverflowPolicy iPolicy,
+				unsigned int iSampleRate);
+
+			/**
+			 * \brief Destructor, closes the sink if needed
+			 */
+			~LoggerSink();
+
+			/**
+			 * \brief Deliver pending messages, stop the delivery thread and delete the reporter
+			 *
+			 * Messages pushed afterwards are ignored, so the logger thread may
+			 * still hold the sink. Must not be called twice concurrently.
+			 */
+			void close();
+
+			/**
+			 * \brief Queue messages for delivery
+			 *
+			 * Must only be called from the logger thread.
+			 *
+			 * \param[in,out] ioLogMessages contiguous messages, already formatted
+			 * \param[in] iCount number of messages
+			 * \param[in] iMove move the messages instead of copying them, they are left empty
+			 */
+			void push(LogMessage* ioLogMessages, std::size_t iCount, bool iMove);
+
+			/**
+			 * \brief Get the fed reporter
+			 *
+			 * \return the reporter, NULL once closed
+			 */
+			LoggerReporter* getReporter() const;
+
+			/**
+			 * \brief Get the delivery counters
+			 *
+			 * \return delivered and dropped message counts
+			 */
+			LoggerSinkStatistics getStatistics() const;
+
+			/**
+			 * \brief Ask the delivery thread to flush the reporter once its queue is empty
+			 *
+			 * Must only be called from the logger thread.
+			 *
+			 * \param[in] iTicket sync request number, see Logger::sync
+			 */
+			void requestSync(unsigned long long iTicket);
+
+			/**
+			 * \brief Check if a sync request has been completed
+			 *
+			 * \param[in] iTicket sync request number
+			 * \return true once the reporter has been flushed for this request
+			 */
+			bool isSynced(unsigned long long iTicket) const;
+
+			/**
+			 * \brief Check if the calling thread is the delivery thread
+			 *
+			 * \return true if called from the delivery thread
+			 */
+			bool isDeliveryThread() const;
+
+			/**
+			 * \brief Write what the reporter and the queue still hold, from a fatal signal handler
+			 *
+			 * The reporter buffer is only flushed if the delivery thread is not
+			 * inside a reporter call, or is the crashing thread; the reporter is
+			 * then left claimed so the delivery thread never touches it again.
+			 * Otherwise only the queued messages are written.
+			 *
+			 * \param[in,out] ioWriter allocation free writer
+			 */
+			void emergencyDrain(EmergencyWriter& ioWriter);
+
+			/**
+			 * \brief Write one message straight to the reporter descriptor, from a fatal signal handler
+			 *
+			 * \param[in] iLogMessage the message, skipped below the sink level
+			 * \param[in,out] ioWriter allocation free writer
+			 */
+			void emergencyWrite(const LogMessage& iLogMessage, EmergencyWriter& ioWriter);
+
+		private:
+			void loopDelivery();
+			void wake();
+			void wait();
+			void reportDropped(unsigned long long iDropped);
+			bool pushOne(LogMessage& ioLogMessage, bool iMove);
+			void claimReporter();
+			void releaseReporter();
+
+			LoggerReporter* _reporter; ///< reporter instance
+			const LogLevel _level; ///< minimum delivered level
+			const LogOverflowPolicy _policy; ///< what to do when _queue is full
+			const unsigned int _sampleRate; ///< one message kept out of _sampleRate with OVERFLOW_SAMPLE
+			evolve::utils::SpscRingBuffer<LogMessage> _queue; ///< pending messages, consumed by _deliveryThread
+			std::atomic<unsigned long long> _delivered; ///< messages handed to the reporter
+			std::atomic<unsigned long long> _dropped; ///< messages lost on a full queue
+			unsigned long long _sampleCount; ///< messages considered by OVERFLOW_SAMPLE, logger thread only
+			std::atomic<bool> _sleeping; ///< delivery thread sleeping flag
+			std::mutex _wakeMutex; ///< mutex for delivery thread sleep
+			std::condition_variable _wakeCondition; ///< delivery thread wake up condition
+			std::atomic<unsigned long long> _syncRequested; ///< last sync request
+			std::atomic<unsigned long long> _syncDone; ///< last sync request completed by _deliveryThread
+			std::atomic<bool> _closureCondition; ///< set by close() to stop _deliveryThread
+			std::atomic<bool> _delivering; ///< set while the reporter is in use, by _deliveryThread or emergencyDrain
+			std::thread _deliveryThread; ///< delivery thread
+
+			LoggerSink(const LoggerSink&);
+			LoggerSink& operator=(const LoggerSink&);
+		};
+    }
+}
+
+#endif
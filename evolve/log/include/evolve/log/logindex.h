@@ -0,0 +1,190 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/logindex.h
+ * \brief evolve/log sidecar index of log files
+ * \author
+ *
+ */
+
+#ifndef EVOLVE_LOG_INDEX_H
+#define EVOLVE_LOG_INDEX_H
+
+#include <evolve/log/logger.h>
+#include <evolve/log/export.h>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * Magic bytes starting a sidecar index file
+ */
+#define EVOLVE_LOG_INDEX_MAGIC "EVLOGIDX"
+
+/**
+ * Sidecar index format version, written after the magic bytes
+ */
+#define EVOLVE_LOG_INDEX_VERSION 1
+
+/**
+ * Extension appended to the log file path to get its index path
+ */
+#define EVOLVE_LOG_INDEX_EXTENSION ".idx"
+
+/**
+ * Default number of log bytes described by one index entry
+ */
+#ifndef EVOLVE_LOG_INDEX_BLOCK_SIZE
+#define EVOLVE_LOG_INDEX_BLOCK_SIZE (1 << 20)
+#endif
+
+/**
+ * Number of bits of the thread bitmap of an index entry, thread indexes wrap around
+ */
+#define EVOLVE_LOG_INDEX_THREAD_BITS 256
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		/**
+		 * \brief Summary of one block of a log file
+		 *
+		 * Blocks are contiguous byte ranges cut between two messages. The
+		 * index file is EVOLVE_LOG_INDEX_MAGIC, a 32 bits version and a 32 bits
+		 * entry size, followed by the entries in file order. Values are stored
+		 * in native byte order.
+		 */
+		struct EVOLVE_LOG_EXPORT LogIndexEntry {
+			/**
+			 * \brief Constructor, empty block at offset 0
+			 */
+			LogIndexEntry();
+
+			/**
+			 * \brief Start a new empty block
+			 *
+			 * \param[in] iOffset file offset of the block
+			 */
+			void reset(unsigned long long iOffset);
+
+			/**
+			 * \brief Account a message written in the block
+			 *
+			 * \param[in] iLogMessage the message
+			 */
+			void add(const LogMessage& iLogMessage);
+
+			/**
+			 * \brief Check if a thread may have messages in the block
+			 *
+			 * \param[in] iThreadIndex thread index, see evolve::utils::GetCurrentThreadIndex
+			 * \return false if the thread has no message in the block
+			 */
+			bool hasThread(unsigned int iThreadIndex) const;
+
+			/**
+			 * \brief Check if the block has messages at or above a level
+			 *
+			 * \param[in] iLevel minimum level
+			 * \return true if at least one message matches
+			 */
+			bool hasLevel(LogLevel iLevel) const;
+
+			/**
+			 * \brief Get the number of messages in the block
+			 *
+			 * \return message count
+			 */
+			unsigned long long getCount() const;
+
+			unsigned long long _offset; ///< file offset of the first byte
+			unsigned long long _size; ///< bytes in the block
+			unsigned long long _firstTime; ///< earliest message time, nanoseconds since epoch (UTC)
+			unsigned long long _lastTime; ///< latest message time, nanoseconds since epoch (UTC)
+			unsigned int _levels[LEVEL_OFF + 1]; ///< message count of each level
+			unsigned long long _threads[EVOLVE_LOG_INDEX_THREAD_BITS / 64]; ///< bit (thread index % EVOLVE_LOG_INDEX_THREAD_BITS) set for each writing thread
+		};
+
+		/**
+		 * \brief Appends entries to the sidecar index of a log file
+		 */
+		class EVOLVE_LOG_EXPORT LogIndexWriter {
+		public:
+			/**
+			 * \brief Constructor, no index opened
+			 */
+			LogIndexWriter();
+
+			/**
+			 * \brief Destructor
+			 */
+			~LogIndexWriter();
+
+			/**
+			 * \brief Open the index of a log file
+			 *
+			 * An index not matching the log file (other format, or entries past
+			 * its end because the file was replaced) is started over.
+			 *
+			 * \param[in] iLogFile complete log file path
+			 * \param[in] iLogSize current size of the log file
+			 * \return false if the index can't be written
+			 */
+			bool open(const std::string& iLogFile, unsigned long long iLogSize);
+
+			/**
+			 * \brief Close the index
+			 */
+			void close();
+
+			/**
+			 * \brief Append entries
+			 *
+			 * \param[in] iEntries entries, in file order
+			 */
+			void write(const std::vector<LogIndexEntry>& iEntries);
+
+		private:
+			std::ofstream _stream; ///< index file
+		};
+
+		/**
+		 * \brief Read the whole index of a log file
+		 *
+		 * \param[in] iLogFile complete log file path
+		 * \param[out] oEntries entries in file order
+		 * \return false if there is no valid index
+		 */
+		EVOLVE_LOG_EXPORT bool ReadLogIndex(const std::string& iLogFile, std::vector<LogIndexEntry>& oEntries);
+    }
+}
+
+#endif
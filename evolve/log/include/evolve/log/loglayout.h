@@ -0,0 +1,180 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/loglayout.h
+ * \brief evolve/log pattern based log line formatter header file
+ * \author
+ *
+ */
+
+#ifndef EVOLVE_LOG_LAYOUT_H
+#define EVOLVE_LOG_LAYOUT_H
+
+#include <evolve/log/logger.h>
+#include <evolve/log/export.h>
+#include <evolve/utils/clock.h>
+#include <string>
+#include <vector>
+
+/**
+ * Pattern reproducing the historical layout of text reporters
+ */
+#define EVOLVE_LOG_DEFAULT_PATTERN "[%T | Thread: %-3t (%016I) | %42f#%4l > %50F | %8L] %m%k"
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+		struct BinaryLogRecord;
+
+		/**
+		 * \brief Values read back from a formatted line, see LogLayout::parse
+		 */
+		struct LogLineHeader {
+			bool _hasTime; ///< the pattern has %T
+			unsigned long long _time; ///< nanoseconds since epoch (UTC), to the formatted fraction digits
+			bool _hasLevel; ///< the pattern has %L
+			LogLevel _level;
+			bool _hasThread; ///< the pattern has %i, or %t and the thread had no name
+			unsigned long long _threadIndex;
+			std::string _threadName; ///< %n, or %t of a named thread, empty otherwise
+		};
+
+		/**
+		 * \brief Pattern based log line formatter
+		 *
+		 * The pattern is parsed once into a sequence of operations; formatting
+		 * then appends to a caller-provided buffer, converting and padding
+		 * numbers by hand. Conversions:
+		 *  - %T time, %L level, %m message, %k fields (" key=value" each)
+		 *  - %f file, %l line, %F function
+		 *  - %t thread name if set, index otherwise; %i thread index; %n thread name; %I thread id
+		 *  - %c channel name, see Logger::RegisterChannel
+		 *  - %% a percent sign
+		 * A conversion may be preceded by a width, right aligned by default,
+		 * left aligned with '-', zero padded with a leading '0': "%-42f", "%016I".
+		 */
+		class EVOLVE_LOG_EXPORT LogLayout {
+		public:
+			/**
+			 * \brief Constructor, parses the pattern
+			 *
+			 * \param[in] iPattern line pattern, unknown conversions are copied as is
+			 * \param[in] iFractionDigits digits after the seconds in %T
+			 */
+			explicit LogLayout(const char* iPattern = EVOLVE_LOG_DEFAULT_PATTERN, unsigned int iFractionDigits = 3);
+
+			/**
+			 * \brief Format a message, replacing the content of oLine
+			 *
+			 * \param[in] iLogMessage the message
+			 * \param[out] oLine the formatted line, without new line
+			 */
+			void format(const LogMessage& iLogMessage, std::string& oLine);
+
+			/**
+			 * \brief Format a message at the end of a buffer
+			 *
+			 * \param[in] iLogMessage the message
+			 * \param[in,out] ioBuffer output buffer
+			 */
+			void append(const LogMessage& iLogMessage, std::string& ioBuffer);
+
+			/**
+			 * \brief Format a decoded message whose thread id is only known by its hash
+			 *
+			 * Thread names are not looked up, they belong to the writing process.
+			 *
+			 * \param[in] iLogMessage the message, _threadId is ignored
+			 * \param[in] iThreadId hash of the thread id
+			 * \param[in,out] ioBuffer output buffer
+			 */
+			void append(const LogMessage& iLogMessage, unsigned long long iThreadId, std::string& ioBuffer);
+
+			/**
+			 * \brief Format a record read back from a binary log or a shared memory ring
+			 *
+			 * \param[in] iRecord the record, its thread id being a hash as above
+			 * \param[in,out] ioBuffer output buffer
+			 */
+			void append(const BinaryLogRecord& iRecord, std::string& ioBuffer);
+
+			/**
+			 * \brief Read the time, level and thread back from a line formatted with this layout
+			 *
+			 * Each conversion ends where the literal text following it in the
+			 * pattern starts. Reading stops at %m and %k, whose text is free, and
+			 * at two conversions in a row, which can't be told apart.
+			 *
+			 * \param[in] iLine the line, without new line
+			 * \param[in] iLength length of the line
+			 * \param[out] oHeader values found before reading stopped
+			 * \return false if the line doesn't follow the pattern, as continuation lines of multi-line messages
+			 */
+			bool parse(const char* iLine, std::size_t iLength, LogLineHeader& oHeader) const;
+
+		private:
+			enum OperationType {
+				OPERATION_TEXT,
+				OPERATION_TIME,
+				OPERATION_LEVEL,
+				OPERATION_MESSAGE,
+				OPERATION_FIELDS,
+				OPERATION_FILE,
+				OPERATION_LINE,
+				OPERATION_FUNCTION,
+				OPERATION_THREAD,
+				OPERATION_THREAD_INDEX,
+				OPERATION_THREAD_NAME,
+				OPERATION_THREAD_ID,
+				OPERATION_CHANNEL,
+			};
+
+			struct Operation {
+				OperationType _type; ///< what to write
+				unsigned int _width; ///< minimum width, 0 for none
+				bool _left; ///< pad on the right
+				char _fill; ///< padding character
+				std::size_t _offset; ///< OPERATION_TEXT offset in _text
+				std::size_t _length; ///< OPERATION_TEXT length
+			};
+
+			void append(const LogMessage& iLogMessage, unsigned long long iThreadId, bool iThreadNames, std::string& ioBuffer);
+			static void AppendPadded(std::string& ioBuffer, const char* iText, std::size_t iLength, const Operation& iOperation);
+			static void AppendNumber(std::string& ioBuffer, unsigned long long iValue, const Operation& iOperation);
+			static void AppendFields(std::string& ioBuffer, const LogFields& iFields);
+
+			std::vector<Operation> _operations; ///< parsed pattern
+			std::string _text; ///< literal parts of the pattern
+			evolve::utils::Clock _clock; ///< formats %T, caching the current second
+			std::string _threadName; ///< reusable thread name
+		};
+    }
+}
+
+#endif
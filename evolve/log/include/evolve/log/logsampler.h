@@ -0,0 +1,220 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/logsampler.h
+ * \brief evolve/log call site sampling for hot code paths
+ * \author
+ *
+ */
+
+#ifndef EVOLVE_LOG_SAMPLER_H
+#define EVOLVE_LOG_SAMPLER_H
+
+#include <evolve/log/logger.h>
+#include <evolve/utils/clock.h>
+#include <atomic>
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		/**
+		 * \brief Sampling state of one call site
+		 *
+		 * Meant to be a function local static, one per call site (see the
+		 * EVOLVE_LOG_EVERY_N, EVOLVE_LOG_FIRST_N and EVOLVE_LOG_EVERY_MS macros):
+		 * the constructor is constexpr, so there is no initialisation guard.
+		 * An occurrence which is not sampled costs one atomic operation and
+		 * the message is never built. Thread safe.
+		 */
+		class LogSampler {
+		public:
+			/**
+			 * \brief Constructor
+			 */
+			constexpr LogSampler()
+				:_count(0), _last(0), _skipped(0) {}
+
+			/**
+			 * \brief Sample the first occurrence, then one out of iN
+			 *
+			 * \param[in] iN sampling period, 0 or 1 to keep every occurrence
+			 * \param[out] oSkipped occurrences skipped since the previous sampled one
+			 * \return true if the occurrence must be logged
+			 */
+			bool everyN(unsigned long long iN, unsigned long long& oSkipped) {
+				const unsigned long long aCount = _count.fetch_add(1, std::memory_order_relaxed);
+				if (iN > 1 && aCount % iN != 0) {
+					return false;
+				}
+				oSkipped = aCount == 0 || iN <= 1 ? 0 : iN - 1;
+				return true;
+			}
+
+			/**
+			 * \brief Sample the first iN occurrences only
+			 *
+			 * Once the limit is reached, an occurrence only costs a relaxed load.
+			 *
+			 * \param[in] iN number of occurrences to keep
+			 * \return true if the occurrence must be logged
+			 */
+			bool firstN(unsigned long long iN) {
+				return _count.load(std::memory_order_relaxed) < iN
+					&& _count.fetch_add(1, std::memory_order_relaxed) < iN;
+			}
+
+			/**
+			 * \brief Sample at most one occurrence per interval
+			 *
+			 * Uses the coarse clock, the interval is only as precise as its tick.
+			 *
+			 * \param[in] iIntervalMs minimum time between two sampled occurrences
+			 * \param[out] oSkipped occurrences skipped since the previous sampled one
+			 * \return true if the occurrence must be logged
+			 */
+			bool everyMs(unsigned int iIntervalMs, unsigned long long& oSkipped) {
+				const unsigned long long aNow = evolve::utils::Clock::Now(true);
+				unsigned long long aLast = _last.load(std::memory_order_relaxed);
+				if ((aLast != 0 && aNow >= aLast && aNow - aLast < static_cast<unsigned long long>(iIntervalMs) * 1000000ULL)
+					|| !_last.compare_exchange_strong(aLast, aNow, std::memory_order_relaxed)) {
+					_skipped.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+				oSkipped = _skipped.exchange(0, std::memory_order_relaxed);
+				return true;
+			}
+
+		private:
+			std::atomic<unsigned long long> _count; ///< occurrences seen, everyN and firstN
+			std::atomic<unsigned long long> _last; ///< time of the last sampled occurrence, everyMs
+			std::atomic<unsigned long long> _skipped; ///< skipped since the last sampled occurrence, everyMs
+
+			LogSampler(const LogSampler&);
+			LogSampler& operator=(const LogSampler&);
+		};
+    }
+}
+
+/**
+ * Log a sampled occurrence, with the number of occurrences skipped before it if any
+ */
+#define EVOLVE_LOG_SAMPLED_(level, skipped, message, file, line, func) \
+	do{ \
+		if ((skipped) != 0) { \
+			EVOLVE_LOG_(level, message << " (skipped " << (skipped) << ")", file, line, func); \
+		} \
+		else { \
+			EVOLVE_LOG_(level, message, file, line, func); \
+		} \
+	} while(0)
+
+/**
+ * Log the first occurrence of this call site, then one out of n
+ */
+#define EVOLVE_LOG_EVERY_N(level, n, message) EVOLVE_LOG_EVERY_N_(level, n, message, __FILE__, __LINE__, __FUNCTION__)
+#define EVOLVE_LOG_EVERY_N_(level, n, message, file, line, func) \
+	do{ \
+		if (evolve::log::Logger::IsEnabled(level)) { \
+			static evolve::log::LogSampler aLogSampler; \
+			unsigned long long aSkipped = 0; \
+			if (aLogSampler.everyN((n), aSkipped)) { \
+				EVOLVE_LOG_SAMPLED_(level, aSkipped, message, file, line, func); \
+			} \
+		} \
+	} while(0)
+
+/**
+ * Log the first n occurrences of this call site only
+ */
+#define EVOLVE_LOG_FIRST_N(level, n, message) EVOLVE_LOG_FIRST_N_(level, n, message, __FILE__, __LINE__, __FUNCTION__)
+#define EVOLVE_LOG_FIRST_N_(level, n, message, file, line, func) \
+	do{ \
+		if (evolve::log::Logger::IsEnabled(level)) { \
+			static evolve::log::LogSampler aLogSampler; \
+			if (aLogSampler.firstN((n))) { \
+				EVOLVE_LOG_(level, message, file, line, func); \
+			} \
+		} \
+	} while(0)
+
+/**
+ * Log at most one occurrence of this call site every ms milliseconds
+ */
+#define EVOLVE_LOG_EVERY_MS(level, ms, message) EVOLVE_LOG_EVERY_MS_(level, ms, message, __FILE__, __LINE__, __FUNCTION__)
+#define EVOLVE_LOG_EVERY_MS_(level, ms, message, file, line, func) \
+	do{ \
+		if (evolve::log::Logger::IsEnabled(level)) { \
+			static evolve::log::LogSampler aLogSampler; \
+			unsigned long long aSkipped = 0; \
+			if (aLogSampler.everyMs((ms), aSkipped)) { \
+				EVOLVE_LOG_SAMPLED_(level, aSkipped, message, file, line, func); \
+			} \
+		} \
+	} while(0)
+
+# if defined(USE_EVOLVE_LOG_DEBUG)
+#  define EVOLVE_LOG_DEBUG_EVERY_N(n, message)	EVOLVE_LOG_EVERY_N(evolve::log::LEVEL_DEBUG, n, message)
+#  define EVOLVE_LOG_DEBUG_FIRST_N(n, message)	EVOLVE_LOG_FIRST_N(evolve::log::LEVEL_DEBUG, n, message)
+#  define EVOLVE_LOG_DEBUG_EVERY_MS(ms, message)	EVOLVE_LOG_EVERY_MS(evolve::log::LEVEL_DEBUG, ms, message)
+# else
+#  define EVOLVE_LOG_DEBUG_EVERY_N(n, message)
+#  define EVOLVE_LOG_DEBUG_FIRST_N(n, message)
+#  define EVOLVE_LOG_DEBUG_EVERY_MS(ms, message)
+# endif
+
+# if defined(USE_EVOLVE_LOG_DEBUG) || defined(USE_EVOLVE_LOG_INFO)
+#  define EVOLVE_LOG_INFO_EVERY_N(n, message)	EVOLVE_LOG_EVERY_N(evolve::log::LEVEL_INFO, n, message)
+#  define EVOLVE_LOG_INFO_FIRST_N(n, message)	EVOLVE_LOG_FIRST_N(evolve::log::LEVEL_INFO, n, message)
+#  define EVOLVE_LOG_INFO_EVERY_MS(ms, message)	EVOLVE_LOG_EVERY_MS(evolve::log::LEVEL_INFO, ms, message)
+# else
+#  define EVOLVE_LOG_INFO_EVERY_N(n, message)
+#  define EVOLVE_LOG_INFO_FIRST_N(n, message)
+#  define EVOLVE_LOG_INFO_EVERY_MS(ms, message)
+# endif
+
+# if defined(USE_EVOLVE_LOG_DEBUG) || defined(USE_EVOLVE_LOG_INFO) || defined(USE_EVOLVE_LOG_WARNING)
+#  define EVOLVE_LOG_WARNING_EVERY_N(n, message)	EVOLVE_LOG_EVERY_N(evolve::log::LEVEL_WARNING, n, message)
+#  define EVOLVE_LOG_WARNING_FIRST_N(n, message)	EVOLVE_LOG_FIRST_N(evolve::log::LEVEL_WARNING, n, message)
+#  define EVOLVE_LOG_WARNING_EVERY_MS(ms, message)	EVOLVE_LOG_EVERY_MS(evolve::log::LEVEL_WARNING, ms, message)
+# else
+#  define EVOLVE_LOG_WARNING_EVERY_N(n, message)
+#  define EVOLVE_LOG_WARNING_FIRST_N(n, message)
+#  define EVOLVE_LOG_WARNING_EVERY_MS(ms, message)
+# endif
+
+#define EVOLVE_LOG_ERROR_EVERY_N(n, message)	EVOLVE_LOG_EVERY_N(evolve::log::LEVEL_ERROR, n, message)
+#define EVOLVE_LOG_ERROR_FIRST_N(n, message)	EVOLVE_LOG_FIRST_N(evolve::log::LEVEL_ERROR, n, message)
+#define EVOLVE_LOG_ERROR_EVERY_MS(ms, message)	EVOLVE_LOG_EVERY_MS(evolve::log::LEVEL_ERROR, ms, message)
+
+#define EVOLVE_LOG_CRITICAL_EVERY_N(n, message)	EVOLVE_LOG_EVERY_N(evolve::log::LEVEL_CRITICAL, n, message)
+#define EVOLVE_LOG_CRITICAL_FIRST_N(n, message)	EVOLVE_LOG_FIRST_N(evolve::log::LEVEL_CRITICAL, n, message)
+#define EVOLVE_LOG_CRITICAL_EVERY_MS(ms, message)	EVOLVE_LOG_EVERY_MS(evolve::log::LEVEL_CRITICAL, ms, message)
+
+#endif
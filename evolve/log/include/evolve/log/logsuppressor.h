@@ -0,0 +1,208 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/logsuppressor.h
+ * \brief evolve/log duplicate message suppression and rate limiting header file
+ * \author
+ *
+ */
+
+#ifndef EVOLVE_LOG_SUPPRESSOR_H
+#define EVOLVE_LOG_SUPPRESSOR_H
+
+#include <evolve/log/logger.h>
+#include <evolve/log/export.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Number of independently locked key tables of a suppressor
+ */
+#ifndef EVOLVE_LOG_SUPPRESSOR_SHARDS
+#define EVOLVE_LOG_SUPPRESSOR_SHARDS 16
+#endif
+
+/**
+ * Number of keys a suppressor table tracks before forgetting idle ones
+ */
+#ifndef EVOLVE_LOG_SUPPRESSOR_KEYS
+#define EVOLVE_LOG_SUPPRESSOR_KEYS 1024
+#endif
+
+/**
+ * Characters of message text a suppressor keeps per key to tell its summaries apart
+ */
+#ifndef EVOLVE_LOG_SUPPRESSOR_LABEL_SIZE
+#define EVOLVE_LOG_SUPPRESSOR_LABEL_SIZE 64
+#endif
+
+/**
+ * Period of the logger thread check for suppressed counts left unreported, in milliseconds
+ */
+#ifndef EVOLVE_LOG_SUPPRESSOR_FLUSH_MS
+#define EVOLVE_LOG_SUPPRESSOR_FLUSH_MS 1000
+#endif
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		/**
+		 * \brief Collapse repeated messages and rate limit them, per (message id, call site)
+		 *
+		 * The first occurrence of a key is logged. Later ones are suppressed and
+		 * counted while they come within the window of the last logged one, or
+		 * when the key's token bucket is empty. The next occurrence logged
+		 * after that carries the suppressed count, for a "repeated N times"
+		 * summary. If none comes, the logger thread reports the count itself
+		 * once the window has passed, and when the logger closes, followed by
+		 * the start of the key's message text so that summaries of keys
+		 * sharing a call site can be told apart.
+		 * Thread safe, keys are spread over independently locked tables.
+		 */
+		class EVOLVE_LOG_EXPORT LogSuppressor {
+		public:
+			/**
+			 * \brief Constructor
+			 *
+			 * \param[in] iWindowMs repeats closer than this to the last logged occurrence are collapsed, 0 to disable
+			 * \param[in] iRatePerSecond tokens added to each key bucket per second
+			 * \param[in] iBurst bucket size, 0 to disable rate limiting
+			 */
+			LogSuppressor(unsigned int iWindowMs = 1000, unsigned int iRatePerSecond = 10, unsigned int iBurst = 20);
+
+			/**
+			 * \brief Destructor, suppressed counts not reported yet are left to the logger thread
+			 */
+			~LogSuppressor();
+
+			/**
+			 * \brief Decide whether an occurrence must be logged
+			 *
+			 * \param[in] iMessageId message identifier, such as a code or a hash of a format
+			 * \param[in] iCallSite call site identifier
+			 * \param[out] oSuppressed occurrences suppressed since the last logged one, set when logged
+			 * \param[in] iLevel level of the summary logged for a count left unreported
+			 * \param[in] iFile source file of the summary
+			 * \param[in] iLine source line of the summary
+			 * \param[in] iFunction function of the summary
+			 * \param[in] iLabel message text or caller label of the summary, copied up to EVOLVE_LOG_SUPPRESSOR_LABEL_SIZE
+			 * \return true if the occurrence must be logged
+			 */
+			bool admit(unsigned long long iMessageId, unsigned long long iCallSite, unsigned long long& oSuppressed,
+				LogLevel iLevel = LEVEL_INFO, const char* iFile = NULL, unsigned int iLine = 0, const char* iFunction = NULL,
+				const char* iLabel = NULL);
+
+			/**
+			 * \brief Give a key the label of its summary, if it has none yet
+			 *
+			 * For callers only building the message text once it is admitted.
+			 *
+			 * \param[in] iMessageId message identifier given to admit
+			 * \param[in] iCallSite call site identifier given to admit
+			 * \param[in] iText message text, need not be null terminated
+			 * \param[in] iLength length of the text
+			 */
+			void label(unsigned long long iMessageId, unsigned long long iCallSite, const char* iText, std::size_t iLength);
+
+			/**
+			 * \brief Collect the summaries of the counts left unreported by every suppressor
+			 *
+			 * Called by the logger thread.
+			 *
+			 * \param[in] iNow current time, see evolve::utils::Clock::Now
+			 * \param[in] iAll report every count, even for keys still in their window
+			 * \param[out] oMessages summaries, appended
+			 */
+			static void Expire(unsigned long long iNow, bool iAll, std::vector<LogMessage>& oMessages);
+
+		private:
+			struct Entry {
+				unsigned long long _lastLogged; ///< time of the last logged occurrence
+				unsigned long long _lastRefill; ///< time of the last bucket refill
+				unsigned long long _tokens; ///< available tokens, in billionths
+				unsigned long long _suppressed; ///< suppressed since the last logged occurrence
+				LogLevel _level; ///< level of the summary
+				const char* _file; ///< source file of the summary
+				unsigned int _line; ///< source line of the summary
+				const char* _function; ///< function of the summary
+				char _label[EVOLVE_LOG_SUPPRESSOR_LABEL_SIZE]; ///< start of the message text, empty if unknown
+			};
+
+			struct Shard {
+				std::mutex _mutex; ///< protects _entries
+				std::unordered_map<unsigned long long, Entry> _entries; ///< state per key
+			};
+
+			static unsigned long long Key(unsigned long long iMessageId, unsigned long long iCallSite);
+			static void CopyLabel(Entry& ioEntry, const char* iText, std::size_t iLength);
+			Shard& shard(unsigned long long iKey);
+			void forgetIdle(Shard& ioShard, unsigned long long iNow);
+			void expire(unsigned long long iNow, bool iAll, std::vector<LogMessage>& oMessages);
+
+			const unsigned long long _window; ///< collapse window, nanoseconds
+			const unsigned long long _rate; ///< tokens per second
+			const unsigned long long _burst; ///< bucket size, in billionths of a token
+			Shard _shards[EVOLVE_LOG_SUPPRESSOR_SHARDS]; ///< key tables
+
+			LogSuppressor(const LogSuppressor&);
+			LogSuppressor& operator=(const LogSuppressor&);
+		};
+    }
+}
+
+/**
+ * Log through a suppressor, keyed by (id, call site); repeats are summarised in the next logged occurrence.
+ * The message is only built once admitted, its text then labels the key's summaries.
+ */
+#define EVOLVE_LOG_SUPPRESSED(level, suppressor, id, message) EVOLVE_LOG_SUPPRESSED_(level, suppressor, id, message, __FILE__, __LINE__, __FUNCTION__)
+#define EVOLVE_LOG_SUPPRESSED_(level, suppressor, id, message, file, line, func) \
+	do{ \
+		if (evolve::log::Logger::IsEnabled(level)) { \
+			unsigned long long aSuppressed = 0; \
+			const unsigned long long aCallSite = reinterpret_cast<unsigned long long>(file) * 31 + (line); \
+			if ((suppressor).admit((id), aCallSite, aSuppressed, level, file, line, func)) { \
+				evolve::log::LogMessage aLogMesssage; \
+				EVOLVE_LOG_INIT_(aLogMesssage, level, file, line, func); \
+				{ \
+					evolve::log::LogStream::Scope _ss(aLogMesssage._message); \
+					_ss.get() << message; \
+				} \
+				(suppressor).label((id), aCallSite, aLogMesssage._message.data(), aLogMesssage._message.size()); \
+				if (aSuppressed != 0) { \
+					aLogMesssage._message += " (repeated " + std::to_string(aSuppressed) + " times)"; \
+				} \
+				evolve::log::Logger::Instance()->log(std::move(aLogMesssage)); \
+			} \
+		} \
+	} while(0)
+
+#endif
@@ -0,0 +1,390 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/logtext.h
+ * \brief evolve/log message text storage without per-message allocation
+ * \author
+ *
+ */
+
+#ifndef EVOLVE_LOG_TEXT_H
+#define EVOLVE_LOG_TEXT_H
+
+#include <evolve/log/export.h>
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+/**
+ * Number of message bytes stored inside LogText, longer texts spill to the slab pool
+ */
+#ifndef EVOLVE_LOG_INLINE_TEXT_SIZE
+#define EVOLVE_LOG_INLINE_TEXT_SIZE 128
+#endif
+
+/**
+ * Size of the slabs carved into pool blocks
+ */
+#ifndef EVOLVE_LOG_TEXT_SLAB_SIZE
+#define EVOLVE_LOG_TEXT_SLAB_SIZE (256 << 10)
+#endif
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		/**
+		 * \brief Process wide pool of fixed-size text blocks
+		 *
+		 * Blocks come in a few size classes (256 bytes to 64 KiB), carved from
+		 * slabs which are never given back: a released block goes to the free
+		 * list of its class and is handed out again, whichever thread releases
+		 * it. Larger texts are allocated and freed on the heap.
+		 */
+		class EVOLVE_LOG_EXPORT LogTextPool {
+		public:
+			/**
+			 * \brief Get a block of at least iSize bytes
+			 *
+			 * \param[in] iSize needed bytes
+			 * \param[out] oCapacity real block size, to give back to Release
+			 * \return block, never NULL
+			 */
+			static char* Acquire(std::size_t iSize, std::size_t& oCapacity);
+
+			/**
+			 * \brief Give a block back to its free list
+			 *
+			 * \param[in] iBlock block returned by Acquire
+			 * \param[in] iCapacity block size returned by Acquire
+			 */
+			static void Release(char* iBlock, std::size_t iCapacity);
+
+			/**
+			 * \brief Get the memory reserved by the pool slabs
+			 *
+			 * \return bytes allocated for slabs since the start of the process
+			 */
+			static std::size_t GetReservedSize();
+		};
+
+		/**
+		 * \brief Message text with an inline small buffer
+		 *
+		 * Texts up to EVOLVE_LOG_INLINE_TEXT_SIZE - 1 bytes live in the object
+		 * itself, longer ones in a LogTextPool block. Moving steals the block,
+		 * copying an inline text never allocates, so messages go through the
+		 * staging and sink queues without touching the heap. The text is
+		 * always null terminated.
+		 */
+		class EVOLVE_LOG_EXPORT LogText {
+		public:
+			/**
+			 * \brief Default constructor, empty text
+			 */
+			LogText()
+				:_spill(NULL), _size(0), _capacity(EVOLVE_LOG_INLINE_TEXT_SIZE) {
+				_inline[0] = '\0';
+			}
+
+			/**
+			 * \brief Copy constructor
+			 */
+			LogText(const LogText& iText)
+				:_spill(NULL), _size(0), _capacity(EVOLVE_LOG_INLINE_TEXT_SIZE) {
+				assign(iText.data(), iText.size());
+			}
+
+			/**
+			 * \brief Move constructor, takes the pool block of iText
+			 */
+			LogText(LogText&& ioText)
+				:_spill(NULL), _size(0), _capacity(EVOLVE_LOG_INLINE_TEXT_SIZE) {
+				take(ioText);
+			}
+
+			/**
+			 * \brief Destructor, gives the pool block back
+			 */
+			~LogText() {
+				release();
+			}
+
+			LogText& operator=(const LogText& iText) {
+				if (this != &iText) {
+					assign(iText.data(), iText.size());
+				}
+				return *this;
+			}
+
+			LogText& operator=(LogText&& ioText) {
+				if (this != &ioText) {
+					release();
+					take(ioText);
+				}
+				return *this;
+			}
+
+			LogText& operator=(const std::string& iText) {
+				assign(iText.data(), iText.size());
+				return *this;
+			}
+
+			LogText& operator=(const char* iText) {
+				assign(iText, std::strlen(iText));
+				return *this;
+			}
+
+			/**
+			 * \brief Replace the text
+			 *
+			 * A pool block is only kept if the new text does not fit inline.
+			 *
+			 * \param[in] iData new text, may not point into this text
+			 * \param[in] iSize new text length
+			 */
+			void assign(const char* iData, std::size_t iSize) {
+				if (iSize < EVOLVE_LOG_INLINE_TEXT_SIZE) {
+					release();
+				}
+				_size = 0;
+				append(iData, iSize);
+			}
+
+			/**
+			 * \brief Append bytes at the end of the text
+			 *
+			 * \param[in] iData bytes to append, may not point into this text
+			 * \param[in] iSize number of bytes
+			 */
+			void append(const char* iData, std::size_t iSize) {
+				reserve(_size + iSize);
+				std::memcpy(data() + _size, iData, iSize);
+				resize(_size + iSize);
+			}
+
+			LogText& operator+=(const char* iText) {
+				append(iText, std::strlen(iText));
+				return *this;
+			}
+
+			LogText& operator+=(const std::string& iText) {
+				append(iText.data(), iText.size());
+				return *this;
+			}
+
+			LogText& operator+=(char iChar) {
+				append(&iChar, 1);
+				return *this;
+			}
+
+			/**
+			 * \brief Make room for a text of iSize bytes, the current text is kept
+			 *
+			 * \param[in] iSize text length to hold, without the null terminator
+			 */
+			void reserve(std::size_t iSize) {
+				if (iSize >= _capacity) {
+					grow(iSize);
+				}
+			}
+
+			/**
+			 * \brief Set the text length, after writing in data() up to capacity()
+			 *
+			 * \param[in] iSize new length, lower than capacity()
+			 */
+			void resize(std::size_t iSize) {
+				_size = iSize;
+				data()[_size] = '\0';
+			}
+
+			/**
+			 * \brief Empty the text, the pool block is kept
+			 */
+			void clear() {
+				resize(0);
+			}
+
+			char* data() {
+				return _spill != NULL ? _spill : _inline;
+			}
+
+			const char* data() const {
+				return _spill != NULL ? _spill : _inline;
+			}
+
+			const char* c_str() const {
+				return data();
+			}
+
+			std::size_t size() const {
+				return _size;
+			}
+
+			bool empty() const {
+				return _size == 0;
+			}
+
+			/**
+			 * \brief Get the usable storage, null terminator included
+			 *
+			 * \return bytes available at data()
+			 */
+			std::size_t capacity() const {
+				return _capacity;
+			}
+
+			/**
+			 * \brief Copy the text into a string
+			 *
+			 * \return the text
+			 */
+			std::string str() const {
+				return std::string(data(), _size);
+			}
+
+		private:
+			void grow(std::size_t iSize);
+
+			void release() {
+				if (_spill != NULL) {
+					LogTextPool::Release(_spill, _capacity);
+					_spill = NULL;
+					_capacity = EVOLVE_LOG_INLINE_TEXT_SIZE;
+				}
+				_size = 0;
+				_inline[0] = '\0';
+			}
+
+			void take(LogText& ioText) {
+				if (ioText._spill != NULL) {
+					_spill = ioText._spill;
+					_capacity = ioText._capacity;
+					ioText._spill = NULL;
+					ioText._capacity = EVOLVE_LOG_INLINE_TEXT_SIZE;
+				}
+				else {
+					std::memcpy(_inline, ioText._inline, ioText._size + 1);
+				}
+				_size = ioText._size;
+				ioText._size = 0;
+				ioText._inline[0] = '\0';
+			}
+
+			char* _spill; ///< pool block holding the text, NULL while it fits inline
+			std::size_t _size; ///< text length
+			std::size_t _capacity; ///< storage size of the block or of the inline buffer
+			char _inline[EVOLVE_LOG_INLINE_TEXT_SIZE]; ///< storage of short texts
+		};
+
+		inline std::ostream& operator<<(std::ostream& ioStream, const LogText& iText) {
+			return ioStream.write(iText.data(), static_cast<std::streamsize>(iText.size()));
+		}
+
+		/**
+		 * \brief Output stream writing straight into a LogText
+		 *
+		 * Replaces the std::stringstream built for each streamed message: one
+		 * stream per thread is reused (with its format state reset each time),
+		 * and the characters go to the message text without an intermediate
+		 * string. A message streamed while another one is being built on the
+		 * same thread (an operator<< logging itself) gets its own stream.
+		 *
+		 * Usage: LogStream::Scope aScope(aText); aScope.get() << ...;
+		 * the text is complete once the scope is destroyed.
+		 */
+		class EVOLVE_LOG_EXPORT LogStream : public std::ostream {
+		public:
+			/**
+			 * \brief Attach the stream of the current thread to a text for the scope lifetime
+			 */
+			class EVOLVE_LOG_EXPORT Scope {
+			public:
+				/**
+				 * \brief Constructor
+				 *
+				 * \param[out] oText text receiving the streamed characters, cleared
+				 */
+				explicit Scope(LogText& oText);
+
+				/**
+				 * \brief Destructor, sets the final text length
+				 */
+				~Scope();
+
+				/**
+				 * \brief Get the stream to write to
+				 *
+				 * \return the attached stream
+				 */
+				std::ostream& get() {
+					return *_stream;
+				}
+
+			private:
+				LogStream* _stream; ///< thread stream, or a private one when it is busy
+				bool _owned; ///< _stream has been created for this scope
+
+				Scope(const Scope&);
+				Scope& operator=(const Scope&);
+			};
+
+			/**
+			 * \brief Constructor, detached stream
+			 */
+			LogStream();
+
+		private:
+			class Buffer : public std::streambuf {
+			public:
+				Buffer();
+				void attach(LogText* iText);
+				void detach();
+
+			protected:
+				virtual int_type overflow(int_type iChar);
+
+			private:
+				LogText* _text; ///< attached text, NULL when detached
+			};
+
+			void attach(LogText& oText);
+			void detach();
+
+			Buffer _buffer; ///< put area over the attached text storage
+			std::ios_base::fmtflags _flags; ///< initial format flags
+			bool _busy; ///< attached to a text
+		};
+    }
+}
+
+#endif
@@ -0,0 +1,123 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+
+/**
+ * \file evolve/log/mappedfileloggerreporter.h
+ * \brief evolve/log memory-mapped file reporter header file
+ * \author
+ *
+ */
+
+#ifndef EVOLVE_MAPPED_FILE_LOGGER_REPORTER_H
+#define EVOLVE_MAPPED_FILE_LOGGER_REPORTER_H
+
+#include <evolve/log/loggerreporter.h>
+#include <evolve/log/export.h>
+#include <string>
+
+#ifndef EVOLVE_LOG_MAPPED_RETRY_SECONDS
+#define EVOLVE_LOG_MAPPED_RETRY_SECONDS 1 ///< delay before opening a segment again after a failure
+#endif
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+        /**
+         * \brief Memory-mapped file output reporter
+         *
+         * Log lines are appended with a plain memcpy into a preallocated, mapped
+         * segment file ("<file>.0", "<file>.1", ...), so logging never issues a write
+         * system call. A full segment is closed and the next one is mapped.
+         * Closed segments are truncated to their real length; if the process
+         * crashes, the kernel still persists everything copied into the mapping
+         * (the segment then ends with zero bytes).
+         *
+         * Segments are allocated on disk before being mapped, so a full disk
+         * fails the segment opening instead of raising SIGBUS on a later copy.
+         * Lines logged while no segment can be opened are counted and lost, and
+         * the opening is retried once per EVOLVE_LOG_MAPPED_RETRY_SECONDS.
+         */
+        class EVOLVE_LOG_EXPORT MappedFileLoggerReporter : public LoggerReporter {
+        public:
+            /**
+             * \brief Constructor with output file path
+             *
+             * \param[in] iFile base file path, segment index is appended
+             * \param[in] iSegmentSize preallocated size of each segment in bytes
+             * \param[in] iPattern line layout, see LogLayout
+             */
+            MappedFileLoggerReporter(const char* iFile, std::size_t iSegmentSize = 64 << 20,
+				const char* iPattern = EVOLVE_LOG_DEFAULT_PATTERN);
+
+            /**
+             * \brief Destructor
+             */
+			virtual ~MappedFileLoggerReporter();
+
+			/**
+			* \brief Log a debug message
+			*
+			* \param[in] iLogMessage the message to log
+			*/
+			virtual void log(const LogMessage& iLogMessage);
+
+			/**
+			* \brief Log a batch of messages
+			*
+			* \param[in] iLogMessages contiguous messages to log
+			* \param[in] iCount number of messages
+			*/
+			virtual void logBatch(const LogMessage* iLogMessages, std::size_t iCount);
+
+        private:
+			bool openSegment();
+			void closeSegment();
+			void append(const char* iData, std::size_t iSize);
+
+			std::string _file; ///< base file path
+			std::string _segmentPath; ///< path of the current segment
+			std::size_t _segmentSize; ///< preallocated segment size
+			unsigned int _segmentIndex; ///< index of the next segment to open
+			char* _mapping; ///< mapped view of the current segment, NULL if none
+			std::size_t _offset; ///< used bytes in the current segment
+			unsigned long long _retryTime; ///< earliest time to open a segment after a failure, 0 if none failed
+			unsigned long long _lostLines; ///< lines lost since the last failure
+#ifdef WIN32
+			void* _fileHandle; ///< segment file handle
+			void* _mappingHandle; ///< file mapping handle
+#else
+			int _fileDescriptor; ///< segment file descriptor
+#endif
+			std::string _line; ///< reusable formatted line
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,192 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/rotatingfileloggerreporter.h
+ * \brief evolve/log rotating file reporter header file
+ * \author
+ *
+ */
+
+#ifndef EVOLVE_ROTATING_FILE_LOGGER_REPORTER_H
+#define EVOLVE_ROTATING_FILE_LOGGER_REPORTER_H
+
+#include <evolve/log/loggerreporter.h>
+#include <evolve/log/export.h>
+#include <evolve/utils/waitqueue.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		/**
+		 * \brief Interface for rotated log file compressors
+		 *
+		 * Always called from the rotation thread of the reporter, never from the logger thread.
+		 */
+		class EVOLVE_LOG_EXPORT LogFileCompressor {
+		public:
+			/**
+			 * \brief Destructor
+			 */
+			virtual ~LogFileCompressor();
+
+			/**
+			 * \brief Replace a file with its compressed version
+			 *
+			 * \param[in] iPath file to compress, the result is iPath + getExtension()
+			 * \return true if iPath has been replaced
+			 */
+			virtual bool compress(const std::string& iPath) = 0;
+
+			/**
+			 * \brief Get the extension added to compressed files
+			 *
+			 * \return extension, with its leading dot
+			 */
+			virtual const char* getExtension() const = 0;
+		};
+
+		/**
+		 * \brief Compressor running an external command, such as gzip
+		 *
+		 * The command is started directly, without a shell, so the file path
+		 * is never interpreted.
+		 */
+		class EVOLVE_LOG_EXPORT CommandLogFileCompressor : public LogFileCompressor {
+		public:
+			/**
+			 * \brief Constructor
+			 *
+			 * \param[in] iCommand program and arguments separated by spaces, run with the file path
+			 *            as last argument, it must replace the file
+			 * \param[in] iExtension extension added by the command
+			 */
+			CommandLogFileCompressor(const char* iCommand = "gzip -f", const char* iExtension = ".gz");
+
+			/**
+			 * \brief Run the command on a file
+			 *
+			 * \param[in] iPath file to compress
+			 * \return true if the command succeeded
+			 */
+			virtual bool compress(const std::string& iPath);
+
+			/**
+			 * \brief Get the extension added to compressed files
+			 *
+			 * \return extension, with its leading dot
+			 */
+			virtual const char* getExtension() const;
+
+		private:
+			std::vector<std::string> _arguments; ///< program and leading arguments
+			std::string _extension; ///< extension added by the command
+		};
+
+		/**
+		 * \brief When a rotating reporter starts a new file
+		 */
+		struct EVOLVE_LOG_EXPORT FileRotationPolicy {
+			/**
+			 * \brief Constructor
+			 *
+			 * \param[in] iMaxBytes rotate once the file reaches this size, 0 to disable
+			 * \param[in] iIntervalSeconds rotate on each multiple of this wall-clock interval, 0 to disable
+			 * \param[in] iMaxFiles number of rotated files kept next to the current one
+			 */
+			FileRotationPolicy(std::size_t iMaxBytes = 64 << 20, unsigned int iIntervalSeconds = 0, unsigned int iMaxFiles = 8);
+
+			std::size_t _maxBytes; ///< size threshold, 0 to disable
+			unsigned int _intervalSeconds; ///< wall-clock interval, 0 to disable
+			unsigned int _maxFiles; ///< rotated files kept
+		};
+
+		/**
+		 * \brief File reporter rolling over to a new file by size or interval
+		 *
+		 * The current file keeps its name; rotated files are named <file>.1 (most
+		 * recent) to <file>.N, plus the compressor extension. The reporter thread
+		 * only closes, renames and reopens the current file: shifting, deleting
+		 * and compressing old files is done by a dedicated low priority thread.
+		 * Files a previous run renamed but did not archive before it stopped
+		 * are archived first when the reporter starts.
+		 */
+		class EVOLVE_LOG_EXPORT RotatingFileLoggerReporter : public FileLoggerReporter {
+		public:
+			/**
+			 * \brief Constructor
+			 *
+			 * \param[in] iFile complete file path
+			 * \param[in] iRotation when to start a new file and how many to keep
+			 * \param[in] iCompressor compressor of rotated files, owned by the reporter, NULL to keep them as is
+			 * \param[in] iPolicy when buffered lines are written to the file
+			 * \param[in] iPattern line layout, see LogLayout
+			 */
+			RotatingFileLoggerReporter(const char* iFile, const FileRotationPolicy& iRotation = FileRotationPolicy(),
+				LogFileCompressor* iCompressor = NULL, const FileFlushPolicy& iPolicy = FileFlushPolicy::Always(),
+				const char* iPattern = EVOLVE_LOG_DEFAULT_PATTERN);
+
+			/**
+			 * \brief Destructor, waits for pending compressions
+			 */
+			virtual ~RotatingFileLoggerReporter();
+
+			/**
+			 * \brief Rotate on interval even when nothing is logged
+			 */
+			virtual void idle();
+
+			/**
+			 * \brief Write all pending lines, then rotate if the file is full
+			 */
+			virtual void flush();
+
+		private:
+			void checkRotation();
+			void rotate();
+			void scheduleRotation();
+			void loopRotation();
+			void archive(const std::string& iStagedPath);
+			std::string getArchivePath(unsigned int iIndex, bool iCompressed) const;
+
+			FileRotationPolicy _rotation; ///< rotation policy
+			LogFileCompressor* _compressor; ///< compressor instance, may be NULL
+			std::size_t _size; ///< current file size
+			unsigned long long _nextRotation; ///< next interval boundary, nanoseconds since epoch, 0 if disabled
+			unsigned int _stagedIndex; ///< counter of files handed to the rotation thread, staged names also carry the time so a previous run's leftovers are never overwritten
+			evolve::utils::WaitQueue<std::string> _stagedFiles; ///< closed files to archive, empty path to stop
+			std::thread _rotationThread; ///< archives and compresses rotated files
+		};
+    }
+}
+
+#endif
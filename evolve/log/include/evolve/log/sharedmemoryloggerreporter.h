@@ -0,0 +1,223 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/sharedmemoryloggerreporter.h
+ * \brief evolve/log shared memory ring reporter header file
+ * \author
+ *
+ */
+
+#ifndef EVOLVE_SHARED_MEMORY_LOGGER_REPORTER_H
+#define EVOLVE_SHARED_MEMORY_LOGGER_REPORTER_H
+
+#include <evolve/log/loggerreporter.h>
+#include <evolve/log/binaryfileloggerreporter.h>
+#include <evolve/log/export.h>
+#include <atomic>
+#include <string>
+
+/**
+ * Default size of the shared ring, in bytes
+ */
+#ifndef EVOLVE_LOG_SHARED_RING_SIZE
+#define EVOLVE_LOG_SHARED_RING_SIZE (16 << 20)
+#endif
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		/**
+		 * \brief Header at the beginning of the shared memory object, followed by the ring
+		 */
+		struct SharedLogHeader {
+			char _magic[8]; ///< "EVOLVESH"
+			unsigned int _version; ///< layout version
+			unsigned int _headerSize; ///< offset of the ring
+			unsigned long long _capacity; ///< ring size in bytes, power of two
+			unsigned long long _generation; ///< creation time, changes when the writer restarts
+			std::atomic<unsigned long long> _head; ///< bytes published since creation
+			std::atomic<unsigned long long> _tail; ///< position of the oldest record not overwritten
+			std::atomic<unsigned int> _closed; ///< set when the writer is destroyed
+		};
+
+		/**
+		 * \brief Record header in the ring, followed by the file, function and message text
+		 */
+		struct SharedLogRecord {
+			unsigned int _size; ///< record size with its text, multiple of 8
+			unsigned int _level; ///< LogLevel
+			unsigned long long _sequence; ///< record number, gaps tell overwritten records
+			unsigned long long _time; ///< nanoseconds since epoch (UTC)
+			unsigned long long _threadId; ///< hash of the producer std::thread::id
+			unsigned int _line; ///< source line
+			unsigned int _threadIndex; ///< small thread index of the producer
+			unsigned short _fileLength; ///< file name length
+			unsigned short _funcLength; ///< function name length
+			unsigned int _messageLength; ///< message length
+		};
+
+        /**
+         * \brief Reporter publishing raw records into a shared memory ring
+         *
+         * Nothing is formatted nor written to disk by the engine process: a
+         * separate process (evolve_logtail) reads the ring, then filters,
+         * formats and stores the records. The ring never blocks the reporter,
+         * the oldest records are overwritten when readers are too slow.
+         * Published records stay in the shared memory object after the writer
+         * exits or crashes; the object is replaced on the next run.
+         */
+        class EVOLVE_LOG_EXPORT SharedMemoryLoggerReporter : public LoggerReporter {
+        public:
+            /**
+             * \brief Constructor
+             *
+             * \param[in] iName shared memory object name, such as "/evolve_log"
+             * \param[in] iSize ring size in bytes, rounded up to a power of two
+             */
+            SharedMemoryLoggerReporter(const char* iName, std::size_t iSize = EVOLVE_LOG_SHARED_RING_SIZE);
+
+            /**
+             * \brief Destructor, marks the ring closed but keeps it for the readers
+             */
+			virtual ~SharedMemoryLoggerReporter();
+
+			/**
+			* \brief Publish a message
+			*
+			* \param[in] iLogMessage the message to log
+			*/
+			virtual void log(const LogMessage& iLogMessage);
+
+			/**
+			* \brief Publish a batch of messages, readers see them at once
+			*
+			* \param[in] iLogMessages contiguous messages to log
+			* \param[in] iCount number of messages
+			*/
+			virtual void logBatch(const LogMessage* iLogMessages, std::size_t iCount);
+
+        private:
+			void append(const LogMessage& iLogMessage, unsigned long long& ioHead);
+
+			std::string _name; ///< shared memory object name
+			SharedLogHeader* _header; ///< mapped header, NULL if the ring could not be created
+			char* _ring; ///< mapped ring
+			std::size_t _mappingSize; ///< mapped size
+			unsigned long long _sequence; ///< next record number
+			std::string _message; ///< reusable message and fields text
+			LogLayout _fieldsLayout; ///< renders structured fields after the message
+#ifdef WIN32
+			void* _mappingHandle; ///< file mapping handle
+#endif
+
+			SharedMemoryLoggerReporter(const SharedMemoryLoggerReporter&);
+			SharedMemoryLoggerReporter& operator=(const SharedMemoryLoggerReporter&);
+        };
+
+        /**
+         * \brief Reader of a shared memory ring, possibly from another process
+         *
+         * Readers never write to the ring, any number of them can follow it.
+         */
+		class EVOLVE_LOG_EXPORT SharedMemoryLogReader {
+		public:
+			/**
+			 * \brief Constructor, maps the ring
+			 *
+			 * \param[in] iName shared memory object name given to the reporter
+			 * \param[in] iFromStart start at the oldest record still in the ring, at the newest otherwise
+			 */
+			SharedMemoryLogReader(const char* iName, bool iFromStart = true);
+
+			/**
+			 * \brief Destructor
+			 */
+			~SharedMemoryLogReader();
+
+			/**
+			 * \brief Check if the ring could be mapped
+			 *
+			 * \return true if the ring is mapped
+			 */
+			bool isOpen() const;
+
+			/**
+			 * \brief Read the next published record
+			 *
+			 * \param[out] oRecord the decoded record
+			 * \return false if no record is available yet
+			 */
+			bool next(BinaryLogRecord& oRecord);
+
+			/**
+			 * \brief Check if the writer has been destroyed
+			 *
+			 * \return true once the writer closed the ring
+			 */
+			bool isClosed() const;
+
+			/**
+			 * \brief Check if a new writer replaced the ring under the same name
+			 *
+			 * Maps the header of the object currently under the name, not the ring.
+			 *
+			 * \return true if the ring must be opened again to follow the new writer
+			 */
+			bool isReplaced() const;
+
+			/**
+			 * \brief Get the number of records overwritten before they could be read
+			 *
+			 * \return lost record count
+			 */
+			unsigned long long getLostCount() const;
+
+		private:
+			bool copy(unsigned long long iPosition, std::size_t iSize, std::string& oData) const;
+
+			std::string _name; ///< shared memory object name
+			const SharedLogHeader* _header; ///< mapped header, NULL if not open
+			const char* _ring; ///< mapped ring
+			std::size_t _mappingSize; ///< mapped size
+			unsigned long long _position; ///< next read position
+			unsigned long long _sequence; ///< expected sequence of the next record
+			unsigned long long _lost; ///< overwritten records
+			std::string _data; ///< copy of the record being read
+#ifdef WIN32
+			void* _mappingHandle; ///< file mapping handle
+#endif
+
+			SharedMemoryLogReader(const SharedMemoryLogReader&);
+			SharedMemoryLogReader& operator=(const SharedMemoryLogReader&);
+		};
+    }
+}
+
+#endif
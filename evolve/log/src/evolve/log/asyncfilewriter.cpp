@@ -0,0 +1,522 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/asyncfilewriter.cpp
+ * \brief evolve/log background file writer, io_uring or thread pool
+ * \author
+ *
+ */
+
+#include <evolve/log/asyncfilewriter.h>
+#include <evolve/utils/threadutils.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+
+#ifdef WIN32
+#include <io.h>
+#include <sys/stat.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include <chrono>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define EVOLVE_LOG_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+#endif
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		/**
+		 * \brief One buffer of the ring
+		 */
+		struct AsyncFileWriter::Buffer {
+			std::string _data; ///< bytes to write
+			unsigned long long _offset; ///< file offset of _data
+			std::size_t _written; ///< bytes of _data already written
+			std::atomic<bool> _busy; ///< in flight
+#ifdef EVOLVE_LOG_IO_URING
+			struct iovec _vector; ///< remaining bytes, read by the kernel until completion
+#endif
+		};
+
+#ifdef EVOLVE_LOG_IO_URING
+		/**
+		 * \brief Submission and completion queues shared with the kernel
+		 */
+		struct AsyncFileWriter::Ring {
+			int _descriptor;
+			void* _submission; ///< submission ring mapping
+			std::size_t _submissionSize;
+			void* _completion; ///< completion ring mapping, same as _submission with IORING_FEAT_SINGLE_MMAP
+			std::size_t _completionSize;
+			struct io_uring_sqe* _entries;
+			std::size_t _entriesSize;
+			unsigned int* _submissionTail;
+			unsigned int* _submissionMask;
+			unsigned int* _submissionArray;
+			unsigned int* _completionHead;
+			unsigned int* _completionTail;
+			unsigned int* _completionMask;
+			struct io_uring_cqe* _completions;
+		};
+
+		static int Enter(int iRing, unsigned int iSubmit, unsigned int iWait) {
+			int aResult;
+			do {
+				aResult = static_cast<int>(syscall(__NR_io_uring_enter, iRing, iSubmit, iWait, iWait != 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0));
+			} while (aResult < 0 && errno == EINTR);
+			return aResult;
+		}
+
+		AsyncFileWriter::Ring* AsyncFileWriter::CreateRing(unsigned int iEntries) {
+			const char* aEnabled = std::getenv("EVOLVE_LOG_IO_URING");
+			if (aEnabled != NULL && std::strcmp(aEnabled, "0") == 0) {
+				return NULL;
+			}
+
+			struct io_uring_params aParams;
+			std::memset(&aParams, 0, sizeof(aParams));
+			const int aDescriptor = static_cast<int>(syscall(__NR_io_uring_setup, iEntries, &aParams));
+			if (aDescriptor < 0) {
+				return NULL;
+			}
+
+			AsyncFileWriter::Ring* aRing = new AsyncFileWriter::Ring();
+			aRing->_descriptor = aDescriptor;
+			aRing->_submissionSize = aParams.sq_off.array + aParams.sq_entries * sizeof(unsigned int);
+			aRing->_completionSize = aParams.cq_off.cqes + aParams.cq_entries * sizeof(struct io_uring_cqe);
+			if ((aParams.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+				aRing->_submissionSize = aRing->_submissionSize > aRing->_completionSize ? aRing->_submissionSize : aRing->_completionSize;
+				aRing->_completionSize = 0;
+			}
+			aRing->_entriesSize = aParams.sq_entries * sizeof(struct io_uring_sqe);
+
+			aRing->_submission = mmap(NULL, aRing->_submissionSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, aDescriptor, IORING_OFF_SQ_RING);
+			aRing->_completion = aRing->_completionSize == 0 ? aRing->_submission
+				: mmap(NULL, aRing->_completionSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, aDescriptor, IORING_OFF_CQ_RING);
+			void* aEntries = mmap(NULL, aRing->_entriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, aDescriptor, IORING_OFF_SQES);
+			aRing->_entries = aEntries != MAP_FAILED ? static_cast<struct io_uring_sqe*>(aEntries) : NULL;
+			if (aRing->_submission == MAP_FAILED || aRing->_completion == MAP_FAILED || aRing->_entries == NULL) {
+				DestroyRing(aRing);
+				return NULL;
+			}
+
+			char* aSubmission = static_cast<char*>(aRing->_submission);
+			char* aCompletion = static_cast<char*>(aRing->_completion);
+			aRing->_submissionTail = reinterpret_cast<unsigned int*>(aSubmission + aParams.sq_off.tail);
+			aRing->_submissionMask = reinterpret_cast<unsigned int*>(aSubmission + aParams.sq_off.ring_mask);
+			aRing->_submissionArray = reinterpret_cast<unsigned int*>(aSubmission + aParams.sq_off.array);
+			aRing->_completionHead = reinterpret_cast<unsigned int*>(aCompletion + aParams.cq_off.head);
+			aRing->_completionTail = reinterpret_cast<unsigned int*>(aCompletion + aParams.cq_off.tail);
+			aRing->_completionMask = reinterpret_cast<unsigned int*>(aCompletion + aParams.cq_off.ring_mask);
+			aRing->_completions = reinterpret_cast<struct io_uring_cqe*>(aCompletion + aParams.cq_off.cqes);
+			return aRing;
+		}
+
+		void AsyncFileWriter::DestroyRing(Ring* iRing) {
+			if (iRing == NULL) {
+				return;
+			}
+			if (iRing->_entries != NULL) {
+				munmap(iRing->_entries, iRing->_entriesSize);
+			}
+			if (iRing->_completion != MAP_FAILED && iRing->_completion != iRing->_submission) {
+				munmap(iRing->_completion, iRing->_completionSize);
+			}
+			if (iRing->_submission != MAP_FAILED) {
+				munmap(iRing->_submission, iRing->_submissionSize);
+			}
+			::close(iRing->_descriptor);
+			delete iRing;
+		}
+#else
+		struct AsyncFileWriter::Ring {
+		};
+
+		AsyncFileWriter::Ring* AsyncFileWriter::CreateRing(unsigned int iEntries) {
+			return NULL;
+		}
+
+		void AsyncFileWriter::DestroyRing(Ring* iRing) {
+			delete iRing;
+		}
+#endif
+
+		//positional write: buffers in flight never share the file offset
+		static long long WriteAt(int iDescriptor, const char* iData, std::size_t iSize, unsigned long long iOffset) {
+#ifdef WIN32
+			OVERLAPPED aOverlapped;
+			std::memset(&aOverlapped, 0, sizeof(aOverlapped));
+			aOverlapped.Offset = static_cast<DWORD>(iOffset);
+			aOverlapped.OffsetHigh = static_cast<DWORD>(iOffset >> 32);
+			DWORD aWritten = 0;
+			HANDLE aHandle = reinterpret_cast<HANDLE>(_get_osfhandle(iDescriptor));
+			return WriteFile(aHandle, iData, static_cast<DWORD>(iSize), &aWritten, &aOverlapped) ? static_cast<long long>(aWritten) : -1;
+#else
+			ssize_t aWritten;
+			do {
+				aWritten = ::pwrite(iDescriptor, iData, iSize, static_cast<off_t>(iOffset));
+			} while (aWritten < 0 && errno == EINTR);
+			return aWritten;
+#endif
+		}
+
+		static bool WriteAllAt(int iDescriptor, const char* iData, std::size_t iSize, unsigned long long iOffset, std::size_t* oWritten = NULL) {
+			while (iSize != 0) {
+				const long long aWritten = WriteAt(iDescriptor, iData, iSize, iOffset);
+				if (aWritten <= 0) {
+					if (aWritten == 0) {
+						errno = EIO;
+					}
+					return false;
+				}
+				iData += aWritten;
+				iSize -= static_cast<std::size_t>(aWritten);
+				iOffset += static_cast<unsigned long long>(aWritten);
+				if (oWritten != NULL) {
+					*oWritten += static_cast<std::size_t>(aWritten);
+				}
+			}
+			return true;
+		}
+
+		static const unsigned long long NoFailure = ~0ULL;
+
+		AsyncFileWriter::AsyncFileWriter(unsigned int iBuffers, std::size_t iCapacity)
+			:_buffers(NULL), _count(iBuffers != 0 ? iBuffers : 1), _descriptor(-1), _offset(0), _failedOffset(NoFailure), _ring(NULL),
+			 _mutex(), _jobCondition(), _doneCondition(), _jobs(), _threads(), _closing(false) {
+			_buffers = new Buffer[_count];
+			for (unsigned int i = 0; i < _count; ++i) {
+				_buffers[i]._data.reserve(iCapacity);
+				_buffers[i]._offset = 0;
+				_buffers[i]._written = 0;
+				_buffers[i]._busy.store(false, std::memory_order_relaxed);
+			}
+
+			//each buffer has at most one write in flight, the queues never overflow
+			_ring = CreateRing(_count);
+			if (_ring == NULL) {
+				const unsigned int aThreads = _count < EVOLVE_LOG_ASYNC_WRITER_THREADS ? _count : EVOLVE_LOG_ASYNC_WRITER_THREADS;
+				for (unsigned int i = 0; i < aThreads; ++i) {
+					_threads.push_back(std::thread(&AsyncFileWriter::loopWrite, this));
+				}
+			}
+		}
+
+		AsyncFileWriter::~AsyncFileWriter() {
+			close();
+			{
+				std::lock_guard<std::mutex> aLock(_mutex);
+				_closing = true;
+				_jobCondition.notify_all();
+			}
+			for (std::size_t i = 0; i < _threads.size(); ++i) {
+				_threads[i].join();
+			}
+			DestroyRing(_ring);
+			delete[] _buffers;
+		}
+
+		bool AsyncFileWriter::open(const char* iPath) {
+			close();
+#ifdef WIN32
+			_descriptor = _open(iPath, _O_WRONLY | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+			const long long aEnd = _descriptor >= 0 ? _lseeki64(_descriptor, 0, SEEK_END) : -1;
+#else
+			_descriptor = ::open(iPath, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+			const long long aEnd = _descriptor >= 0 ? static_cast<long long>(::lseek(_descriptor, 0, SEEK_END)) : -1;
+#endif
+			if (aEnd < 0) {
+				std::cerr << "Can't open log file " << iPath << std::endl;
+				close();
+				return false;
+			}
+			_offset = static_cast<unsigned long long>(aEnd);
+			_failedOffset.store(NoFailure, std::memory_order_relaxed);
+			return true;
+		}
+
+		void AsyncFileWriter::close() {
+			wait();
+			if (_descriptor >= 0) {
+#ifdef WIN32
+				_close(_descriptor);
+#else
+				::close(_descriptor);
+#endif
+				_descriptor = -1;
+			}
+		}
+
+		void AsyncFileWriter::write(std::string& ioBuffer) {
+			//after a failure the offsets stop advancing, what follows would land after a hole
+			if (ioBuffer.empty() || _descriptor < 0 || hasFailed()) {
+				ioBuffer.clear();
+				return;
+			}
+			const unsigned int aIndex = acquire();
+			Buffer& aBuffer = _buffers[aIndex];
+			aBuffer._data.swap(ioBuffer);
+			ioBuffer.clear();
+			aBuffer._offset = _offset;
+			aBuffer._written = 0;
+			_offset += aBuffer._data.size();
+			aBuffer._busy.store(true, std::memory_order_release);
+			submit(aIndex);
+		}
+
+		void AsyncFileWriter::wait() {
+			for (unsigned int i = 0; i < _count; ++i) {
+				waitFree(i);
+			}
+
+			//writes queued after the failed one may have landed: cut them, with the hole
+			const unsigned long long aFailedOffset = _failedOffset.load(std::memory_order_acquire);
+			if (aFailedOffset != NoFailure && _descriptor >= 0) {
+#ifdef WIN32
+				const bool aCut = _chsize_s(_descriptor, static_cast<long long>(aFailedOffset)) == 0;
+#else
+				const bool aCut = ::ftruncate(_descriptor, static_cast<off_t>(aFailedOffset)) == 0;
+#endif
+				if (!aCut) {
+					std::cerr << "Can't truncate log file after a failed write: " << std::strerror(errno) << std::endl;
+				}
+				_offset = aFailedOffset;
+			}
+		}
+
+		bool AsyncFileWriter::hasFailed() const {
+			return _failedOffset.load(std::memory_order_acquire) != NoFailure;
+		}
+
+		void AsyncFileWriter::emergencyWrite(const char* iData, std::size_t iSize) {
+			if (_descriptor < 0) {
+				return;
+			}
+			for (unsigned int i = 0; i < _count; ++i) {
+				const Buffer& aBuffer = _buffers[i];
+				if (aBuffer._busy.load(std::memory_order_acquire)) {
+					WriteAllAt(_descriptor, aBuffer._data.data(), aBuffer._data.size(), aBuffer._offset);
+				}
+			}
+			WriteAllAt(_descriptor, iData, iSize, _offset);
+			_offset += iSize;
+		}
+
+		bool AsyncFileWriter::isUring() const {
+			return _ring != NULL;
+		}
+
+		unsigned int AsyncFileWriter::acquire() {
+			reap(false);
+			for (unsigned int i = 0; i < _count; ++i) {
+				if (isFree(i)) {
+					return i;
+				}
+			}
+			//every buffer in flight: the disk is behind, only now block
+			waitFree(_count);
+			for (unsigned int i = 0; i < _count; ++i) {
+				if (isFree(i)) {
+					return i;
+				}
+			}
+			return 0;
+		}
+
+		bool AsyncFileWriter::isFree(unsigned int iIndex) const {
+			if (iIndex < _count) {
+				return !_buffers[iIndex]._busy.load(std::memory_order_acquire);
+			}
+			for (unsigned int i = 0; i < _count; ++i) {
+				if (!_buffers[i]._busy.load(std::memory_order_acquire)) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void AsyncFileWriter::waitFree(unsigned int iIndex) {
+			if (_ring != NULL) {
+				//the kernel reads the buffers until completion: never give up on them
+				bool aReported = false;
+				while (!isFree(iIndex)) {
+					if (!reap(true)) {
+						if (!aReported) {
+							std::cerr << "Can't wait for log writes: " << std::strerror(errno) << ", polling" << std::endl;
+							aReported = true;
+						}
+						std::this_thread::sleep_for(std::chrono::milliseconds(1));
+						reap(false);
+					}
+				}
+				return;
+			}
+			//pool threads clear _busy under the mutex, so a completion can't be missed
+			std::unique_lock<std::mutex> aLock(_mutex);
+			while (!isFree(iIndex)) {
+				_doneCondition.wait(aLock);
+			}
+		}
+
+		void AsyncFileWriter::submit(unsigned int iIndex) {
+			Buffer& aBuffer = _buffers[iIndex];
+#ifdef EVOLVE_LOG_IO_URING
+			if (_ring != NULL) {
+				aBuffer._vector.iov_base = &aBuffer._data[aBuffer._written];
+				aBuffer._vector.iov_len = aBuffer._data.size() - aBuffer._written;
+
+				//only this thread produces submissions
+				const unsigned int aTail = *_ring->_submissionTail;
+				const unsigned int aSlot = aTail & *_ring->_submissionMask;
+				struct io_uring_sqe& aEntry = _ring->_entries[aSlot];
+				std::memset(&aEntry, 0, sizeof(aEntry));
+				aEntry.opcode = IORING_OP_WRITEV;
+				aEntry.fd = _descriptor;
+				aEntry.addr = reinterpret_cast<unsigned long long>(&aBuffer._vector);
+				aEntry.len = 1;
+				aEntry.off = aBuffer._offset + aBuffer._written;
+				aEntry.user_data = iIndex;
+				_ring->_submissionArray[aSlot] = aSlot;
+				__atomic_store_n(_ring->_submissionTail, aTail + 1, __ATOMIC_RELEASE);
+				if (Enter(_ring->_descriptor, 1, 0) < 0) {
+					//nothing was consumed: take the entry back and write on this thread
+					__atomic_store_n(_ring->_submissionTail, aTail, __ATOMIC_RELEASE);
+					if (!WriteAllAt(_descriptor, aBuffer._data.data() + aBuffer._written, aBuffer._data.size() - aBuffer._written,
+						aBuffer._offset + aBuffer._written, &aBuffer._written)) {
+						fail(aBuffer, errno);
+					}
+					aBuffer._data.clear();
+					aBuffer._busy.store(false, std::memory_order_release);
+				}
+				return;
+			}
+#endif
+			std::lock_guard<std::mutex> aLock(_mutex);
+			_jobs.push_back(iIndex);
+			_jobCondition.notify_one();
+		}
+
+		void AsyncFileWriter::complete(unsigned int iIndex, long long iResult) {
+			Buffer& aBuffer = _buffers[iIndex];
+			if (iResult == -EINTR || iResult == -EAGAIN) {
+				submit(iIndex);
+				return;
+			}
+			if (iResult <= 0) {
+				fail(aBuffer, iResult < 0 ? static_cast<int>(-iResult) : EIO);
+				aBuffer._data.clear();
+				aBuffer._busy.store(false, std::memory_order_release);
+				return;
+			}
+			aBuffer._written += static_cast<std::size_t>(iResult);
+			if (aBuffer._written < aBuffer._data.size()) {
+				submit(iIndex);
+				return;
+			}
+			aBuffer._data.clear();
+			aBuffer._busy.store(false, std::memory_order_release);
+		}
+
+		bool AsyncFileWriter::reap(bool iWait) {
+#ifdef EVOLVE_LOG_IO_URING
+			if (_ring != NULL) {
+				if (iWait && Enter(_ring->_descriptor, 0, 1) < 0) {
+					return false;
+				}
+				unsigned int aHead = *_ring->_completionHead;
+				const unsigned int aTail = __atomic_load_n(_ring->_completionTail, __ATOMIC_ACQUIRE);
+				const bool aReaped = aHead != aTail;
+				while (aHead != aTail) {
+					const struct io_uring_cqe& aCompletion = _ring->_completions[aHead & *_ring->_completionMask];
+					const unsigned int aIndex = static_cast<unsigned int>(aCompletion.user_data);
+					const long long aResult = aCompletion.res;
+					++aHead;
+					__atomic_store_n(_ring->_completionHead, aHead, __ATOMIC_RELEASE);
+					complete(aIndex, aResult);
+				}
+				return aReaped || iWait;
+			}
+#endif
+			return false;
+		}
+
+		void AsyncFileWriter::fail(const Buffer& iBuffer, int iError) {
+			//keep the lowest offset, pool threads may fail concurrently
+			const unsigned long long aOffset = iBuffer._offset + iBuffer._written;
+			unsigned long long aFailedOffset = _failedOffset.load(std::memory_order_relaxed);
+			const bool aFirst = aFailedOffset == NoFailure;
+			while (aOffset < aFailedOffset && !_failedOffset.compare_exchange_weak(aFailedOffset, aOffset, std::memory_order_acq_rel)) {
+			}
+			if (aFirst) {
+				std::cerr << "Can't write log file: " << std::strerror(iError) << ", dropping log lines until the file is reopened" << std::endl;
+			}
+		}
+
+		void AsyncFileWriter::loopWrite() {
+			evolve::utils::SetCurrentThreadName("evolve.writer");
+			while (true) {
+				unsigned int aIndex;
+				{
+					std::unique_lock<std::mutex> aLock(_mutex);
+					while (_jobs.empty() && !_closing) {
+						_jobCondition.wait(aLock);
+					}
+					if (_jobs.empty()) {
+						return;
+					}
+					aIndex = _jobs.front();
+					_jobs.pop_front();
+				}
+
+				Buffer& aBuffer = _buffers[aIndex];
+				if (!WriteAllAt(_descriptor, aBuffer._data.data(), aBuffer._data.size(), aBuffer._offset, &aBuffer._written)) {
+					fail(aBuffer, errno);
+				}
+				aBuffer._data.clear();
+
+				std::lock_guard<std::mutex> aLock(_mutex);
+				aBuffer._busy.store(false, std::memory_order_release);
+				_doneCondition.notify_all();
+			}
+		}
+    }
+}
@@ -0,0 +1,165 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+
+/**
+ * \file evolve/log/binaryfileloggerreporter.cpp
+ * \brief evolve/log compact binary file reporter and reader source file
+ * \author
+ *
+ */
+
+#include <evolve/log/binaryfileloggerreporter.h>
+#include <cstring>
+#include <functional>
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		template <class T>
+		static void AppendValue(std::string& ioBuffer, const T& iValue) {
+			ioBuffer.append(reinterpret_cast<const char*>(&iValue), sizeof(T));
+		}
+
+        BinaryFileLoggerReporter::BinaryFileLoggerReporter(const char* iFile, const FileFlushPolicy& iPolicy)
+                :FileLoggerReporter(iFile, iPolicy, std::ofstream::binary), _stringIds() {
+			std::string aHeader(EVOLVE_BINARY_LOG_MAGIC);
+			AppendValue(aHeader, static_cast<unsigned int>(EVOLVE_BINARY_LOG_VERSION));
+			appendRaw(aHeader.data(), aHeader.size());
+		}
+
+        BinaryFileLoggerReporter::~BinaryFileLoggerReporter() {}
+
+		int BinaryFileLoggerReporter::getEmergencyDescriptor() const {
+			return -1;
+		}
+
+		void BinaryFileLoggerReporter::appendLogMessage(const LogMessage& iLogMessage, std::string& ioBuffer) {
+			//string records must precede the message referencing them
+			const unsigned int aFileId = intern(iLogMessage._file, ioBuffer);
+			const unsigned int aFuncId = intern(iLogMessage._func, ioBuffer);
+
+			ioBuffer += static_cast<char>(BINARY_RECORD_MESSAGE);
+			AppendValue(ioBuffer, iLogMessage._time);
+			AppendValue(ioBuffer, static_cast<unsigned char>(iLogMessage._level));
+			AppendValue(ioBuffer, aFileId);
+			AppendValue(ioBuffer, aFuncId);
+			AppendValue(ioBuffer, static_cast<unsigned int>(iLogMessage._line));
+			AppendValue(ioBuffer, iLogMessage._threadIndex);
+			AppendValue(ioBuffer, static_cast<unsigned long long>(std::hash<std::thread::id>()(iLogMessage._threadId)));
+			AppendValue(ioBuffer, static_cast<unsigned int>(iLogMessage._message.size()));
+			ioBuffer.append(iLogMessage._message.data(), iLogMessage._message.size());
+		}
+
+		unsigned int BinaryFileLoggerReporter::intern(const char* iString, std::string& ioBuffer) {
+			std::unordered_map<const char*, unsigned int>::const_iterator aIt = _stringIds.find(iString);
+			if (aIt != _stringIds.end()) {
+				return aIt->second;
+			}
+
+			const unsigned int aId = static_cast<unsigned int>(_stringIds.size());
+			_stringIds[iString] = aId;
+
+			const std::size_t aLength = iString != NULL ? std::strlen(iString) : 0;
+			const unsigned short aShortLength = static_cast<unsigned short>(aLength < 0xFFFF ? aLength : 0xFFFF);
+			ioBuffer += static_cast<char>(BINARY_RECORD_STRING);
+			AppendValue(ioBuffer, aId);
+			AppendValue(ioBuffer, aShortLength);
+			ioBuffer.append(iString != NULL ? iString : "", aShortLength);
+			return aId;
+		}
+
+		BinaryLogReader::BinaryLogReader(const char* iFile)
+			:_stream(iFile, std::ifstream::in | std::ifstream::binary), _strings() {}
+
+		BinaryLogReader::~BinaryLogReader() {}
+
+		bool BinaryLogReader::isOpen() const {
+			return _stream.is_open();
+		}
+
+		bool BinaryLogReader::next(BinaryLogRecord& oRecord) {
+			static const std::size_t aMagicLength = std::strlen(EVOLVE_BINARY_LOG_MAGIC);
+
+			char aType;
+			while (_stream.get(aType)) {
+				if (aType == EVOLVE_BINARY_LOG_MAGIC[0]) {
+					//new session, interned ids restart
+					std::string aMagic;
+					unsigned int aVersion;
+					if (!readString(aMagic, aMagicLength - 1) || aMagic != EVOLVE_BINARY_LOG_MAGIC + 1
+						|| !read(aVersion) || aVersion != EVOLVE_BINARY_LOG_VERSION) {
+						return false;
+					}
+					_strings.clear();
+				}
+				else if (aType == BINARY_RECORD_STRING) {
+					unsigned int aId;
+					unsigned short aLength;
+					if (!read(aId) || !read(aLength)) {
+						return false;
+					}
+					if (aId >= _strings.size()) {
+						_strings.resize(aId + 1);
+					}
+					if (!readString(_strings[aId], aLength)) {
+						return false;
+					}
+				}
+				else if (aType == BINARY_RECORD_MESSAGE) {
+					unsigned char aLevel;
+					unsigned int aFileId, aFuncId, aLength;
+					if (!read(oRecord._time) || !read(aLevel) || !read(aFileId) || !read(aFuncId)
+						|| !read(oRecord._line) || !read(oRecord._threadIndex) || !read(oRecord._threadId)
+						|| !read(aLength) || !readString(oRecord._message, aLength)) {
+						return false;
+					}
+					oRecord._level = static_cast<LogLevel>(aLevel);
+					oRecord._file = lookup(aFileId);
+					oRecord._func = lookup(aFuncId);
+					return true;
+				}
+				else {
+					return false;
+				}
+			}
+			return false;
+		}
+
+		bool BinaryLogReader::readString(std::string& oString, std::size_t iLength) {
+			oString.resize(iLength);
+			return iLength == 0 || static_cast<bool>(_stream.read(&oString[0], iLength));
+		}
+
+		const std::string& BinaryLogReader::lookup(unsigned int iId) const {
+			static const std::string aUnknown("?");
+			return iId < _strings.size() ? _strings[iId] : aUnknown;
+		}
+    }
+}
@@ -0,0 +1,280 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/emergencywriter.cpp
+ * \brief evolve/log allocation free log line writer for fatal signal handlers
+ * \author
+ *
+ */
+
+#include <evolve/log/emergencywriter.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+
+#ifdef WIN32
+#include <io.h>
+#include <sys/stat.h>
+#include <windows.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		//same strings as Logger::_LogLevelStringMap, which is a vector of std::string
+		static const char* const EmergencyLevelNames[] = { "DEBUG", "INFO", "WARNING", "ERROR", "CRITICAL", "OFF" };
+
+		EmergencyWriter::EmergencyWriter()
+			:_clock(), _size(0) {
+			new (_message) LogMessage();
+		}
+
+		void EmergencyWriter::write(const LogMessage& iLogMessage, int iDescriptor) {
+			if (iDescriptor < 0) {
+				return;
+			}
+
+			_size = 0;
+			char aTime[32];
+			append("[");
+			append(aTime, _clock.formatDateAndTime(iLogMessage._time, aTime));
+			append(" | Thread: ");
+			appendNumber(iLogMessage._threadIndex);
+			append(" | ");
+			append(iLogMessage._file);
+			append("#");
+			appendNumber(iLogMessage._line);
+			append(" > ");
+			append(iLogMessage._func);
+			append(" | ");
+			append(iLogMessage._level <= LEVEL_OFF ? EmergencyLevelNames[iLogMessage._level] : "?");
+			append("] ");
+
+			if (iLogMessage._format == NULL) {
+				append(iLogMessage._message.data(), iLogMessage._message.size());
+			}
+			else if (!iLogMessage._fields.empty()) {
+				append(iLogMessage._format);
+			}
+			else {
+				//replace each "{}" by the next argument, as LogArguments::format does
+				std::size_t aOffset = 0;
+				LogArgument aArgument;
+				for (const char* aIt = iLogMessage._format; *aIt != '\0'; ++aIt) {
+					if (aIt[0] == '{' && aIt[1] == '}') {
+						if (iLogMessage._arguments.read(aOffset, aArgument)) {
+							appendArgument(aArgument);
+						}
+						else {
+							append("{}");
+						}
+						++aIt;
+					}
+					else {
+						append(aIt, 1);
+					}
+				}
+			}
+
+			std::size_t aIndex = 0;
+			std::size_t aOffset = 0;
+			LogField aField;
+			while (iLogMessage._fields.read(aIndex, aOffset, aField)) {
+				append(" ");
+				append(aField._key);
+				append("=");
+				appendArgument(aField._value);
+			}
+
+			//always room for the new line, a truncated line still ends the record
+			if (_size == sizeof(_line)) {
+				--_size;
+			}
+			_line[_size++] = '\n';
+			Write(iDescriptor, _line, _size);
+		}
+
+		const LogMessage* EmergencyWriter::pop(evolve::utils::SpscRingBuffer<LogMessage>& ioQueue) {
+			//the previous message is overwritten without its destructor, a default message owns no memory
+			LogMessage* aMessage = new (_message) LogMessage();
+			return ioQueue.popBulk(aMessage, 1) == 1 ? aMessage : NULL;
+		}
+
+		void EmergencyWriter::append(const char* iText, std::size_t iLength) {
+			const std::size_t aRoom = sizeof(_line) - _size;
+			const std::size_t aLength = iLength < aRoom ? iLength : aRoom;
+			std::memcpy(_line + _size, iText, aLength);
+			_size += aLength;
+		}
+
+		void EmergencyWriter::append(const char* iText) {
+			if (iText != NULL) {
+				append(iText, std::strlen(iText));
+			}
+		}
+
+		void EmergencyWriter::appendNumber(unsigned long long iValue) {
+			char aDigits[20];
+			std::size_t aCount = 0;
+			do {
+				aDigits[sizeof(aDigits) - ++aCount] = static_cast<char>('0' + iValue % 10);
+				iValue /= 10;
+			} while (iValue != 0);
+			append(aDigits + sizeof(aDigits) - aCount, aCount);
+		}
+
+		void EmergencyWriter::appendArgument(const LogArgument& iArgument) {
+			switch (iArgument._type) {
+			case ARGUMENT_INT:
+				if (iArgument._int < 0) {
+					append("-");
+					appendNumber(0ULL - static_cast<unsigned long long>(iArgument._int));
+				}
+				else {
+					appendNumber(static_cast<unsigned long long>(iArgument._int));
+				}
+				break;
+			case ARGUMENT_UINT:
+				appendNumber(iArgument._uint);
+				break;
+			case ARGUMENT_DOUBLE: {
+				//fixed notation with 6 decimals, no locale nor stdio in a signal handler
+				double aValue = iArgument._double;
+				if (aValue != aValue) {
+					append("nan");
+					break;
+				}
+				if (aValue < 0.0) {
+					append("-");
+					aValue = -aValue;
+				}
+				if (aValue >= 1e19) {
+					append("inf");
+					break;
+				}
+				unsigned long long aInteger = static_cast<unsigned long long>(aValue);
+				unsigned long long aFraction = static_cast<unsigned long long>((aValue - static_cast<double>(aInteger)) * 1e6 + 0.5);
+				if (aFraction >= 1000000ULL) {
+					++aInteger;
+					aFraction -= 1000000ULL;
+				}
+				appendNumber(aInteger);
+				append(".");
+				char aDigits[6];
+				for (int i = 5; i >= 0; --i) {
+					aDigits[i] = static_cast<char>('0' + aFraction % 10);
+					aFraction /= 10;
+				}
+				append(aDigits, sizeof(aDigits));
+				break;
+			}
+			case ARGUMENT_BOOL:
+				append(iArgument._bool ? "true" : "false");
+				break;
+			case ARGUMENT_CHAR:
+				append(&iArgument._char, 1);
+				break;
+			case ARGUMENT_POINTER: {
+				static const char aHex[] = "0123456789abcdef";
+				char aDigits[2 + 2 * sizeof(void*)];
+				std::uintptr_t aValue = reinterpret_cast<std::uintptr_t>(iArgument._pointer);
+				aDigits[0] = '0';
+				aDigits[1] = 'x';
+				for (std::size_t i = sizeof(aDigits) - 1; i >= 2; --i) {
+					aDigits[i] = aHex[aValue & 0xF];
+					aValue >>= 4;
+				}
+				append(aDigits, sizeof(aDigits));
+				break;
+			}
+			case ARGUMENT_STRING:
+				append(iArgument._string, iArgument._length);
+				break;
+			}
+		}
+
+		bool EmergencyWriter::Write(int iDescriptor, const char* iData, std::size_t iSize) {
+			if (iDescriptor < 0) {
+				return false;
+			}
+			while (iSize != 0) {
+#ifdef WIN32
+				const int aWritten = _write(iDescriptor, iData, static_cast<unsigned int>(iSize));
+#else
+				const ssize_t aWritten = ::write(iDescriptor, iData, iSize);
+#endif
+				if (aWritten < 0) {
+					if (errno == EINTR) {
+						continue;
+					}
+					return false;
+				}
+				iData += aWritten;
+				iSize -= static_cast<std::size_t>(aWritten);
+			}
+			return true;
+		}
+
+		int EmergencyWriter::Open(const char* iPath) {
+#ifdef WIN32
+			return _open(iPath, _O_WRONLY | _O_APPEND | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+			return ::open(iPath, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+#endif
+		}
+
+		void EmergencyWriter::Close(int iDescriptor) {
+			if (iDescriptor < 0) {
+				return;
+			}
+#ifdef WIN32
+			_close(iDescriptor);
+#else
+			::close(iDescriptor);
+#endif
+		}
+
+		void EmergencyWriter::Sleep(unsigned int iMilliseconds) {
+#ifdef WIN32
+			::Sleep(iMilliseconds);
+#else
+			struct timespec aDuration;
+			aDuration.tv_sec = iMilliseconds / 1000;
+			aDuration.tv_nsec = static_cast<long>(iMilliseconds % 1000) * 1000000L;
+			while (nanosleep(&aDuration, &aDuration) != 0 && errno == EINTR) {}
+#endif
+		}
+    }
+}
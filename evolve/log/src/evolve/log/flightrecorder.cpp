@@ -0,0 +1,343 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/flightrecorder.cpp
+ * \brief evolve/log per-thread in-memory flight recorder
+ * \author
+ *
+ */
+
+#include <evolve/log/flightrecorder.h>
+#include <evolve/log/emergencywriter.h>
+#include <evolve/utils/threadutils.h>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		/**
+		 * \brief One recorded message, only static strings are referenced
+		 */
+		struct FlightRecord {
+			unsigned long long _time;
+			const char* _file;
+			const char* _func;
+			const char* _format; ///< NULL for a text message
+			unsigned int _line;
+			unsigned int _threadIndex;
+			unsigned char _level;
+			unsigned char _size; ///< text length
+			///raw arguments of a deferred message, or text truncated short enough to stay inline in a LogMessage
+			alignas(LogArguments) char _payload[sizeof(LogArguments) > EVOLVE_LOG_INLINE_TEXT_SIZE - 1 ? sizeof(LogArguments) : EVOLVE_LOG_INLINE_TEXT_SIZE - 1];
+		};
+
+		/**
+		 * \brief Recorded message guarded by a sequence lock
+		 *
+		 * _sequence is 2 * position + 1 while the message at this position is
+		 * written, 2 * position + 2 once it is complete.
+		 */
+		struct FlightSlot {
+			std::atomic<unsigned long long> _sequence;
+			FlightRecord _record;
+		};
+
+		/**
+		 * \brief Circular buffer of one thread, written by this thread only
+		 */
+		struct FlightThread {
+			std::size_t _capacity; ///< number of slots
+			std::atomic<unsigned long long> _count; ///< messages recorded so far
+			FlightSlot* _slots;
+		};
+
+		/**
+		 * \brief Dump position in the buffer of one thread
+		 */
+		struct FlightCursor {
+			unsigned long long _next; ///< next position to write
+			unsigned long long _end; ///< count when the dump started
+			unsigned long long _time; ///< time of the record at _next
+		};
+
+		//recorders are indexed by thread index and never freed, a dump can run at any time;
+		//an index recycled by a new thread takes the recorder, and the records, of the exited one
+		static std::atomic<FlightThread*> Recorders[EVOLVE_THREAD_REGISTRY_SIZE];
+		static std::atomic<std::size_t> RecorderSize(EVOLVE_LOG_FLIGHT_RECORDER_SIZE);
+		static std::atomic<int> DumpDescriptor(2);
+		static std::atomic<bool> DumpOpened(false);
+		static std::atomic<bool> Dumping(false);
+		static std::atomic<unsigned long long> DumpedTime(0);
+
+		//dump state, serialised by Dumping: nothing large on the stack of a signal handler
+		static FlightCursor DumpCursors[EVOLVE_THREAD_REGISTRY_SIZE];
+		static FlightRecord DumpRecord;
+		static EmergencyWriter DumpOutput;
+
+		static FlightThread* LocalRecorder(unsigned int iThreadIndex) {
+			//the cache is checked against the index, an exiting thread loses its index before its last records
+			static thread_local FlightThread* aRecorder = NULL;
+			static thread_local unsigned int aRecorderIndex = EVOLVE_THREAD_REGISTRY_SIZE;
+			if (iThreadIndex == aRecorderIndex) {
+				return aRecorder;
+			}
+			if (iThreadIndex >= EVOLVE_THREAD_REGISTRY_SIZE) {
+				return NULL;
+			}
+			aRecorderIndex = iThreadIndex;
+			aRecorder = Recorders[iThreadIndex].load(std::memory_order_acquire);
+			if (aRecorder == NULL) {
+				std::size_t aCapacity = RecorderSize.load(std::memory_order_relaxed) / sizeof(FlightSlot);
+				aCapacity = aCapacity != 0 ? aCapacity : 1;
+				aRecorder = new FlightThread();
+				aRecorder->_capacity = aCapacity;
+				aRecorder->_count.store(0, std::memory_order_relaxed);
+				aRecorder->_slots = new FlightSlot[aCapacity]();
+				Recorders[iThreadIndex].store(aRecorder, std::memory_order_release);
+			}
+			return aRecorder;
+		}
+
+		static bool ReadTime(const FlightThread& iRecorder, unsigned long long iPosition, unsigned long long& oTime) {
+			const FlightSlot& aSlot = iRecorder._slots[iPosition % iRecorder._capacity];
+			const unsigned long long aSequence = 2 * iPosition + 2;
+			if (aSlot._sequence.load(std::memory_order_acquire) != aSequence) {
+				return false;
+			}
+			oTime = aSlot._record._time;
+			std::atomic_thread_fence(std::memory_order_acquire);
+			return aSlot._sequence.load(std::memory_order_relaxed) == aSequence;
+		}
+
+		static bool ReadRecord(const FlightThread& iRecorder, unsigned long long iPosition, FlightRecord& oRecord) {
+			const FlightSlot& aSlot = iRecorder._slots[iPosition % iRecorder._capacity];
+			const unsigned long long aSequence = 2 * iPosition + 2;
+			if (aSlot._sequence.load(std::memory_order_acquire) != aSequence) {
+				return false;
+			}
+			std::memcpy(&oRecord, &aSlot._record, sizeof(FlightRecord));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			return aSlot._sequence.load(std::memory_order_relaxed) == aSequence;
+		}
+
+		//skip the records overwritten since the dump started, and the ones already dumped
+		static void Advance(const FlightThread& iRecorder, FlightCursor& ioCursor, unsigned long long iAfter) {
+			while (ioCursor._next < ioCursor._end) {
+				if (ReadTime(iRecorder, ioCursor._next, ioCursor._time) && ioCursor._time > iAfter) {
+					return;
+				}
+				++ioCursor._next;
+			}
+		}
+
+		static void AppendNumber(char* ioLine, std::size_t& ioSize, std::size_t iCapacity, unsigned long long iValue) {
+			char aDigits[20];
+			std::size_t aCount = 0;
+			do {
+				aDigits[aCount++] = static_cast<char>('0' + iValue % 10);
+				iValue /= 10;
+			} while (iValue != 0);
+			while (aCount != 0 && ioSize < iCapacity) {
+				ioLine[ioSize++] = aDigits[--aCount];
+			}
+		}
+
+		static void AppendText(char* ioLine, std::size_t& ioSize, std::size_t iCapacity, const char* iText) {
+			for (; iText != NULL && *iText != '\0' && ioSize < iCapacity; ++iText) {
+				ioLine[ioSize++] = *iText;
+			}
+		}
+
+		static void WriteBanner(int iDescriptor, const char* iText, const char* iReason, std::size_t iCount) {
+			char aLine[256];
+			std::size_t aSize = 0;
+			AppendText(aLine, aSize, sizeof(aLine) - 1, "---- flight recorder ");
+			AppendText(aLine, aSize, sizeof(aLine) - 1, iText);
+			if (iReason != NULL) {
+				AppendText(aLine, aSize, sizeof(aLine) - 1, iReason);
+			}
+			else {
+				AppendNumber(aLine, aSize, sizeof(aLine) - 1, iCount);
+				AppendText(aLine, aSize, sizeof(aLine) - 1, " messages");
+			}
+			AppendText(aLine, aSize, sizeof(aLine) - 1, " ----");
+			aLine[aSize++] = '\n';
+			EmergencyWriter::Write(iDescriptor, aLine, aSize);
+		}
+
+		void FlightRecorder::Enable(LogLevel iLevel, std::size_t iSize) {
+			RecorderSize.store(iSize, std::memory_order_relaxed);
+			Logger::_RecordLevel.store(static_cast<int>(iLevel), std::memory_order_relaxed);
+		}
+
+		void FlightRecorder::Disable() {
+			Logger::_RecordLevel.store(static_cast<int>(LEVEL_OFF), std::memory_order_relaxed);
+		}
+
+		bool FlightRecorder::SetDumpFile(const char* iPath) {
+			int aDescriptor = 2;
+			if (iPath != NULL) {
+				aDescriptor = EmergencyWriter::Open(iPath);
+				if (aDescriptor < 0) {
+					std::cerr << "Can't open flight recorder dump file " << iPath << std::endl;
+					return false;
+				}
+			}
+			const int aPrevious = DumpDescriptor.exchange(aDescriptor);
+			if (DumpOpened.exchange(iPath != NULL)) {
+				EmergencyWriter::Close(aPrevious);
+			}
+			return true;
+		}
+
+		std::size_t FlightRecorder::Dump(int iDescriptor, const char* iReason) {
+			return Dump(iDescriptor, iReason, false);
+		}
+
+		std::size_t FlightRecorder::Dump(const char* iPath, const char* iReason) {
+			const int aDescriptor = EmergencyWriter::Open(iPath);
+			if (aDescriptor < 0) {
+				std::cerr << "Can't open flight recorder dump file " << iPath << std::endl;
+				return 0;
+			}
+			const std::size_t aCount = Dump(aDescriptor, iReason, false);
+			EmergencyWriter::Close(aDescriptor);
+			return aCount;
+		}
+
+		std::size_t FlightRecorder::DumpAutomatic(const char* iReason) {
+			return Dump(DumpDescriptor.load(), iReason, true);
+		}
+
+		void FlightRecorder::Record(const LogMessage& iLogMessage) {
+			FlightThread* aRecorder = LocalRecorder(iLogMessage._threadIndex);
+			if (aRecorder == NULL) {
+				return;
+			}
+			const unsigned long long aPosition = aRecorder->_count.load(std::memory_order_relaxed);
+			FlightSlot& aSlot = aRecorder->_slots[aPosition % aRecorder->_capacity];
+			aSlot._sequence.store(2 * aPosition + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			FlightRecord& aRecord = aSlot._record;
+			aRecord._time = iLogMessage._time;
+			aRecord._file = iLogMessage._file;
+			aRecord._func = iLogMessage._func;
+			aRecord._format = iLogMessage._format;
+			aRecord._line = iLogMessage._line;
+			aRecord._threadIndex = iLogMessage._threadIndex;
+			aRecord._level = static_cast<unsigned char>(iLogMessage._level);
+			if (iLogMessage._format != NULL) {
+				aRecord._size = 0;
+				std::memcpy(aRecord._payload, &iLogMessage._arguments, sizeof(LogArguments));
+			}
+			else {
+				const std::size_t aSize = iLogMessage._message.size() < EVOLVE_LOG_INLINE_TEXT_SIZE - 1 ? iLogMessage._message.size() : EVOLVE_LOG_INLINE_TEXT_SIZE - 1;
+				std::memcpy(aRecord._payload, iLogMessage._message.data(), aSize);
+				aRecord._size = static_cast<unsigned char>(aSize);
+			}
+
+			aSlot._sequence.store(2 * aPosition + 2, std::memory_order_release);
+			aRecorder->_count.store(aPosition + 1, std::memory_order_release);
+		}
+
+		std::size_t FlightRecorder::Dump(int iDescriptor, const char* iReason, bool iNewOnly) {
+			if (iDescriptor < 0 || Dumping.exchange(true, std::memory_order_acquire)) {
+				return 0;
+			}
+
+			WriteBanner(iDescriptor, "dump: ", iReason != NULL ? iReason : "on request", 0);
+
+			//only the records present when the dump starts: a busy thread can't make it endless
+			const unsigned long long aAfter = iNewOnly ? DumpedTime.load(std::memory_order_relaxed) : 0;
+			for (std::size_t t = 0; t < EVOLVE_THREAD_REGISTRY_SIZE; ++t) {
+				FlightCursor& aCursor = DumpCursors[t];
+				const FlightThread* aRecorder = Recorders[t].load(std::memory_order_acquire);
+				aCursor._next = 0;
+				aCursor._end = 0;
+				if (aRecorder != NULL) {
+					aCursor._end = aRecorder->_count.load(std::memory_order_acquire);
+					aCursor._next = aCursor._end > aRecorder->_capacity ? aCursor._end - aRecorder->_capacity : 0;
+					Advance(*aRecorder, aCursor, aAfter);
+				}
+			}
+
+			//merge the threads by time, each buffer is already ordered
+			std::size_t aCount = 0;
+			unsigned long long aLastTime = aAfter;
+			for (;;) {
+				std::size_t aOldest = EVOLVE_THREAD_REGISTRY_SIZE;
+				for (std::size_t t = 0; t < EVOLVE_THREAD_REGISTRY_SIZE; ++t) {
+					const FlightCursor& aCursor = DumpCursors[t];
+					if (aCursor._next < aCursor._end && (aOldest == EVOLVE_THREAD_REGISTRY_SIZE || aCursor._time < DumpCursors[aOldest]._time)) {
+						aOldest = t;
+					}
+				}
+				if (aOldest == EVOLVE_THREAD_REGISTRY_SIZE) {
+					break;
+				}
+
+				FlightCursor& aCursor = DumpCursors[aOldest];
+				const FlightThread& aRecorder = *Recorders[aOldest].load(std::memory_order_acquire);
+				if (ReadRecord(aRecorder, aCursor._next, DumpRecord)) {
+					//static strings and inline text only, the message owns no memory
+					LogMessage aLogMessage;
+					aLogMessage._level = static_cast<LogLevel>(DumpRecord._level);
+					aLogMessage._time = DumpRecord._time;
+					aLogMessage._file = DumpRecord._file;
+					aLogMessage._line = DumpRecord._line;
+					aLogMessage._func = DumpRecord._func;
+					aLogMessage._threadIndex = DumpRecord._threadIndex;
+					aLogMessage._format = DumpRecord._format;
+					if (DumpRecord._format != NULL) {
+						std::memcpy(&aLogMessage._arguments, DumpRecord._payload, sizeof(LogArguments));
+					}
+					else {
+						aLogMessage._message.assign(DumpRecord._payload, DumpRecord._size);
+					}
+					DumpOutput.write(aLogMessage, iDescriptor);
+					aLastTime = aLastTime > DumpRecord._time ? aLastTime : DumpRecord._time;
+					++aCount;
+				}
+				++aCursor._next;
+				Advance(aRecorder, aCursor, aAfter);
+			}
+
+			WriteBanner(iDescriptor, "end: ", NULL, aCount);
+			if (iNewOnly) {
+				DumpedTime.store(aLastTime, std::memory_order_relaxed);
+			}
+			Dumping.store(false, std::memory_order_release);
+			return aCount;
+		}
+    }
+}
@@ -0,0 +1,200 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/jsonlinesloggerreporter.cpp
+ * \brief evolve/log JSON lines file reporter source file
+ * \author
+ *
+ */
+
+#include <evolve/log/jsonlinesloggerreporter.h>
+#include <evolve/utils/threadutils.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		static void AppendUInt(std::string& ioBuffer, unsigned long long iValue) {
+			char aDigits[20];
+			std::size_t aCount = 0;
+			do {
+				aDigits[aCount++] = static_cast<char>('0' + iValue % 10);
+				iValue /= 10;
+			} while (iValue != 0);
+			while (aCount != 0) {
+				ioBuffer += aDigits[--aCount];
+			}
+		}
+
+		static void AppendInt(std::string& ioBuffer, long long iValue) {
+			if (iValue < 0) {
+				ioBuffer += '-';
+				//negate in unsigned arithmetic, LLONG_MIN has no positive counterpart
+				AppendUInt(ioBuffer, 0ULL - static_cast<unsigned long long>(iValue));
+				return;
+			}
+			AppendUInt(ioBuffer, static_cast<unsigned long long>(iValue));
+		}
+
+		static void AppendDouble(std::string& ioBuffer, double iValue) {
+			//JSON has no NaN nor infinity
+			if (!std::isfinite(iValue)) {
+				ioBuffer += "null";
+				return;
+			}
+			char aNumber[32];
+			const int aLength = std::snprintf(aNumber, sizeof(aNumber), "%.17g", iValue);
+			ioBuffer.append(aNumber, aLength > 0 ? static_cast<std::size_t>(aLength) : 0);
+		}
+
+		static void AppendString(std::string& ioBuffer, const char* iText, std::size_t iLength) {
+			static const char HEX[] = "0123456789abcdef";
+			ioBuffer += '"';
+			for (std::size_t i = 0; i < iLength; ++i) {
+				const unsigned char aChar = static_cast<unsigned char>(iText[i]);
+				switch (aChar) {
+				case '"': ioBuffer += "\\\""; break;
+				case '\\': ioBuffer += "\\\\"; break;
+				case '\n': ioBuffer += "\\n"; break;
+				case '\r': ioBuffer += "\\r"; break;
+				case '\t': ioBuffer += "\\t"; break;
+				default:
+					if (aChar < 0x20) {
+						ioBuffer += "\\u00";
+						ioBuffer += HEX[aChar >> 4];
+						ioBuffer += HEX[aChar & 0xF];
+					}
+					else {
+						ioBuffer += static_cast<char>(aChar);
+					}
+					break;
+				}
+			}
+			ioBuffer += '"';
+		}
+
+		static void AppendString(std::string& ioBuffer, const char* iText) {
+			if (iText == NULL) {
+				ioBuffer += "null";
+				return;
+			}
+			AppendString(ioBuffer, iText, std::strlen(iText));
+		}
+
+		static void AppendValue(std::string& ioBuffer, const LogArgument& iValue) {
+			switch (iValue._type) {
+			case ARGUMENT_INT:
+				AppendInt(ioBuffer, iValue._int);
+				break;
+			case ARGUMENT_UINT:
+				AppendUInt(ioBuffer, iValue._uint);
+				break;
+			case ARGUMENT_DOUBLE:
+				AppendDouble(ioBuffer, iValue._double);
+				break;
+			case ARGUMENT_BOOL:
+				ioBuffer += iValue._bool ? "true" : "false";
+				break;
+			case ARGUMENT_CHAR:
+				AppendString(ioBuffer, &iValue._char, 1);
+				break;
+			case ARGUMENT_POINTER: {
+				char aPointer[32];
+				const int aLength = std::snprintf(aPointer, sizeof(aPointer), "%p", iValue._pointer);
+				AppendString(ioBuffer, aPointer, aLength > 0 ? static_cast<std::size_t>(aLength) : 0);
+				break;
+			}
+			case ARGUMENT_STRING:
+				AppendString(ioBuffer, iValue._string, iValue._length);
+				break;
+			}
+		}
+
+		JsonLinesLoggerReporter::JsonLinesLoggerReporter(const char* iFile, const FileFlushPolicy& iPolicy)
+			:FileLoggerReporter(iFile, iPolicy), _jsonClock(6), _threadName() {
+		}
+
+		JsonLinesLoggerReporter::~JsonLinesLoggerReporter() {
+		}
+
+		int JsonLinesLoggerReporter::getEmergencyDescriptor() const {
+			return -1;
+		}
+
+		void JsonLinesLoggerReporter::appendLogMessage(const LogMessage& iLogMessage, std::string& ioBuffer) {
+			char aTime[32];
+			const std::size_t aTimeLength = _jsonClock.formatDateAndTime(iLogMessage._time, aTime);
+
+			ioBuffer += "{\"time\":";
+			AppendString(ioBuffer, aTime, aTimeLength);
+			ioBuffer += ",\"time_ns\":";
+			AppendUInt(ioBuffer, iLogMessage._time);
+			ioBuffer += ",\"level\":";
+			AppendString(ioBuffer, Logger::_LogLevelStringMap[iLogMessage._level].c_str());
+			ioBuffer += ",\"thread\":";
+			AppendUInt(ioBuffer, iLogMessage._threadIndex);
+			if (evolve::utils::GetThreadName(iLogMessage._threadIndex, _threadName)) {
+				ioBuffer += ",\"thread_name\":";
+				AppendString(ioBuffer, _threadName.data(), _threadName.size());
+			}
+			if (iLogMessage._channel != CHANNEL_DEFAULT) {
+				ioBuffer += ",\"channel\":";
+				AppendString(ioBuffer, Logger::GetChannelName(iLogMessage._channel));
+			}
+			ioBuffer += ",\"file\":";
+			AppendString(ioBuffer, iLogMessage._file);
+			ioBuffer += ",\"line\":";
+			AppendUInt(ioBuffer, iLogMessage._line);
+			ioBuffer += ",\"func\":";
+			AppendString(ioBuffer, iLogMessage._func);
+			ioBuffer += ",\"message\":";
+			AppendString(ioBuffer, iLogMessage._message.data(), iLogMessage._message.size());
+
+			if (!iLogMessage._fields.empty()) {
+				ioBuffer += ",\"fields\":{";
+				std::size_t aIndex = 0;
+				std::size_t aOffset = 0;
+				LogField aField;
+				while (iLogMessage._fields.read(aIndex, aOffset, aField)) {
+					if (aIndex > 1) {
+						ioBuffer += ',';
+					}
+					AppendString(ioBuffer, aField._key);
+					ioBuffer += ':';
+					AppendValue(ioBuffer, aField._value);
+				}
+				ioBuffer += '}';
+			}
+			ioBuffer += "}\n";
+		}
+    }
+}
@@ -0,0 +1,143 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+
+/**
+ * \file evolve/log/logarguments.cpp
+ * \brief evolve/log raw argument capture for deferred formatting source file
+ * \author
+ *
+ */
+
+#include <evolve/log/logarguments.h>
+#include <cstdio>
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		bool LogArguments::read(std::size_t& ioOffset, LogArgument& oArgument) const {
+			if (ioOffset >= _size) {
+				return false;
+			}
+
+			oArgument._type = static_cast<LogArgumentType>(_data[ioOffset++]);
+			oArgument._string = NULL;
+			oArgument._length = 0;
+			switch (oArgument._type) {
+			case ARGUMENT_INT:
+				std::memcpy(&oArgument._int, _data + ioOffset, sizeof(oArgument._int));
+				ioOffset += sizeof(oArgument._int);
+				break;
+			case ARGUMENT_UINT:
+				std::memcpy(&oArgument._uint, _data + ioOffset, sizeof(oArgument._uint));
+				ioOffset += sizeof(oArgument._uint);
+				break;
+			case ARGUMENT_DOUBLE:
+				std::memcpy(&oArgument._double, _data + ioOffset, sizeof(oArgument._double));
+				ioOffset += sizeof(oArgument._double);
+				break;
+			case ARGUMENT_BOOL:
+				std::memcpy(&oArgument._bool, _data + ioOffset, sizeof(oArgument._bool));
+				ioOffset += sizeof(oArgument._bool);
+				break;
+			case ARGUMENT_CHAR:
+				oArgument._char = static_cast<char>(_data[ioOffset]);
+				ioOffset += sizeof(char);
+				break;
+			case ARGUMENT_POINTER:
+				std::memcpy(&oArgument._pointer, _data + ioOffset, sizeof(oArgument._pointer));
+				ioOffset += sizeof(oArgument._pointer);
+				break;
+			case ARGUMENT_STRING:
+				oArgument._length = _data[ioOffset++];
+				oArgument._string = reinterpret_cast<const char*>(_data + ioOffset);
+				ioOffset += oArgument._length;
+				break;
+			}
+			return true;
+		}
+
+		void LogArguments::format(const char* iFormat, LogText& oText) const {
+			oText.clear();
+			if (iFormat == NULL) {
+				return;
+			}
+
+			char aNumber[32];
+			std::size_t aOffset = 0;
+			LogArgument aArgument;
+			const char* aCursor = iFormat;
+			while (*aCursor != '\0') {
+				if (aCursor[0] != '{' || aCursor[1] != '}') {
+					//copy the literal text up to the next placeholder at once
+					const char* aLiteral = aCursor++;
+					while (*aCursor != '\0' && (aCursor[0] != '{' || aCursor[1] != '}')) {
+						++aCursor;
+					}
+					oText.append(aLiteral, static_cast<std::size_t>(aCursor - aLiteral));
+					continue;
+				}
+				aCursor += 2;
+
+				if (!read(aOffset, aArgument)) {
+					oText += _truncated ? "..." : "{}";
+					continue;
+				}
+
+				switch (aArgument._type) {
+				case ARGUMENT_INT:
+					std::snprintf(aNumber, sizeof(aNumber), "%lld", aArgument._int);
+					oText += aNumber;
+					break;
+				case ARGUMENT_UINT:
+					std::snprintf(aNumber, sizeof(aNumber), "%llu", aArgument._uint);
+					oText += aNumber;
+					break;
+				case ARGUMENT_DOUBLE:
+					std::snprintf(aNumber, sizeof(aNumber), "%g", aArgument._double);
+					oText += aNumber;
+					break;
+				case ARGUMENT_BOOL:
+					oText += aArgument._bool ? "true" : "false";
+					break;
+				case ARGUMENT_CHAR:
+					oText += aArgument._char;
+					break;
+				case ARGUMENT_POINTER:
+					std::snprintf(aNumber, sizeof(aNumber), "%p", aArgument._pointer);
+					oText += aNumber;
+					break;
+				case ARGUMENT_STRING:
+					oText.append(aArgument._string, aArgument._length);
+					break;
+				}
+			}
+		}
+    }
+}
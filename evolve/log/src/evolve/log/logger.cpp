@@ -30,13 +30,37 @@
 
 
 #include <evolve/log/logger.h>
-#include <evolve/log/loggerReporter.h>
+#include <evolve/log/loggerreporter.h>
+#include <evolve/log/loggersink.h>
+#include <evolve/log/emergencywriter.h>
+#include <evolve/log/flightrecorder.h>
+#include <evolve/log/logsuppressor.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 SINGLETON_IMPL(UniqueSingleton, evolve::log::Logger)
 
 std::vector<std::string> evolve::log::Logger::_LogLevelStringMap{ "DEBUG", "INFO", "WARNING", "ERROR", "CRITICAL", "OFF" };
 
+std::atomic<bool> evolve::log::Logger::_CoarseClock(false);
+
+std::atomic<unsigned int> evolve::log::Logger::_CriticalSyncTimeout(0);
+
+std::atomic<evolve::log::Logger*> evolve::log::Logger::_EmergencyInstance(NULL);
+
+std::atomic<unsigned int> evolve::log::Logger::_CrashTimeout(EVOLVE_LOG_EMERGENCY_TIMEOUT_MS);
+
+std::atomic<int> evolve::log::Logger::_Level(evolve::log::Logger::ParseLevel(std::getenv("EVOLVE_LOG_LEVEL"), evolve::log::LEVEL_DEBUG));
+
+std::atomic<int> evolve::log::Logger::_ChannelLevels[EVOLVE_LOG_MAX_CHANNELS];
+
+std::atomic<int> evolve::log::Logger::_RecordLevel(evolve::log::Logger::ParseLevel(std::getenv("EVOLVE_LOG_RECORDER_LEVEL"), evolve::log::LEVEL_OFF));
+
 /**
  * Namespace for all evolve classes
  */
@@ -46,50 +70,797 @@ namespace evolve {
      */
     namespace log {
 
-        void Logger::attachReporter(LoggerReporter* iReporter) {
-            if(_reporter!=NULL)
-                delete _reporter;
-            _reporter = iReporter;
+		/**
+		 * \brief Staging buffer of one logging thread
+		 */
+		struct Logger::ThreadBuffer {
+			explicit ThreadBuffer(std::size_t iCapacity)
+				:_queue(iCapacity), _retired(false), _dropped(0), _sampleCount(0), _reportedDropped(0) {}
+
+			evolve::utils::SpscRingBuffer<LogMessage> _queue; ///< messages pushed by the owner thread
+			std::atomic<bool> _retired; ///< set when the owner thread exits, the buffer is released once drained
+			std::atomic<unsigned long long> _dropped; ///< messages dropped by the owner thread
+			unsigned int _sampleCount; ///< messages seen while sampling, owner thread only
+			unsigned long long _reportedDropped; ///< part of _dropped already reported, logger thread only
+		};
+
+		/**
+		 * \brief Signals drained by the crash handler
+		 */
+#ifdef WIN32
+		static const int FatalSignals[] = { SIGSEGV, SIGABRT };
+		static const char* const FatalSignalReasons[] = { "Fatal signal SIGSEGV", "Fatal signal SIGABRT" };
+		static void (*PreviousHandlers[2])(int) = { SIG_DFL, SIG_DFL };
+#else
+		static const int FatalSignals[] = { SIGSEGV, SIGABRT, SIGBUS };
+		static const char* const FatalSignalReasons[] = { "Fatal signal SIGSEGV", "Fatal signal SIGABRT", "Fatal signal SIGBUS" };
+		static struct sigaction PreviousActions[3];
+#endif
+		static const std::size_t FatalSignalCount = sizeof(FatalSignals) / sizeof(FatalSignals[0]);
+		static std::atomic<bool> CrashHandlerInstalled(false);
+
+#ifndef WIN32
+		/**
+		 * \brief Alternate signal stack of one thread, released when the thread exits
+		 */
+		struct CrashStack {
+			CrashStack()
+				:_stack(NULL) {
+			}
+			~CrashStack() {
+				if (_stack != NULL) {
+					stack_t aDisabled;
+					aDisabled.ss_sp = NULL;
+					aDisabled.ss_size = 0;
+					aDisabled.ss_flags = SS_DISABLE;
+					sigaltstack(&aDisabled, NULL);
+					std::free(_stack);
+				}
+			}
+			void* _stack; ///< stack memory, NULL if not installed by the logger
+		};
+#endif
+
+		/**
+		 * \brief Writer of the emergency drain, built before any crash
+		 */
+		static EmergencyWriter EmergencyOutput;
+
+		/**
+		 * \brief Channel registry, constant initialized: channels may be registered by static constructors of other files
+		 */
+		static std::mutex ChannelsMutex;
+		static char ChannelNames[EVOLVE_LOG_MAX_CHANNELS][EVOLVE_LOG_CHANNEL_NAME_SIZE] = { "default" };
+		static bool ChannelLevelSet[EVOLVE_LOG_MAX_CHANNELS]; ///< the channel does not follow the global level
+		static std::atomic<unsigned int> ChannelCount(1);
+
+		/**
+		 * \brief Give the channels registered before the global level was read from the environment their initial level
+		 */
+		static bool InitialiseChannelLevels() {
+			Logger::SetLevel(Logger::GetLevel());
+			return Logger::SetChannelLevels(std::getenv("EVOLVE_LOG_CHANNELS"));
+		}
+
+		static const bool ChannelLevelsInitialised = InitialiseChannelLevels();
+
+        void Logger::attachReporter(LoggerReporter* iReporter, LogLevel iLevel, std::size_t iCapacity, LogOverflowPolicy iPolicy,
+			unsigned int iSampleRate) {
+			std::shared_ptr<LoggerSink> aSink(new LoggerSink(iReporter, iLevel, iCapacity, iPolicy, iSampleRate));
+			std::lock_guard<std::mutex> aLock(_sinksMutex);
+			_sinks.push_back(aSink);
+			_sinksVersion.fetch_add(1, std::memory_order_release);
+			for (std::size_t i = 0; i < EVOLVE_LOG_EMERGENCY_REPORTERS; ++i) {
+				LoggerSink* aFree = NULL;
+				if (_emergencySinks[i].compare_exchange_strong(aFree, aSink.get())) {
+					break;
+				}
+			}
         }
 
-        void Logger::log(const LogMessage& aMessage) {
-				_logQueue.push(aMessage);
+		void Logger::detachReporter(LoggerReporter* iReporter) {
+			std::shared_ptr<LoggerSink> aSink;
+			{
+				std::lock_guard<std::mutex> aLock(_sinksMutex);
+				for (std::vector<std::shared_ptr<LoggerSink> >::iterator aIt = _sinks.begin(); aIt != _sinks.end(); ++aIt) {
+					if ((*aIt)->getReporter() == iReporter) {
+						aSink = *aIt;
+						_sinks.erase(aIt);
+						_sinksVersion.fetch_add(1, std::memory_order_release);
+						break;
+					}
+				}
+			}
+			if (!aSink) {
+				std::cerr << "Can't detach reporter : not attached" << std::endl;
+				return;
+			}
+			for (std::size_t i = 0; i < EVOLVE_LOG_EMERGENCY_REPORTERS; ++i) {
+				LoggerSink* aExpected = aSink.get();
+				_emergencySinks[i].compare_exchange_strong(aExpected, NULL);
+			}
+
+			//a drain that saw the sink before it was unregistered may still use it
+			if (_emergency.load()) {
+				new std::shared_ptr<LoggerSink>(aSink);
+				return;
+			}
+			//the logger thread may still hold the sink, closed it ignores what it is given
+			aSink->close();
+		}
+
+		bool Logger::getStatistics(const LoggerReporter* iReporter, LoggerSinkStatistics& oStatistics) {
+			std::lock_guard<std::mutex> aLock(_sinksMutex);
+			for (std::size_t i = 0; i < _sinks.size(); ++i) {
+				if (_sinks[i]->getReporter() == iReporter) {
+					oStatistics = _sinks[i]->getStatistics();
+					return true;
+				}
+			}
+			return false;
+		}
+
+        void Logger::log(const LogMessage& iLogMessage) {
+			LogMessage aLogMessage(iLogMessage);
+			log(std::move(aLogMessage));
+        }
+
+        void Logger::log(LogMessage&& ioLogMessage) {
+			if (IsRecorded(ioLogMessage._level)) {
+				FlightRecorder::Record(ioLogMessage);
+				if (ioLogMessage._level >= LEVEL_CRITICAL) {
+					FlightRecorder::DumpAutomatic("critical message");
+				}
+			}
+			ThreadBuffer& aBuffer = localBuffer();
+			if (!push(aBuffer, ioLogMessage)) {
+				//only the owner thread writes the counter, no contention between producers
+				aBuffer._dropped.store(aBuffer._dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			}
+			wake();
         }
 
+		bool Logger::push(ThreadBuffer& ioBuffer, LogMessage& ioLogMessage) {
+			//moved into the slot: the text block, if any, changes hands without copy
+			switch (_overflowPolicy.load(std::memory_order_relaxed)) {
+			case OVERFLOW_DROP_NEWEST:
+				return ioBuffer._queue.tryPush(std::move(ioLogMessage));
+			case OVERFLOW_DROP_OLDEST:
+				return !ioBuffer._queue.pushOverwrite(std::move(ioLogMessage));
+			case OVERFLOW_SAMPLE:
+				if (ioLogMessage._level < LEVEL_ERROR && ioBuffer._queue.size() >= ioBuffer._queue.capacity() / 2
+					&& ++ioBuffer._sampleCount % _sampleRate.load(std::memory_order_relaxed) != 0) {
+					return false;
+				}
+				return ioBuffer._queue.tryPush(std::move(ioLogMessage));
+			default:
+				break;
+			}
+
+			unsigned int aSpin = 0;
+			while (!ioBuffer._queue.tryPush(std::move(ioLogMessage))) {
+				//full: make sure the logger thread is draining, then give it time
+				wake();
+				if (++aSpin > 64) {
+					std::this_thread::yield();
+				}
+			}
+			return true;
+		}
+
+		void Logger::setOverflowPolicy(LogOverflowPolicy iPolicy, std::size_t iCapacity, unsigned int iSampleRate) {
+			_queueCapacity.store(iCapacity, std::memory_order_relaxed);
+			_sampleRate.store(iSampleRate == 0 ? 1 : iSampleRate, std::memory_order_relaxed);
+			_overflowPolicy.store(iPolicy, std::memory_order_relaxed);
+		}
+
+		unsigned long long Logger::getDroppedCount() const {
+			return _droppedCount.load(std::memory_order_relaxed);
+		}
+
+		Logger::ThreadBuffer& Logger::localBuffer() {
+			//retires the buffer when the thread exits, the logger keeps it alive until drained
+			struct LocalBuffer {
+				~LocalBuffer() {
+					if (_buffer) {
+						_buffer->_retired.store(true, std::memory_order_release);
+					}
+				}
+				std::shared_ptr<ThreadBuffer> _buffer;
+			};
+			static thread_local LocalBuffer aLocal;
+
+			if (!aLocal._buffer) {
+				if (CrashHandlerInstalled.load(std::memory_order_relaxed)) {
+					InstallCrashStack();
+				}
+				aLocal._buffer = std::make_shared<ThreadBuffer>(_queueCapacity.load(std::memory_order_relaxed));
+				std::lock_guard<std::mutex> aLock(_buffersMutex);
+				_buffers.push_back(aLocal._buffer);
+				_buffersVersion.fetch_add(1, std::memory_order_release);
+				for (std::size_t i = 0; i < EVOLVE_THREAD_REGISTRY_SIZE; ++i) {
+					ThreadBuffer* aFree = NULL;
+					if (_emergencyBuffers[i].compare_exchange_strong(aFree, aLocal._buffer.get())) {
+						break;
+					}
+				}
+			}
+			return *aLocal._buffer;
+		}
+
+		void Logger::wake() {
+			//pairs with the seq_cst store of _sleeping in wait()
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (_sleeping.load(std::memory_order_relaxed)) {
+				std::lock_guard<std::mutex> aLock(_wakeMutex);
+				_wakeCondition.notify_one();
+			}
+		}
+
+		void Logger::wait(const std::vector<std::shared_ptr<ThreadBuffer> >& iBuffers, std::size_t iVersion) {
+			std::unique_lock<std::mutex> aLock(_wakeMutex);
+			_sleeping.store(true, std::memory_order_seq_cst);
+			//re-check after announcing the sleep, a producer may have pushed in between
+			bool aEmpty = !_closureCondition.load(std::memory_order_acquire)
+				&& _buffersVersion.load(std::memory_order_acquire) == iVersion
+				&& _syncRequested.load(std::memory_order_acquire) == _syncForwarded.load(std::memory_order_relaxed);
+			for (std::size_t i = 0; aEmpty && i < iBuffers.size(); ++i) {
+				aEmpty = iBuffers[i]->_queue.empty();
+			}
+			if (aEmpty) {
+				_wakeCondition.wait_for(aLock, std::chrono::milliseconds(100));
+			}
+			_sleeping.store(false, std::memory_order_relaxed);
+		}
+
+		void Logger::releaseRetiredBuffers() {
+			std::lock_guard<std::mutex> aLock(_buffersMutex);
+			std::vector<std::shared_ptr<ThreadBuffer> >::iterator aEnd = std::remove_if(_buffers.begin(), _buffers.end(),
+				[](const std::shared_ptr<ThreadBuffer>& iBuffer) {
+					//the owner pushes nothing after retiring, so an empty retired buffer is done
+					return iBuffer->_retired.load(std::memory_order_acquire) && iBuffer->_queue.empty();
+				});
+			if (aEnd == _buffers.end()) {
+				return;
+			}
+			for (std::vector<std::shared_ptr<ThreadBuffer> >::iterator aIt = aEnd; aIt != _buffers.end(); ++aIt) {
+				for (std::size_t i = 0; i < EVOLVE_THREAD_REGISTRY_SIZE; ++i) {
+					ThreadBuffer* aExpected = aIt->get();
+					_emergencyBuffers[i].compare_exchange_strong(aExpected, NULL);
+				}
+			}
+			//a drain that saw the buffers before they were unregistered may still use them
+			if (_emergency.load()) {
+				return;
+			}
+			_buffers.erase(aEnd, _buffers.end());
+			_buffersVersion.fetch_add(1, std::memory_order_release);
+		}
+
+		void Logger::SetLevel(LogLevel iLevel) {
+			std::lock_guard<std::mutex> aLock(ChannelsMutex);
+			_Level.store(static_cast<int>(iLevel), std::memory_order_relaxed);
+			const unsigned int aCount = ChannelCount.load(std::memory_order_relaxed);
+			for (unsigned int i = 0; i < aCount; ++i) {
+				if (!ChannelLevelSet[i]) {
+					_ChannelLevels[i].store(static_cast<int>(iLevel), std::memory_order_relaxed);
+				}
+			}
+		}
+
+		LogLevel Logger::GetLevel() {
+			return static_cast<LogLevel>(_Level.load(std::memory_order_relaxed));
+		}
+
+		void Logger::Record(const LogMessage& iLogMessage) {
+			FlightRecorder::Record(iLogMessage);
+		}
+
+		void Logger::SetCoarseClock(bool iCoarse) {
+			_CoarseClock.store(iCoarse, std::memory_order_relaxed);
+		}
+
+		void Logger::SetCriticalSyncTimeout(unsigned int iTimeoutMs) {
+			_CriticalSyncTimeout.store(iTimeoutMs, std::memory_order_relaxed);
+		}
+
+		bool Logger::sync(unsigned int iTimeoutMs) {
+			const unsigned long long aDeadline = evolve::utils::Clock::Now() + iTimeoutMs * 1000000ULL;
+			const unsigned long long aTicket = _syncRequested.fetch_add(1, std::memory_order_acq_rel) + 1;
+			wake();
+
+			while (true) {
+				bool aSynced = _syncForwarded.load(std::memory_order_acquire) >= aTicket;
+				if (aSynced) {
+					std::lock_guard<std::mutex> aLock(_sinksMutex);
+					for (std::size_t i = 0; aSynced && i < _sinks.size(); ++i) {
+						aSynced = _sinks[i]->isSynced(aTicket);
+					}
+				}
+				if (aSynced) {
+					return true;
+				}
+				if (evolve::utils::Clock::Now() >= aDeadline) {
+					return false;
+				}
+				EmergencyWriter::Sleep(1);
+			}
+		}
+
+		void Logger::syncCritical() {
+			const unsigned int aTimeoutMs = _CriticalSyncTimeout.load(std::memory_order_relaxed);
+			if (aTimeoutMs != 0) {
+				sync(aTimeoutMs);
+			}
+		}
+
+		bool Logger::emergencyDrain(unsigned int iTimeoutMs, const char* iReason) {
+			const unsigned long long aDeadline = evolve::utils::Clock::Now() + iTimeoutMs * 1000000ULL;
+			if (_emergency.exchange(true)) {
+				//another thread is draining, let it finish before dying
+				while (!_emergencyDone.load(std::memory_order_acquire) && evolve::utils::Clock::Now() < aDeadline) {
+					EmergencyWriter::Sleep(1);
+				}
+				return false;
+			}
+
+			//the logger and reporter threads wake up on their own, notifying them would take a lock
+			bool aStuck = std::this_thread::get_id() == _logThread.get_id();
+			for (std::size_t i = 0; i < EVOLVE_LOG_EMERGENCY_REPORTERS; ++i) {
+				LoggerSink* aSink = _emergencySinks[i].load();
+				aStuck = aStuck || (aSink != NULL && aSink->isDeliveryThread());
+			}
+			const unsigned long long aTicket = _syncRequested.fetch_add(1, std::memory_order_acq_rel) + 1;
+			bool aSynced = false;
+			while (!aStuck) {
+				aSynced = _syncForwarded.load(std::memory_order_acquire) >= aTicket;
+				for (std::size_t i = 0; aSynced && i < EVOLVE_LOG_EMERGENCY_REPORTERS; ++i) {
+					LoggerSink* aSink = _emergencySinks[i].load();
+					aSynced = aSink == NULL || aSink->isSynced(aTicket);
+				}
+				if (aSynced || evolve::utils::Clock::Now() >= aDeadline) {
+					break;
+				}
+				EmergencyWriter::Sleep(1);
+			}
+
+			//whatever is left: reporter buffers and queues first, they hold the oldest messages
+			for (std::size_t i = 0; i < EVOLVE_LOG_EMERGENCY_REPORTERS; ++i) {
+				LoggerSink* aSink = _emergencySinks[i].load();
+				if (aSink != NULL) {
+					aSink->emergencyDrain(EmergencyOutput);
+				}
+			}
+			for (std::size_t b = 0; b < EVOLVE_THREAD_REGISTRY_SIZE; ++b) {
+				ThreadBuffer* aBuffer = _emergencyBuffers[b].load();
+				if (aBuffer == NULL) {
+					continue;
+				}
+				while (const LogMessage* aMessage = EmergencyOutput.pop(aBuffer->_queue)) {
+					for (std::size_t i = 0; i < EVOLVE_LOG_EMERGENCY_REPORTERS; ++i) {
+						LoggerSink* aSink = _emergencySinks[i].load();
+						if (aSink != NULL) {
+							aSink->emergencyWrite(*aMessage, EmergencyOutput);
+						}
+					}
+				}
+			}
+
+			if (iReason != NULL) {
+				//a static format without arguments, so the message owns no memory
+				LogMessage aLogMessage;
+				aLogMessage._level = LEVEL_CRITICAL;
+				aLogMessage._time = evolve::utils::Clock::Now();
+				aLogMessage._file = __FILE__;
+				aLogMessage._line = __LINE__;
+				aLogMessage._func = __FUNCTION__;
+				//never registers the thread: no thread_local initialisation in a signal handler
+				aLogMessage._threadIndex = evolve::utils::PeekCurrentThreadIndex();
+				aLogMessage._format = iReason;
+				for (std::size_t i = 0; i < EVOLVE_LOG_EMERGENCY_REPORTERS; ++i) {
+					LoggerSink* aSink = _emergencySinks[i].load();
+					if (aSink != NULL) {
+						aSink->emergencyWrite(aLogMessage, EmergencyOutput);
+					}
+				}
+			}
+
+			//the debug context of the crash, written last as it is the least important
+			if (IsRecorded(LEVEL_CRITICAL)) {
+				FlightRecorder::DumpAutomatic(iReason != NULL ? iReason : "emergency drain");
+			}
+
+			_emergencyDone.store(true, std::memory_order_release);
+			return aSynced;
+		}
+
+		void Logger::InstallCrashHandler(unsigned int iTimeoutMs) {
+			_CrashTimeout.store(iTimeoutMs, std::memory_order_relaxed);
+			if (CrashHandlerInstalled.exchange(true)) {
+				return;
+			}
+			InstallCrashStack();
+			for (std::size_t i = 0; i < FatalSignalCount; ++i) {
+#ifdef WIN32
+				PreviousHandlers[i] = std::signal(FatalSignals[i], &Logger::HandleFatalSignal);
+#else
+				struct sigaction aAction;
+				aAction.sa_handler = &Logger::HandleFatalSignal;
+				sigemptyset(&aAction.sa_mask);
+				//on the alternate stack where there is one: a stack overflow would fault again on the thread stack
+				aAction.sa_flags = SA_ONSTACK;
+				if (sigaction(FatalSignals[i], &aAction, &PreviousActions[i]) != 0) {
+					std::cerr << "Can't install crash handler for signal " << FatalSignals[i] << std::endl;
+				}
+#endif
+			}
+		}
+
+		void Logger::InstallCrashStack() {
+#ifndef WIN32
+			static thread_local CrashStack aCrashStack;
+			if (aCrashStack._stack != NULL) {
+				return;
+			}
+			stack_t aCurrent;
+			if (sigaltstack(NULL, &aCurrent) == 0 && (aCurrent.ss_flags & SS_DISABLE) == 0) {
+				return;
+			}
+
+			const std::size_t aSize = EVOLVE_LOG_CRASH_STACK_SIZE < MINSIGSTKSZ ? MINSIGSTKSZ : EVOLVE_LOG_CRASH_STACK_SIZE;
+			stack_t aStack;
+			aStack.ss_sp = std::malloc(aSize);
+			aStack.ss_size = aSize;
+			aStack.ss_flags = 0;
+			if (aStack.ss_sp == NULL || sigaltstack(&aStack, NULL) != 0) {
+				std::cerr << "Can't install the crash handler stack" << std::endl;
+				std::free(aStack.ss_sp);
+				return;
+			}
+			aCrashStack._stack = aStack.ss_sp;
+#endif
+		}
+
+		void Logger::UninstallCrashHandler() {
+			if (!CrashHandlerInstalled.exchange(false)) {
+				return;
+			}
+			for (std::size_t i = 0; i < FatalSignalCount; ++i) {
+#ifdef WIN32
+				std::signal(FatalSignals[i], PreviousHandlers[i]);
+#else
+				sigaction(FatalSignals[i], &PreviousActions[i], NULL);
+#endif
+			}
+		}
+
+		void Logger::HandleFatalSignal(int iSignal) {
+			const int aErrno = errno;
+			std::size_t aIndex = 0;
+			while (aIndex + 1 < FatalSignalCount && FatalSignals[aIndex] != iSignal) {
+				++aIndex;
+			}
+
+			Logger* aLogger = _EmergencyInstance.load(std::memory_order_acquire);
+			if (aLogger != NULL) {
+				aLogger->emergencyDrain(_CrashTimeout.load(std::memory_order_relaxed), FatalSignalReasons[aIndex]);
+			}
+
+			//hand the signal to the previous handler, delivered once this one returns
+#ifdef WIN32
+			std::signal(iSignal, PreviousHandlers[aIndex]);
+#else
+			sigaction(iSignal, &PreviousActions[aIndex], NULL);
+#endif
+			errno = aErrno;
+			std::raise(iSignal);
+		}
+
+		LogChannel Logger::RegisterChannel(const char* iName) {
+			if (iName == NULL || *iName == '\0') {
+				return CHANNEL_DEFAULT;
+			}
+
+			std::lock_guard<std::mutex> aLock(ChannelsMutex);
+			const unsigned int aCount = ChannelCount.load(std::memory_order_relaxed);
+			for (unsigned int i = 0; i < aCount; ++i) {
+				if (std::strncmp(ChannelNames[i], iName, EVOLVE_LOG_CHANNEL_NAME_SIZE - 1) == 0) {
+					return static_cast<LogChannel>(i);
+				}
+			}
+			if (aCount == EVOLVE_LOG_MAX_CHANNELS) {
+				std::cerr << "Can't register log channel " << iName << " : " << EVOLVE_LOG_MAX_CHANNELS << " channels already registered" << std::endl;
+				return CHANNEL_DEFAULT;
+			}
+
+			std::strncpy(ChannelNames[aCount], iName, EVOLVE_LOG_CHANNEL_NAME_SIZE - 1);
+			ChannelLevelSet[aCount] = false;
+			_ChannelLevels[aCount].store(_Level.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			//the name is complete before readers can see the channel
+			ChannelCount.store(aCount + 1, std::memory_order_release);
+			return static_cast<LogChannel>(aCount);
+		}
+
+		const char* Logger::GetChannelName(LogChannel iChannel) {
+			return iChannel < ChannelCount.load(std::memory_order_acquire) ? ChannelNames[iChannel] : "";
+		}
+
+		void Logger::SetChannelLevel(LogChannel iChannel, LogLevel iLevel) {
+			if (iChannel == CHANNEL_DEFAULT) {
+				SetLevel(iLevel);
+				return;
+			}
+
+			std::lock_guard<std::mutex> aLock(ChannelsMutex);
+			if (iChannel < ChannelCount.load(std::memory_order_relaxed)) {
+				ChannelLevelSet[iChannel] = true;
+				_ChannelLevels[iChannel].store(static_cast<int>(iLevel), std::memory_order_relaxed);
+			}
+		}
+
+		void Logger::ResetChannelLevel(LogChannel iChannel) {
+			std::lock_guard<std::mutex> aLock(ChannelsMutex);
+			if (iChannel != CHANNEL_DEFAULT && iChannel < ChannelCount.load(std::memory_order_relaxed)) {
+				ChannelLevelSet[iChannel] = false;
+				_ChannelLevels[iChannel].store(_Level.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			}
+		}
+
+		LogLevel Logger::GetChannelLevel(LogChannel iChannel) {
+			return static_cast<LogLevel>(_ChannelLevels[iChannel].load(std::memory_order_relaxed));
+		}
+
+		bool Logger::SetChannelLevels(const char* iLevels) {
+			if (iLevels == NULL) {
+				return true;
+			}
+
+			bool aValid = true;
+			std::string aEntry;
+			for (const char* aCursor = iLevels; ; ++aCursor) {
+				if (*aCursor != ',' && *aCursor != '\0') {
+					if (!std::isspace(static_cast<unsigned char>(*aCursor))) {
+						aEntry += *aCursor;
+					}
+					continue;
+				}
+
+				if (!aEntry.empty()) {
+					const LogLevel aInvalid = static_cast<LogLevel>(-1);
+					const std::size_t aSeparator = aEntry.find('=');
+					const LogLevel aLevel = aSeparator != std::string::npos && aSeparator != 0
+						? ParseLevel(aEntry.c_str() + aSeparator + 1, aInvalid) : aInvalid;
+					const std::string aName = aEntry.substr(0, aSeparator);
+					//a full registry gives the default channel back, which must not get the level by mistake
+					const LogChannel aChannel = aLevel != aInvalid ? RegisterChannel(aName.c_str()) : CHANNEL_DEFAULT;
+					if (aLevel == aInvalid || (aChannel == CHANNEL_DEFAULT && aName != ChannelNames[CHANNEL_DEFAULT])) {
+						std::cerr << "Can't set log channel level : " << aEntry << std::endl;
+						aValid = false;
+					}
+					else {
+						SetChannelLevel(aChannel, aLevel);
+					}
+					aEntry.clear();
+				}
+				if (*aCursor == '\0') {
+					return aValid;
+				}
+			}
+		}
+
+		LogLevel Logger::ParseLevel(const char* iText, LogLevel iDefault) {
+			if (iText == NULL || *iText == '\0') {
+				return iDefault;
+			}
+
+			if (std::isdigit(static_cast<unsigned char>(*iText))) {
+				const int aLevel = std::atoi(iText);
+				return (aLevel >= LEVEL_DEBUG && aLevel <= LEVEL_OFF) ? static_cast<LogLevel>(aLevel) : iDefault;
+			}
+
+			std::string aName(iText);
+			for (std::string::iterator aIt = aName.begin(); aIt != aName.end(); ++aIt) {
+				*aIt = static_cast<char>(std::toupper(static_cast<unsigned char>(*aIt)));
+			}
+			for (std::size_t i = 0; i < _LogLevelStringMap.size(); ++i) {
+				if (_LogLevelStringMap[i] == aName) {
+					return static_cast<LogLevel>(i);
+				}
+			}
+			return iDefault;
+		}
+
         Logger::Logger()
-            :_reporter(NULL),
-			 _logQueue(),
-			 _logThread(&Logger::loopMessageLogs ,this),
-			 _closureCondition(false) {
+            :_sinks(),
+			 _sinksMutex(),
+			 _sinksVersion(0),
+			 _deliverySinks(),
+			 _deliverySinksVersion(0),
+			 _buffers(),
+			 _buffersMutex(),
+			 _buffersVersion(0),
+			 _sleeping(false),
+			 _wakeMutex(),
+			 _wakeCondition(),
+			 _overflowPolicy(OVERFLOW_BLOCK),
+			 _queueCapacity(EVOLVE_LOG_QUEUE_CAPACITY),
+			 _sampleRate(16),
+			 _droppedCount(0),
+			 _nextSuppressedReport(0),
+			 _syncRequested(0),
+			 _syncForwarded(0),
+			 _emergency(false),
+			 _emergencyDone(false),
+			 _closureCondition(false),
+			 _logThread(&Logger::loopMessageLogs ,this) {
+			for (std::size_t i = 0; i < EVOLVE_THREAD_REGISTRY_SIZE; ++i) {
+				_emergencyBuffers[i].store(NULL, std::memory_order_relaxed);
+			}
+			for (std::size_t i = 0; i < EVOLVE_LOG_EMERGENCY_REPORTERS; ++i) {
+				_emergencySinks[i].store(NULL, std::memory_order_relaxed);
+			}
+			_EmergencyInstance.store(this, std::memory_order_release);
 		}
 
         Logger::~Logger() {
-			_closureCondition = true;
-			
-			LogMessage aClosureMessage;
-			aClosureMessage._level = LEVEL_OFF;
-			log(aClosureMessage);
+			_EmergencyInstance.store(NULL, std::memory_order_release);
+			_closureCondition.store(true, std::memory_order_release);
+			wake();
 
 			//wait thread completion
 			_logThread.join();
 
-            delete _reporter;
-            _reporter = NULL;
+			//each sink delivers what it still holds before deleting its reporter
+			_deliverySinks.clear();
+			_sinks.clear();
         }
 
 		void Logger::loopMessageLogs() {
-			while (!_closureCondition) {
-				LogMessage aLogMessage;
-				_logQueue.pop(aLogMessage);
-				if (aLogMessage._level != LEVEL_OFF)
-				{
-					if (_reporter == NULL) {
-						std::cerr << "Can't log : undefined raporter" << std::endl;
-						std::cerr << "To log : " << aLogMessage._message << std::endl;
+			evolve::utils::SetCurrentThreadName("evolve.log");
+			InstallCrashStack();
+
+			//messages are move-assigned into the batches, so their string storage is reused
+			std::vector<LogMessage> aBatch(EVOLVE_LOG_BATCH_SIZE);
+			std::vector<LogMessage> aMerged(EVOLVE_LOG_BATCH_SIZE);
+			std::vector<std::pair<std::size_t, std::size_t> > aRuns;
+			std::vector<std::shared_ptr<ThreadBuffer> > aBuffers;
+			std::size_t aVersion = 0;
+			std::size_t aFirst = 0;
+			while (true) {
+				//anything logged before the destructor started is visible once the flag is
+				const bool aClosing = _closureCondition.load(std::memory_order_acquire);
+				const unsigned long long aSync = _syncRequested.load(std::memory_order_acquire);
+
+				if (_buffersVersion.load(std::memory_order_acquire) != aVersion || aBuffers.empty()) {
+					std::lock_guard<std::mutex> aLock(_buffersMutex);
+					aVersion = _buffersVersion.load(std::memory_order_relaxed);
+					aBuffers = _buffers;
+				}
+
+				//one sorted run per thread, starting from a different buffer each time so none starves
+				std::size_t aCount = 0;
+				aRuns.clear();
+				for (std::size_t i = 0; i < aBuffers.size() && aCount < aBatch.size(); ++i) {
+					ThreadBuffer& aBuffer = *aBuffers[(aFirst + i) % aBuffers.size()];
+					const std::size_t aPopped = aBuffer._queue.popBulk(aBatch.data() + aCount, aBatch.size() - aCount);
+					if (aPopped != 0) {
+						aRuns.push_back(std::make_pair(aCount, aCount + aPopped));
+						aCount += aPopped;
 					}
-					else {
-						this->_reporter->log(aLogMessage);
+				}
+				aFirst = aBuffers.empty() ? 0 : (aFirst + 1) % aBuffers.size();
+				reportDropped(aBuffers);
+				reportSuppressed(aClosing && aCount == 0);
+
+				if (aCount == 0) {
+					if (aSync != _syncForwarded.load(std::memory_order_relaxed)) {
+						forwardSync(aSync);
+					}
+					if (aClosing) {
+						return;
+					}
+					releaseRetiredBuffers();
+					wait(aBuffers, aVersion);
+					continue;
+				}
+
+				if (aRuns.size() == 1) {
+					reportMessages(aBatch.data(), aCount);
+					continue;
+				}
+
+				//k-way merge of the per-thread runs, ties keep the run order
+				for (std::size_t aOut = 0; aOut < aCount; ++aOut) {
+					std::size_t aBest = aRuns.size();
+					for (std::size_t r = 0; r < aRuns.size(); ++r) {
+						if (aRuns[r].first != aRuns[r].second
+							&& (aBest == aRuns.size() || aBatch[aRuns[r].first]._time < aBatch[aRuns[aBest].first]._time)) {
+							aBest = r;
+						}
 					}
+					aMerged[aOut] = std::move(aBatch[aRuns[aBest].first++]);
+				}
+				reportMessages(aMerged.data(), aCount);
+			}
+		}
+
+		void Logger::reportDropped(const std::vector<std::shared_ptr<ThreadBuffer> >& iBuffers) {
+			unsigned long long aDropped = 0;
+			for (std::size_t i = 0; i < iBuffers.size(); ++i) {
+				const unsigned long long aTotal = iBuffers[i]->_dropped.load(std::memory_order_relaxed);
+				aDropped += aTotal - iBuffers[i]->_reportedDropped;
+				iBuffers[i]->_reportedDropped = aTotal;
+			}
+			if (aDropped == 0) {
+				return;
+			}
+			_droppedCount.fetch_add(aDropped, std::memory_order_relaxed);
+
+			std::stringstream aSs;
+			aSs << aDropped << " messages dropped: log queue full";
+
+			LogMessage aLogMessage;
+			EVOLVE_LOG_INIT_(aLogMessage, LEVEL_WARNING, __FILE__, __LINE__, __FUNCTION__);
+			aLogMessage._message = aSs.str();
+			reportMessages(&aLogMessage, 1);
+		}
+
+		void Logger::reportSuppressed(bool iAll) {
+			//the coarse clock is enough at this period
+			const unsigned long long aNow = evolve::utils::Clock::Now(true);
+			if (!iAll && aNow < _nextSuppressedReport) {
+				return;
+			}
+			_nextSuppressedReport = aNow + EVOLVE_LOG_SUPPRESSOR_FLUSH_MS * 1000000ULL;
+
+			std::vector<LogMessage> aMessages;
+			LogSuppressor::Expire(aNow, iAll, aMessages);
+			if (!aMessages.empty()) {
+				reportMessages(aMessages.data(), aMessages.size());
+			}
+		}
+
+		void Logger::refreshSinks() {
+			if (_sinksVersion.load(std::memory_order_acquire) == _deliverySinksVersion) {
+				return;
+			}
+			std::lock_guard<std::mutex> aLock(_sinksMutex);
+			_deliverySinks = _sinks;
+			_deliverySinksVersion = _sinksVersion.load(std::memory_order_relaxed);
+		}
+
+		void Logger::forwardSync(unsigned long long iTicket) {
+			//everything logged before the request has been handed to the sinks
+			refreshSinks();
+			for (std::size_t i = 0; i < _deliverySinks.size(); ++i) {
+				_deliverySinks[i]->requestSync(iTicket);
+			}
+			_syncForwarded.store(iTicket, std::memory_order_release);
+		}
+
+		void Logger::reportMessages(LogMessage* ioMessages, std::size_t iCount) {
+			if (iCount == 0) {
+				return;
+			}
+
+			for (std::size_t i = 0; i < iCount; ++i) {
+				if (ioMessages[i]._format != NULL) {
+					ioMessages[i]._arguments.format(ioMessages[i]._format, ioMessages[i]._message);
+				}
+			}
+
+			//no lock held: a sink blocking on its full queue leaves attach, detach and statistics free
+			refreshSinks();
+			if (_deliverySinks.empty()) {
+				std::cerr << "Can't log : undefined raporter" << std::endl;
+				for (std::size_t i = 0; i < iCount; ++i) {
+					std::cerr << "To log : " << ioMessages[i]._message << std::endl;
+				}
+			}
+			else {
+				//the last sink takes the messages, the others get copies
+				for (std::size_t i = 0; i < _deliverySinks.size(); ++i) {
+					_deliverySinks[i]->push(ioMessages, iCount, i + 1 == _deliverySinks.size());
 				}
 			}
 		}
@@ -29,9 +29,9 @@
  */
 
 #include <evolve/log/loggerreporter.h>
-#include <evolve/utils/threadutils.h>
+#include <evolve/log/emergencywriter.h>
+#include <evolve/log/asyncfilewriter.h>
 #include <iostream>
-#include <sstream>
 
 /**
  * Namespace for all evolve classes
@@ -43,80 +43,277 @@ namespace evolve {
     namespace log {
 
 
-        LoggerReporter::LoggerReporter()
-			:_clock()
+        LoggerReporter::LoggerReporter(const char* iPattern)
+			:_layout(iPattern)
 		{}
 
         LoggerReporter::~LoggerReporter() {}
 
+		void LoggerReporter::logBatch(const LogMessage* iLogMessages, std::size_t iCount) {
+			for (std::size_t i = 0; i < iCount; ++i) {
+				log(iLogMessages[i]);
+			}
+		}
+
+		void LoggerReporter::idle() {}
+
+		void LoggerReporter::flush() {}
+
+		void LoggerReporter::sync() {}
+
+		int LoggerReporter::getEmergencyDescriptor() const {
+			return -1;
+		}
+
+		void LoggerReporter::emergencyFlush() {}
+
 		void LoggerReporter::formatLogMessage(const LogMessage& iLogMessage, std::string& oLog) {
-			std::stringstream aSs;
-
-			aSs << "[" << _clock.getFormattedDateAndTime() << " | Thread: ";
-
-			//thread
-			aSs.setf(std::ios::left);
-			aSs.fill(' ');
-			aSs.width(3);
-			aSs << evolve::utils::GetThreadId(iLogMessage._threadId) << " (";
-			aSs.setf(std::ios::right);
-			aSs.fill('0');
-			aSs.width(16);
-			aSs << iLogMessage._threadId << ") | ";
-
-			//file and line
-			aSs.setf(std::ios::left);
-			aSs.fill(' ');
-			aSs.width(42);
-			aSs << iLogMessage._file << "#";
-			aSs.setf(std::ios::right);
-			aSs.fill(' ');
-			aSs.width(4);
-			aSs << iLogMessage._line << " > ";
-
-			
-			//function
-			aSs.setf(std::ios::right);
-			aSs.fill(' ');
-			aSs.width(50);
-			aSs << iLogMessage._func << " | ";
-
-			//log level
-			aSs.setf(std::ios::right);
-			aSs.fill(' ');
-			aSs.width(8);
-			aSs << Logger::_LogLevelStringMap[iLogMessage._level] << "] ";
-
-			//log message
-			aSs << iLogMessage._message;
-			oLog = aSs.str();
-		}
-
-
-        CoutLoggerReporter::CoutLoggerReporter()
-            :evolve::log::LoggerReporter() {}
+			_layout.format(iLogMessage, oLog);
+		}
+
+
+        CoutLoggerReporter::CoutLoggerReporter(const char* iPattern)
+            :evolve::log::LoggerReporter(iPattern), _line(), _buffer() {}
 
         CoutLoggerReporter::~CoutLoggerReporter() {}
 
         void CoutLoggerReporter::log(const LogMessage& iLogMessage) {
-			std::string aLog;
-			formatLogMessage(iLogMessage, aLog);
-            std::cout << aLog << std::endl;
+			logBatch(&iLogMessage, 1);
         }
 
-        FileLoggerReporter::FileLoggerReporter(const char* iFile)
-                :LoggerReporter(), _fileStream() {
-			_fileStream.open(iFile, std::ofstream::out | std::ofstream::app);
+		void CoutLoggerReporter::logBatch(const LogMessage* iLogMessages, std::size_t iCount) {
+			_buffer.clear();
+			for (std::size_t i = 0; i < iCount; ++i) {
+				formatLogMessage(iLogMessages[i], _line);
+				_buffer += _line;
+				_buffer += '\n';
+			}
+			std::cout.write(_buffer.data(), _buffer.size());
+			std::cout.flush();
+		}
+
+		int CoutLoggerReporter::getEmergencyDescriptor() const {
+			//lines are written to std::cout right away, nothing is left in a buffer
+			return 1;
+		}
+
+		FileFlushPolicy::FileFlushPolicy()
+			:_bytes(0), _intervalMs(0), _level(LEVEL_OFF), _asyncBuffers(0), _indexBlockBytes(0) {}
+
+		FileFlushPolicy FileFlushPolicy::Always() {
+			return FileFlushPolicy();
+		}
+
+		FileFlushPolicy FileFlushPolicy::Buffered(std::size_t iBytes, unsigned int iIntervalMs, LogLevel iLevel) {
+			FileFlushPolicy aPolicy;
+			aPolicy._bytes = iBytes;
+			aPolicy._intervalMs = iIntervalMs;
+			aPolicy._level = iLevel;
+			return aPolicy;
+		}
+
+		FileFlushPolicy FileFlushPolicy::Asynchronous(std::size_t iBytes, unsigned int iIntervalMs, LogLevel iLevel, unsigned int iBuffers) {
+			FileFlushPolicy aPolicy = Buffered(iBytes, iIntervalMs, iLevel);
+			aPolicy._asyncBuffers = iBuffers != 0 ? iBuffers : 1;
+			return aPolicy;
+		}
+
+		FileFlushPolicy FileFlushPolicy::withIndex(std::size_t iBlockBytes) const {
+			FileFlushPolicy aPolicy = *this;
+			aPolicy._indexBlockBytes = iBlockBytes != 0 ? iBlockBytes : 1;
+			return aPolicy;
+		}
+
+        FileLoggerReporter::FileLoggerReporter(const char* iFile, const FileFlushPolicy& iPolicy, const char* iPattern)
+                :LoggerReporter(iPattern), _file(iFile), _mode(std::ofstream::out | std::ofstream::app | std::ofstream::binary),
+				 _fileStream(), _asyncWriter(NULL), _emergencyDescriptor(-1), _policy(iPolicy), _line(), _buffer(), _pendingSince(),
+				 _fileEnd(0), _index(), _indexEntry(), _indexEntries() {
+			//lines are buffered in _buffer, so each flush is a single write to the file
+			//binary mode: no new line translation, so _fileEnd and the index offsets match the file bytes
+			_fileStream.rdbuf()->pubsetbuf(NULL, 0);
+			if (_policy._asyncBuffers != 0) {
+				_asyncWriter = new AsyncFileWriter(_policy._asyncBuffers, _policy._bytes + (64 << 10));
+			}
+			openFile();
+			_buffer.reserve(_policy._bytes + (64 << 10));
+		}
+
+        FileLoggerReporter::FileLoggerReporter(const char* iFile, const FileFlushPolicy& iPolicy, std::ios_base::openmode iMode)
+                :LoggerReporter(), _file(iFile), _mode(std::ofstream::out | std::ofstream::app | std::ofstream::binary | iMode),
+				 _fileStream(), _asyncWriter(NULL), _emergencyDescriptor(-1), _policy(iPolicy), _line(), _buffer(), _pendingSince(),
+				 _fileEnd(0), _index(), _indexEntry(), _indexEntries() {
+			_fileStream.rdbuf()->pubsetbuf(NULL, 0);
+			if (_policy._asyncBuffers != 0) {
+				_asyncWriter = new AsyncFileWriter(_policy._asyncBuffers, _policy._bytes + (64 << 10));
+			}
+			openFile();
+			_buffer.reserve(_policy._bytes + (64 << 10));
 		}
 
         FileLoggerReporter::~FileLoggerReporter() {
-			_fileStream.close();
+			flush();
+			closeFile();
+			delete _asyncWriter;
 		}
 
         void FileLoggerReporter::log(const LogMessage& iLogMessage) {
-			std::string aLog;
-			formatLogMessage(iLogMessage, aLog);
-            _fileStream << aLog << std::endl << std::flush;
+			logBatch(&iLogMessage, 1);
         }
+
+		void FileLoggerReporter::logBatch(const LogMessage* iLogMessages, std::size_t iCount) {
+			if (_buffer.empty()) {
+				_pendingSince = std::chrono::steady_clock::now();
+			}
+
+			bool aUrgent = false;
+			for (std::size_t i = 0; i < iCount; ++i) {
+				appendLogMessage(iLogMessages[i], _buffer);
+				aUrgent = aUrgent || iLogMessages[i]._level >= _policy._level;
+				if (_policy._indexBlockBytes != 0) {
+					indexLogMessage(iLogMessages[i]);
+				}
+			}
+
+			if (aUrgent || _buffer.size() >= _policy._bytes) {
+				flush();
+			}
+			else {
+				idle();
+			}
+		}
+
+		void FileLoggerReporter::appendLogMessage(const LogMessage& iLogMessage, std::string& ioBuffer) {
+			formatLogMessage(iLogMessage, _line);
+			ioBuffer += _line;
+			ioBuffer += '\n';
+		}
+
+		void FileLoggerReporter::indexLogMessage(const LogMessage& iLogMessage) {
+			_indexEntry.add(iLogMessage);
+			if (_fileEnd + _buffer.size() - _indexEntry._offset >= _policy._indexBlockBytes) {
+				closeIndexEntry();
+			}
+		}
+
+		void FileLoggerReporter::closeIndexEntry() {
+			//raw bytes without message stay in the block, they belong to the next messages
+			if (_indexEntry.getCount() == 0) {
+				return;
+			}
+			const unsigned long long aEnd = _fileEnd + _buffer.size();
+			_indexEntry._size = aEnd - _indexEntry._offset;
+			_indexEntries.push_back(_indexEntry);
+			_indexEntry.reset(aEnd);
+		}
+
+		void FileLoggerReporter::appendRaw(const char* iData, std::size_t iSize) {
+			if (_buffer.empty()) {
+				_pendingSince = std::chrono::steady_clock::now();
+			}
+			_buffer.append(iData, iSize);
+		}
+
+		void FileLoggerReporter::closeFile() {
+			if (_policy._indexBlockBytes != 0) {
+				//the last block only if its data has been written
+				if (_buffer.empty()) {
+					closeIndexEntry();
+				}
+				_index.write(_indexEntries);
+				_indexEntries.clear();
+				_index.close();
+			}
+			if (_asyncWriter != NULL) {
+				_asyncWriter->close();
+			}
+			_fileStream.close();
+			EmergencyWriter::Close(_emergencyDescriptor);
+			_emergencyDescriptor = -1;
+		}
+
+		void FileLoggerReporter::openFile() {
+			{
+				std::ifstream aExisting(_file.c_str(), std::ifstream::in | std::ifstream::binary | std::ifstream::ate);
+				const std::streamoff aSize = aExisting.is_open() ? static_cast<std::streamoff>(aExisting.tellg()) : 0;
+				_fileEnd = aSize > 0 ? static_cast<unsigned long long>(aSize) : 0;
+			}
+			if (_policy._indexBlockBytes != 0) {
+				_index.open(_file, _fileEnd);
+				_indexEntry.reset(_fileEnd);
+			}
+			if (_asyncWriter != NULL) {
+				if (_asyncWriter->open(_file.c_str())) {
+					_emergencyDescriptor = EmergencyWriter::Open(_file.c_str());
+				}
+				return;
+			}
+			_fileStream.clear();
+			_fileStream.open(_file.c_str(), _mode);
+			if (!_fileStream.is_open()) {
+				std::cerr << "Can't open log file " << _file << std::endl;
+				return;
+			}
+			_emergencyDescriptor = EmergencyWriter::Open(_file.c_str());
+		}
+
+		const std::string& FileLoggerReporter::getFile() const {
+			return _file;
+		}
+
+		std::size_t FileLoggerReporter::getPendingSize() const {
+			return _buffer.size();
+		}
+
+		void FileLoggerReporter::idle() {
+			if (_buffer.empty() || _policy._intervalMs == 0) {
+				return;
+			}
+			if (std::chrono::steady_clock::now() - _pendingSince >= std::chrono::milliseconds(_policy._intervalMs)) {
+				flush();
+			}
+		}
+
+		void FileLoggerReporter::flush() {
+			if (_buffer.empty()) {
+				return;
+			}
+			_fileEnd += _buffer.size();
+			if (_asyncWriter != NULL) {
+				//swapped with a free buffer, _buffer comes back empty
+				_asyncWriter->write(_buffer);
+				if (_asyncWriter->hasFailed()) {
+					//the blocks would point past the end of the file
+					_indexEntries.clear();
+				}
+			}
+			else {
+				_fileStream.write(_buffer.data(), _buffer.size());
+				_fileStream.flush();
+				_buffer.clear();
+			}
+			_index.write(_indexEntries);
+			_indexEntries.clear();
+		}
+
+		void FileLoggerReporter::sync() {
+			if (_asyncWriter != NULL) {
+				_asyncWriter->wait();
+			}
+		}
+
+		int FileLoggerReporter::getEmergencyDescriptor() const {
+			return _emergencyDescriptor;
+		}
+
+		void FileLoggerReporter::emergencyFlush() {
+			//clear() keeps the capacity, nothing is freed
+			if (_asyncWriter != NULL) {
+				_asyncWriter->emergencyWrite(_buffer.data(), _buffer.size());
+			}
+			else {
+				EmergencyWriter::Write(_emergencyDescriptor, _buffer.data(), _buffer.size());
+			}
+			_buffer.clear();
+		}
     }
 }
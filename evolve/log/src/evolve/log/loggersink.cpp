@@ -0,0 +1,267 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/loggersink.cpp
+ * \brief evolve/log asynchronous reporter delivery source file
+ * \author
+ *
+ */
+
+#include <evolve/log/loggersink.h>
+#include <evolve/log/loggerreporter.h>
+#include <evolve/log/emergencywriter.h>
+#include <sstream>
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		LoggerSink::LoggerSink(LoggerReporter* iReporter, LogLevel iLevel, std::size_t iCapacity, LogOverflowPolicy iPolicy,
+			unsigned int iSampleRate)
+			:_reporter(iReporter),
+			 _level(iLevel),
+			 _policy(iPolicy),
+			 _sampleRate(iSampleRate == 0 ? 1 : iSampleRate),
+			 _queue(iCapacity),
+			 _delivered(0),
+			 _dropped(0),
+			 _sampleCount(0),
+			 _sleeping(false),
+			 _wakeMutex(),
+			 _wakeCondition(),
+			 _syncRequested(0),
+			 _syncDone(0),
+			 _closureCondition(false),
+			 _delivering(false),
+			 _deliveryThread(&LoggerSink::loopDelivery, this) {
+		}
+
+		LoggerSink::~LoggerSink() {
+			close();
+		}
+
+		void LoggerSink::close() {
+			if (!_deliveryThread.joinable()) {
+				return;
+			}
+			_closureCondition.store(true, std::memory_order_release);
+			wake();
+
+			//wait thread completion
+			_deliveryThread.join();
+
+			delete _reporter;
+			_reporter = NULL;
+		}
+
+		void LoggerSink::push(LogMessage* ioLogMessages, std::size_t iCount, bool iMove) {
+			if (_closureCondition.load(std::memory_order_acquire)) {
+				return;
+			}
+			bool aPushed = false;
+			for (std::size_t i = 0; i < iCount; ++i) {
+				if (ioLogMessages[i]._level < _level) {
+					continue;
+				}
+				if (pushOne(ioLogMessages[i], iMove)) {
+					aPushed = true;
+				}
+				else {
+					_dropped.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+			if (aPushed) {
+				wake();
+			}
+		}
+
+		bool LoggerSink::pushOne(LogMessage& ioLogMessage, bool iMove) {
+			//same rules as the staging buffers, see Logger::push
+			switch (_policy) {
+			case OVERFLOW_DROP_NEWEST:
+				return iMove ? _queue.tryPush(std::move(ioLogMessage)) : _queue.tryPush(ioLogMessage);
+			case OVERFLOW_DROP_OLDEST:
+				return !(iMove ? _queue.pushOverwrite(std::move(ioLogMessage)) : _queue.pushOverwrite(ioLogMessage));
+			case OVERFLOW_SAMPLE:
+				if (ioLogMessage._level < LEVEL_ERROR && _queue.size() >= _queue.capacity() / 2 && ++_sampleCount % _sampleRate != 0) {
+					return false;
+				}
+				return iMove ? _queue.tryPush(std::move(ioLogMessage)) : _queue.tryPush(ioLogMessage);
+			default:
+				break;
+			}
+
+			unsigned int aSpin = 0;
+			while (!(iMove ? _queue.tryPush(std::move(ioLogMessage)) : _queue.tryPush(ioLogMessage))) {
+				//detached meanwhile, nobody drains the queue anymore
+				if (_closureCondition.load(std::memory_order_acquire)) {
+					return false;
+				}
+				//full: the reporter is behind, make sure it is draining then give it time
+				wake();
+				if (++aSpin > 64) {
+					std::this_thread::yield();
+				}
+			}
+			return true;
+		}
+
+		LoggerReporter* LoggerSink::getReporter() const {
+			return _reporter;
+		}
+
+		LoggerSinkStatistics LoggerSink::getStatistics() const {
+			LoggerSinkStatistics aStatistics;
+			aStatistics._delivered = _delivered.load(std::memory_order_relaxed);
+			aStatistics._dropped = _dropped.load(std::memory_order_relaxed);
+			return aStatistics;
+		}
+
+		void LoggerSink::requestSync(unsigned long long iTicket) {
+			_syncRequested.store(iTicket, std::memory_order_release);
+			wake();
+		}
+
+		bool LoggerSink::isSynced(unsigned long long iTicket) const {
+			return _syncDone.load(std::memory_order_acquire) >= iTicket;
+		}
+
+		bool LoggerSink::isDeliveryThread() const {
+			return std::this_thread::get_id() == _deliveryThread.get_id();
+		}
+
+		void LoggerSink::emergencyDrain(EmergencyWriter& ioWriter) {
+			//the reporter buffer holds older messages than the queue, but it can
+			//only be read if the delivery thread is not writing it; the claim is never released
+			bool aFree = false;
+			if (isDeliveryThread() || _delivering.compare_exchange_strong(aFree, true, std::memory_order_acquire)) {
+				_reporter->emergencyFlush();
+			}
+			const int aDescriptor = _reporter->getEmergencyDescriptor();
+			while (const LogMessage* aMessage = ioWriter.pop(_queue)) {
+				ioWriter.write(*aMessage, aDescriptor);
+			}
+		}
+
+		void LoggerSink::emergencyWrite(const LogMessage& iLogMessage, EmergencyWriter& ioWriter) {
+			if (iLogMessage._level >= _level) {
+				ioWriter.write(iLogMessage, _reporter->getEmergencyDescriptor());
+			}
+		}
+
+		void LoggerSink::loopDelivery() {
+			evolve::utils::SetCurrentThreadName("evolve.sink");
+			Logger::InstallCrashStack();
+
+			//messages are move-assigned into the batch, so their string storage is reused
+			std::vector<LogMessage> aBatch(EVOLVE_LOG_BATCH_SIZE);
+			unsigned long long aReportedDropped = 0;
+			while (true) {
+				const bool aClosing = _closureCondition.load(std::memory_order_acquire);
+				const unsigned long long aSync = _syncRequested.load(std::memory_order_acquire);
+				const std::size_t aCount = _queue.popBulk(aBatch.data(), aBatch.size());
+				claimReporter();
+				if (aCount != 0) {
+					_reporter->logBatch(aBatch.data(), aCount);
+					_delivered.fetch_add(aCount, std::memory_order_relaxed);
+				}
+
+				const unsigned long long aDropped = _dropped.load(std::memory_order_relaxed);
+				if (aDropped != aReportedDropped) {
+					reportDropped(aDropped - aReportedDropped);
+					aReportedDropped = aDropped;
+				}
+
+				if (aCount == 0) {
+					if (aSync != _syncDone.load(std::memory_order_relaxed)) {
+						//everything queued before the request has been delivered
+						_reporter->flush();
+						_reporter->sync();
+						_syncDone.store(aSync, std::memory_order_release);
+					}
+					if (aClosing) {
+						_reporter->flush();
+						_reporter->sync();
+						releaseReporter();
+						return;
+					}
+					_reporter->idle();
+					releaseReporter();
+					wait();
+				}
+				else {
+					releaseReporter();
+				}
+			}
+		}
+
+		void LoggerSink::claimReporter() {
+			//fails only once a crash drain took the reporter, the process is about to die
+			bool aFree = false;
+			while (!_delivering.compare_exchange_weak(aFree, true, std::memory_order_acquire)) {
+				aFree = false;
+				EmergencyWriter::Sleep(1);
+			}
+		}
+
+		void LoggerSink::releaseReporter() {
+			_delivering.store(false, std::memory_order_release);
+		}
+
+		void LoggerSink::wake() {
+			//pairs with the seq_cst store of _sleeping in wait()
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (_sleeping.load(std::memory_order_relaxed)) {
+				std::lock_guard<std::mutex> aLock(_wakeMutex);
+				_wakeCondition.notify_one();
+			}
+		}
+
+		void LoggerSink::wait() {
+			std::unique_lock<std::mutex> aLock(_wakeMutex);
+			_sleeping.store(true, std::memory_order_seq_cst);
+			//re-check after announcing the sleep, the logger thread may have pushed in between
+			if (_queue.empty() && !_closureCondition.load(std::memory_order_acquire)
+				&& _syncRequested.load(std::memory_order_acquire) == _syncDone.load(std::memory_order_relaxed)) {
+				_wakeCondition.wait_for(aLock, std::chrono::milliseconds(100));
+			}
+			_sleeping.store(false, std::memory_order_relaxed);
+		}
+
+		void LoggerSink::reportDropped(unsigned long long iDropped) {
+			std::stringstream aSs;
+			aSs << iDropped << " messages dropped: reporter queue full";
+
+			LogMessage aLogMessage;
+			EVOLVE_LOG_INIT_(aLogMessage, LEVEL_WARNING, __FILE__, __LINE__, __FUNCTION__);
+			aLogMessage._message = aSs.str();
+			_reporter->log(aLogMessage);
+		}
+    }
+}
@@ -0,0 +1,183 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/logindex.cpp
+ * \brief evolve/log sidecar index of log files
+ * \author
+ *
+ */
+
+#include <evolve/log/logindex.h>
+#include <cstring>
+#include <iostream>
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		static const std::size_t IndexMagicSize = sizeof(EVOLVE_LOG_INDEX_MAGIC) - 1;
+		static const std::size_t IndexHeaderSize = IndexMagicSize + 2 * sizeof(unsigned int);
+
+		LogIndexEntry::LogIndexEntry() {
+			reset(0);
+		}
+
+		void LogIndexEntry::reset(unsigned long long iOffset) {
+			_offset = iOffset;
+			_size = 0;
+			_firstTime = 0;
+			_lastTime = 0;
+			std::memset(_levels, 0, sizeof(_levels));
+			std::memset(_threads, 0, sizeof(_threads));
+		}
+
+		void LogIndexEntry::add(const LogMessage& iLogMessage) {
+			//messages are merged by time per batch only, keep the true range
+			if (getCount() == 0 || iLogMessage._time < _firstTime) {
+				_firstTime = iLogMessage._time;
+			}
+			if (iLogMessage._time > _lastTime) {
+				_lastTime = iLogMessage._time;
+			}
+			++_levels[iLogMessage._level <= LEVEL_OFF ? iLogMessage._level : LEVEL_OFF];
+			const unsigned int aBit = iLogMessage._threadIndex % EVOLVE_LOG_INDEX_THREAD_BITS;
+			_threads[aBit / 64] |= 1ULL << (aBit % 64);
+		}
+
+		bool LogIndexEntry::hasThread(unsigned int iThreadIndex) const {
+			const unsigned int aBit = iThreadIndex % EVOLVE_LOG_INDEX_THREAD_BITS;
+			return (_threads[aBit / 64] & (1ULL << (aBit % 64))) != 0;
+		}
+
+		bool LogIndexEntry::hasLevel(LogLevel iLevel) const {
+			for (int i = iLevel; i <= LEVEL_OFF; ++i) {
+				if (_levels[i] != 0) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		unsigned long long LogIndexEntry::getCount() const {
+			unsigned long long aCount = 0;
+			for (int i = 0; i <= LEVEL_OFF; ++i) {
+				aCount += _levels[i];
+			}
+			return aCount;
+		}
+
+		static void WriteHeader(std::ofstream& ioStream) {
+			const unsigned int aVersion = EVOLVE_LOG_INDEX_VERSION;
+			const unsigned int aEntrySize = sizeof(LogIndexEntry);
+			ioStream.write(EVOLVE_LOG_INDEX_MAGIC, IndexMagicSize);
+			ioStream.write(reinterpret_cast<const char*>(&aVersion), sizeof(aVersion));
+			ioStream.write(reinterpret_cast<const char*>(&aEntrySize), sizeof(aEntrySize));
+		}
+
+		bool ReadLogIndex(const std::string& iLogFile, std::vector<LogIndexEntry>& oEntries) {
+			oEntries.clear();
+			std::ifstream aStream((iLogFile + EVOLVE_LOG_INDEX_EXTENSION).c_str(), std::ifstream::in | std::ifstream::binary);
+			char aHeader[IndexHeaderSize];
+			if (!aStream.read(aHeader, sizeof(aHeader))) {
+				return false;
+			}
+			unsigned int aVersion;
+			unsigned int aEntrySize;
+			std::memcpy(&aVersion, aHeader + IndexMagicSize, sizeof(aVersion));
+			std::memcpy(&aEntrySize, aHeader + IndexMagicSize + sizeof(aVersion), sizeof(aEntrySize));
+			if (std::memcmp(aHeader, EVOLVE_LOG_INDEX_MAGIC, IndexMagicSize) != 0 || aVersion != EVOLVE_LOG_INDEX_VERSION
+				|| aEntrySize != sizeof(LogIndexEntry)) {
+				return false;
+			}
+
+			//a truncated last entry, from a crash during its write, is ignored
+			LogIndexEntry aEntry;
+			while (aStream.read(reinterpret_cast<char*>(&aEntry), sizeof(aEntry))) {
+				oEntries.push_back(aEntry);
+			}
+			return true;
+		}
+
+		LogIndexWriter::LogIndexWriter()
+			:_stream() {}
+
+		LogIndexWriter::~LogIndexWriter() {
+			close();
+		}
+
+		bool LogIndexWriter::open(const std::string& iLogFile, unsigned long long iLogSize) {
+			close();
+			const std::string aPath = iLogFile + EVOLVE_LOG_INDEX_EXTENSION;
+
+			//keep the entries still describing the log file, rewrite the index if anything else is there
+			std::vector<LogIndexEntry> aEntries;
+			bool aValid = ReadLogIndex(iLogFile, aEntries);
+			std::size_t aKept = 0;
+			while (aKept < aEntries.size() && aEntries[aKept]._offset + aEntries[aKept]._size <= iLogSize) {
+				++aKept;
+			}
+			if (aValid) {
+				std::ifstream aSize(aPath.c_str(), std::ifstream::in | std::ifstream::binary | std::ifstream::ate);
+				aValid = aKept == aEntries.size()
+					&& static_cast<unsigned long long>(aSize.tellg()) == IndexHeaderSize + aEntries.size() * sizeof(LogIndexEntry);
+			}
+
+			if (aValid) {
+				_stream.open(aPath.c_str(), std::ofstream::out | std::ofstream::app | std::ofstream::binary);
+			}
+			else {
+				_stream.open(aPath.c_str(), std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+				if (_stream.is_open()) {
+					WriteHeader(_stream);
+					aEntries.resize(aKept);
+					write(aEntries);
+				}
+			}
+			if (!_stream.is_open()) {
+				std::cerr << "Can't open log index file " << aPath << std::endl;
+				return false;
+			}
+			return true;
+		}
+
+		void LogIndexWriter::close() {
+			if (_stream.is_open()) {
+				_stream.close();
+			}
+		}
+
+		void LogIndexWriter::write(const std::vector<LogIndexEntry>& iEntries) {
+			if (!_stream.is_open() || iEntries.empty()) {
+				return;
+			}
+			_stream.write(reinterpret_cast<const char*>(iEntries.data()), iEntries.size() * sizeof(LogIndexEntry));
+			_stream.flush();
+		}
+    }
+}
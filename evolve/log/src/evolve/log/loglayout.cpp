@@ -0,0 +1,341 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/loglayout.cpp
+ * \brief evolve/log pattern based log line formatter source file
+ * \author
+ *
+ */
+
+#include <evolve/log/loglayout.h>
+#include <evolve/log/binaryfileloggerreporter.h>
+#include <evolve/utils/threadutils.h>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		LogLayout::LogLayout(const char* iPattern, unsigned int iFractionDigits)
+			:_operations(), _text(), _clock(iFractionDigits), _threadName() {
+			const char* aCursor = iPattern != NULL ? iPattern : EVOLVE_LOG_DEFAULT_PATTERN;
+			while (*aCursor != '\0') {
+				if (*aCursor != '%' || aCursor[1] == '\0' || aCursor[1] == '%') {
+					//literal text, merged with the previous literal
+					if (_operations.empty() || _operations.back()._type != OPERATION_TEXT) {
+						Operation aText = { OPERATION_TEXT, 0, false, ' ', _text.size(), 0 };
+						_operations.push_back(aText);
+					}
+					_text += *aCursor;
+					++_operations.back()._length;
+					aCursor += *aCursor == '%' && aCursor[1] == '%' ? 2 : 1;
+					continue;
+				}
+
+				const char* aStart = aCursor++;
+				Operation aOperation = { OPERATION_TEXT, 0, false, ' ', 0, 0 };
+				if (*aCursor == '-') {
+					aOperation._left = true;
+					++aCursor;
+				}
+				if (*aCursor == '0') {
+					aOperation._fill = '0';
+					++aCursor;
+				}
+				while (*aCursor >= '0' && *aCursor <= '9') {
+					aOperation._width = aOperation._width * 10 + static_cast<unsigned int>(*aCursor - '0');
+					++aCursor;
+				}
+
+				bool aKnown = true;
+				switch (*aCursor) {
+				case 'T': aOperation._type = OPERATION_TIME; break;
+				case 'L': aOperation._type = OPERATION_LEVEL; break;
+				case 'm': aOperation._type = OPERATION_MESSAGE; break;
+				case 'k': aOperation._type = OPERATION_FIELDS; break;
+				case 'f': aOperation._type = OPERATION_FILE; break;
+				case 'l': aOperation._type = OPERATION_LINE; break;
+				case 'F': aOperation._type = OPERATION_FUNCTION; break;
+				case 't': aOperation._type = OPERATION_THREAD; break;
+				case 'i': aOperation._type = OPERATION_THREAD_INDEX; break;
+				case 'n': aOperation._type = OPERATION_THREAD_NAME; break;
+				case 'I': aOperation._type = OPERATION_THREAD_ID; break;
+				case 'c': aOperation._type = OPERATION_CHANNEL; break;
+				default: aKnown = false; break;
+				}
+
+				if (!aKnown) {
+					//copy the unknown conversion as is
+					const std::size_t aLength = static_cast<std::size_t>(aCursor - aStart) + (*aCursor != '\0' ? 1 : 0);
+					Operation aText = { OPERATION_TEXT, 0, false, ' ', _text.size(), aLength };
+					_text.append(aStart, aLength);
+					_operations.push_back(aText);
+					aCursor = aStart + aLength;
+					continue;
+				}
+				_operations.push_back(aOperation);
+				++aCursor;
+			}
+		}
+
+		void LogLayout::format(const LogMessage& iLogMessage, std::string& oLine) {
+			oLine.clear();
+			append(iLogMessage, oLine);
+		}
+
+		void LogLayout::append(const LogMessage& iLogMessage, std::string& ioBuffer) {
+			append(iLogMessage, static_cast<unsigned long long>(std::hash<std::thread::id>()(iLogMessage._threadId)), true, ioBuffer);
+		}
+
+		void LogLayout::append(const LogMessage& iLogMessage, unsigned long long iThreadId, std::string& ioBuffer) {
+			append(iLogMessage, iThreadId, false, ioBuffer);
+		}
+
+		void LogLayout::append(const BinaryLogRecord& iRecord, std::string& ioBuffer) {
+			LogMessage aMessage;
+			aMessage._level = iRecord._level <= LEVEL_OFF ? iRecord._level : LEVEL_OFF;
+			aMessage._time = iRecord._time;
+			aMessage._file = iRecord._file.c_str();
+			aMessage._line = iRecord._line;
+			aMessage._func = iRecord._func.c_str();
+			aMessage._threadIndex = iRecord._threadIndex;
+			aMessage._message = iRecord._message;
+			append(aMessage, iRecord._threadId, false, ioBuffer);
+		}
+
+		void LogLayout::append(const LogMessage& iLogMessage, unsigned long long iThreadId, bool iThreadNames, std::string& ioBuffer) {
+			for (std::vector<Operation>::const_iterator aIt = _operations.begin(); aIt != _operations.end(); ++aIt) {
+				const Operation& aOperation = *aIt;
+				switch (aOperation._type) {
+				case OPERATION_TEXT:
+					ioBuffer.append(_text, aOperation._offset, aOperation._length);
+					break;
+				case OPERATION_TIME: {
+					char aTime[32];
+					const std::size_t aLength = _clock.formatDateAndTime(iLogMessage._time, aTime);
+					AppendPadded(ioBuffer, aTime, aLength, aOperation);
+					break;
+				}
+				case OPERATION_LEVEL: {
+					const char* aLevel = static_cast<std::size_t>(iLogMessage._level) < Logger::_LogLevelStringMap.size()
+						? Logger::_LogLevelStringMap[iLogMessage._level].c_str() : "?";
+					AppendPadded(ioBuffer, aLevel, std::strlen(aLevel), aOperation);
+					break;
+				}
+				case OPERATION_MESSAGE:
+					AppendPadded(ioBuffer, iLogMessage._message.data(), iLogMessage._message.size(), aOperation);
+					break;
+				case OPERATION_FIELDS:
+					AppendFields(ioBuffer, iLogMessage._fields);
+					break;
+				case OPERATION_FILE:
+					AppendPadded(ioBuffer, iLogMessage._file, iLogMessage._file != NULL ? std::strlen(iLogMessage._file) : 0, aOperation);
+					break;
+				case OPERATION_LINE:
+					AppendNumber(ioBuffer, iLogMessage._line, aOperation);
+					break;
+				case OPERATION_FUNCTION:
+					AppendPadded(ioBuffer, iLogMessage._func, iLogMessage._func != NULL ? std::strlen(iLogMessage._func) : 0, aOperation);
+					break;
+				case OPERATION_THREAD:
+					if (iThreadNames && evolve::utils::GetThreadName(iLogMessage._threadIndex, _threadName)) {
+						AppendPadded(ioBuffer, _threadName.data(), _threadName.size(), aOperation);
+					}
+					else {
+						AppendNumber(ioBuffer, iLogMessage._threadIndex, aOperation);
+					}
+					break;
+				case OPERATION_THREAD_INDEX:
+					AppendNumber(ioBuffer, iLogMessage._threadIndex, aOperation);
+					break;
+				case OPERATION_THREAD_NAME:
+					if (iThreadNames) {
+						evolve::utils::GetThreadName(iLogMessage._threadIndex, _threadName);
+					}
+					else {
+						_threadName.clear();
+					}
+					AppendPadded(ioBuffer, _threadName.data(), _threadName.size(), aOperation);
+					break;
+				case OPERATION_THREAD_ID:
+					AppendNumber(ioBuffer, iThreadId, aOperation);
+					break;
+				case OPERATION_CHANNEL: {
+					//channels, like thread names, are only known by the writing process
+					const char* aChannel = iThreadNames ? Logger::GetChannelName(iLogMessage._channel) : "";
+					AppendPadded(ioBuffer, aChannel, std::strlen(aChannel), aOperation);
+					break;
+				}
+				}
+			}
+		}
+
+		bool LogLayout::parse(const char* iLine, std::size_t iLength, LogLineHeader& oHeader) const {
+			oHeader._hasTime = false;
+			oHeader._time = 0;
+			oHeader._hasLevel = false;
+			oHeader._level = LEVEL_OFF;
+			oHeader._hasThread = false;
+			oHeader._threadIndex = 0;
+			oHeader._threadName.clear();
+
+			const std::string aLine(iLine, iLength);
+			std::size_t aPosition = 0;
+			for (std::size_t i = 0; i < _operations.size(); ++i) {
+				const Operation& aOperation = _operations[i];
+				if (aOperation._type == OPERATION_TEXT) {
+					if (aLine.compare(aPosition, aOperation._length, _text, aOperation._offset, aOperation._length) != 0) {
+						return false;
+					}
+					aPosition += aOperation._length;
+					continue;
+				}
+				if (aOperation._type == OPERATION_MESSAGE || aOperation._type == OPERATION_FIELDS) {
+					return true;
+				}
+
+				//the value ends where the next literal starts, or at the end of the line
+				std::size_t aEnd = iLength;
+				if (i + 1 < _operations.size()) {
+					const Operation& aNext = _operations[i + 1];
+					if (aNext._type != OPERATION_TEXT) {
+						return true;
+					}
+					aEnd = aLine.find(_text.data() + aNext._offset, aPosition, aNext._length);
+					if (aEnd == std::string::npos) {
+						return false;
+					}
+				}
+				std::size_t aStart = aPosition;
+				aPosition = aEnd;
+				while (aStart < aEnd && aLine[aStart] == ' ') {
+					++aStart;
+				}
+				while (aEnd > aStart && aLine[aEnd - 1] == ' ') {
+					--aEnd;
+				}
+
+				switch (aOperation._type) {
+				case OPERATION_TIME:
+					if (!evolve::utils::Clock::ParseDateAndTime(iLine + aStart, aEnd - aStart, oHeader._time)) {
+						return false;
+					}
+					oHeader._hasTime = true;
+					break;
+				case OPERATION_LEVEL: {
+					std::size_t aLevel = 0;
+					while (aLevel < Logger::_LogLevelStringMap.size() && aLine.compare(aStart, aEnd - aStart, Logger::_LogLevelStringMap[aLevel]) != 0) {
+						++aLevel;
+					}
+					if (aLevel == Logger::_LogLevelStringMap.size()) {
+						return false;
+					}
+					oHeader._level = static_cast<LogLevel>(aLevel);
+					oHeader._hasLevel = true;
+					break;
+				}
+				case OPERATION_THREAD:
+				case OPERATION_THREAD_INDEX: {
+					//%t holds the name of named threads, which says nothing of the index
+					unsigned long long aIndex = 0;
+					std::size_t aDigit = aStart;
+					while (aDigit < aEnd && aLine[aDigit] >= '0' && aLine[aDigit] <= '9') {
+						aIndex = aIndex * 10 + static_cast<unsigned long long>(aLine[aDigit++] - '0');
+					}
+					if (aDigit == aEnd && aEnd != aStart) {
+						oHeader._threadIndex = aIndex;
+						oHeader._hasThread = true;
+					}
+					else if (aOperation._type == OPERATION_THREAD_INDEX) {
+						return false;
+					}
+					else {
+						oHeader._threadName.assign(aLine, aStart, aEnd - aStart);
+					}
+					break;
+				}
+				case OPERATION_THREAD_NAME:
+					oHeader._threadName.assign(aLine, aStart, aEnd - aStart);
+					break;
+				default:
+					break;
+				}
+			}
+			return true;
+		}
+
+		void LogLayout::AppendPadded(std::string& ioBuffer, const char* iText, std::size_t iLength, const Operation& iOperation) {
+			const std::size_t aPadding = iOperation._width > iLength ? iOperation._width - iLength : 0;
+			if (!iOperation._left) {
+				ioBuffer.append(aPadding, iOperation._fill);
+			}
+			ioBuffer.append(iText, iLength);
+			if (iOperation._left) {
+				ioBuffer.append(aPadding, ' ');
+			}
+		}
+
+		void LogLayout::AppendNumber(std::string& ioBuffer, unsigned long long iValue, const Operation& iOperation) {
+			char aDigits[20];
+			std::size_t aCount = sizeof(aDigits);
+			do {
+				aDigits[--aCount] = static_cast<char>('0' + iValue % 10);
+				iValue /= 10;
+			} while (iValue != 0);
+			AppendPadded(ioBuffer, aDigits + aCount, sizeof(aDigits) - aCount, iOperation);
+		}
+
+		void LogLayout::AppendFields(std::string& ioBuffer, const LogFields& iFields) {
+			char aNumber[32];
+			std::size_t aIndex = 0;
+			std::size_t aOffset = 0;
+			LogField aField;
+			while (iFields.read(aIndex, aOffset, aField)) {
+				ioBuffer += ' ';
+				ioBuffer += aField._key;
+				ioBuffer += '=';
+				int aLength = 0;
+				switch (aField._value._type) {
+				case ARGUMENT_INT: aLength = std::snprintf(aNumber, sizeof(aNumber), "%lld", aField._value._int); break;
+				case ARGUMENT_UINT: aLength = std::snprintf(aNumber, sizeof(aNumber), "%llu", aField._value._uint); break;
+				case ARGUMENT_DOUBLE: aLength = std::snprintf(aNumber, sizeof(aNumber), "%g", aField._value._double); break;
+				case ARGUMENT_BOOL: ioBuffer += aField._value._bool ? "true" : "false"; break;
+				case ARGUMENT_CHAR: ioBuffer += aField._value._char; break;
+				case ARGUMENT_POINTER: aLength = std::snprintf(aNumber, sizeof(aNumber), "%p", aField._value._pointer); break;
+				case ARGUMENT_STRING: ioBuffer.append(aField._value._string, aField._value._length); break;
+				}
+				if (aLength > 0) {
+					ioBuffer.append(aNumber, static_cast<std::size_t>(aLength));
+				}
+			}
+		}
+    }
+}
@@ -0,0 +1,227 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/logsuppressor.cpp
+ * \brief evolve/log duplicate message suppression and rate limiting source file
+ * \author
+ *
+ */
+
+#include <evolve/log/logsuppressor.h>
+#include <evolve/utils/clock.h>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		static const unsigned long long TOKEN = 1000000000ULL; ///< one token, in billionths
+
+		//never destroyed: the logger may still expire suppressors during static destruction
+		static std::mutex& SuppressorsMutex() {
+			static std::mutex* aMutex = new std::mutex();
+			return *aMutex;
+		}
+
+		static std::vector<LogSuppressor*>& Suppressors() {
+			static std::vector<LogSuppressor*>* aSuppressors = new std::vector<LogSuppressor*>();
+			return *aSuppressors;
+		}
+
+		//summaries of destroyed suppressors, waiting for the logger thread
+		static std::vector<LogMessage>& OrphanSummaries() {
+			static std::vector<LogMessage>* aSummaries = new std::vector<LogMessage>();
+			return *aSummaries;
+		}
+
+		LogSuppressor::LogSuppressor(unsigned int iWindowMs, unsigned int iRatePerSecond, unsigned int iBurst)
+			:_window(static_cast<unsigned long long>(iWindowMs) * 1000000ULL),
+			 _rate(iRatePerSecond),
+			 _burst(static_cast<unsigned long long>(iBurst) * TOKEN),
+			 _shards() {
+			std::lock_guard<std::mutex> aLock(SuppressorsMutex());
+			Suppressors().push_back(this);
+		}
+
+		LogSuppressor::~LogSuppressor() {
+			std::lock_guard<std::mutex> aLock(SuppressorsMutex());
+			std::vector<LogSuppressor*>& aSuppressors = Suppressors();
+			aSuppressors.erase(std::remove(aSuppressors.begin(), aSuppressors.end(), this), aSuppressors.end());
+			expire(evolve::utils::Clock::Now(true), true, OrphanSummaries());
+		}
+
+		bool LogSuppressor::admit(unsigned long long iMessageId, unsigned long long iCallSite, unsigned long long& oSuppressed,
+			LogLevel iLevel, const char* iFile, unsigned int iLine, const char* iFunction, const char* iLabel) {
+			//the coarse clock is enough at window resolution, and cheap under a message storm
+			const unsigned long long aNow = evolve::utils::Clock::Now(true);
+			const unsigned long long aKey = Key(iMessageId, iCallSite);
+			Shard& aShard = shard(aKey);
+
+			std::lock_guard<std::mutex> aLock(aShard._mutex);
+			std::unordered_map<unsigned long long, Entry>::iterator aIt = aShard._entries.find(aKey);
+			if (aIt == aShard._entries.end()) {
+				if (aShard._entries.size() >= EVOLVE_LOG_SUPPRESSOR_KEYS) {
+					forgetIdle(aShard, aNow);
+				}
+				Entry aEntry;
+				aEntry._lastLogged = aNow;
+				aEntry._lastRefill = aNow;
+				aEntry._tokens = _burst >= TOKEN ? _burst - TOKEN : 0;
+				aEntry._suppressed = 0;
+				aEntry._level = iLevel;
+				aEntry._file = iFile;
+				aEntry._line = iLine;
+				aEntry._function = iFunction;
+				aEntry._label[0] = '\0';
+				if (iLabel != NULL) {
+					CopyLabel(aEntry, iLabel, std::strlen(iLabel));
+				}
+				aShard._entries.insert(std::make_pair(aKey, aEntry));
+				oSuppressed = 0;
+				return true;
+			}
+
+			Entry& aEntry = aIt->second;
+			if (_burst != 0) {
+				//refill, saturating at the bucket size
+				const unsigned long long aElapsed = aNow > aEntry._lastRefill ? aNow - aEntry._lastRefill : 0;
+				const unsigned long long aMissing = _burst - aEntry._tokens;
+				aEntry._tokens = (_rate == 0 || aElapsed >= aMissing / _rate) ? _burst : aEntry._tokens + aElapsed * _rate;
+				aEntry._lastRefill = aNow;
+			}
+
+			const bool aInWindow = _window != 0 && aNow < aEntry._lastLogged + _window;
+			const bool aLimited = _burst != 0 && aEntry._tokens < TOKEN;
+			if (aInWindow || aLimited) {
+				++aEntry._suppressed;
+				return false;
+			}
+
+			if (_burst != 0) {
+				aEntry._tokens -= TOKEN;
+			}
+			aEntry._lastLogged = aNow;
+			oSuppressed = aEntry._suppressed;
+			aEntry._suppressed = 0;
+			return true;
+		}
+
+		void LogSuppressor::label(unsigned long long iMessageId, unsigned long long iCallSite, const char* iText, std::size_t iLength) {
+			const unsigned long long aKey = Key(iMessageId, iCallSite);
+			Shard& aShard = shard(aKey);
+			std::lock_guard<std::mutex> aLock(aShard._mutex);
+			std::unordered_map<unsigned long long, Entry>::iterator aIt = aShard._entries.find(aKey);
+			if (aIt != aShard._entries.end() && aIt->second._label[0] == '\0') {
+				CopyLabel(aIt->second, iText, iLength);
+			}
+		}
+
+		void LogSuppressor::Expire(unsigned long long iNow, bool iAll, std::vector<LogMessage>& oMessages) {
+			std::lock_guard<std::mutex> aLock(SuppressorsMutex());
+			std::vector<LogMessage>& aOrphans = OrphanSummaries();
+			for (std::size_t i = 0; i < aOrphans.size(); ++i) {
+				oMessages.push_back(std::move(aOrphans[i]));
+			}
+			aOrphans.clear();
+
+			const std::vector<LogSuppressor*>& aSuppressors = Suppressors();
+			for (std::size_t i = 0; i < aSuppressors.size(); ++i) {
+				aSuppressors[i]->expire(iNow, iAll, oMessages);
+			}
+		}
+
+		void LogSuppressor::expire(unsigned long long iNow, bool iAll, std::vector<LogMessage>& oMessages) {
+			for (std::size_t s = 0; s < EVOLVE_LOG_SUPPRESSOR_SHARDS; ++s) {
+				std::lock_guard<std::mutex> aLock(_shards[s]._mutex);
+				std::unordered_map<unsigned long long, Entry>::iterator aIt = _shards[s]._entries.begin();
+				for (; aIt != _shards[s]._entries.end(); ++aIt) {
+					//a key still in its window will report its count with its next logged occurrence
+					Entry& aEntry = aIt->second;
+					if (aEntry._suppressed == 0 || (!iAll && iNow < aEntry._lastLogged + _window)) {
+						continue;
+					}
+
+					std::stringstream aSs;
+					aSs << "last message repeated " << aEntry._suppressed << " times";
+					if (aEntry._label[0] != '\0') {
+						aSs << ": " << aEntry._label;
+					}
+					LogMessage aLogMessage;
+					EVOLVE_LOG_INIT_(aLogMessage, aEntry._level, aEntry._file != NULL ? aEntry._file : __FILE__,
+						aEntry._file != NULL ? aEntry._line : __LINE__, aEntry._function != NULL ? aEntry._function : __FUNCTION__);
+					aLogMessage._message = aSs.str();
+					oMessages.push_back(std::move(aLogMessage));
+
+					//the summary counts as a logged occurrence
+					aEntry._suppressed = 0;
+					aEntry._lastLogged = iNow;
+				}
+			}
+		}
+
+		unsigned long long LogSuppressor::Key(unsigned long long iMessageId, unsigned long long iCallSite) {
+			return iMessageId * 0x9E3779B97F4A7C15ULL ^ iCallSite;
+		}
+
+		void LogSuppressor::CopyLabel(Entry& ioEntry, const char* iText, std::size_t iLength) {
+			//first line only, cut with an ellipsis when too long
+			const char* aEnd = static_cast<const char*>(std::memchr(iText, '\n', iLength));
+			std::size_t aLength = aEnd != NULL ? static_cast<std::size_t>(aEnd - iText) : iLength;
+			const bool aCut = aLength != iLength || aLength >= EVOLVE_LOG_SUPPRESSOR_LABEL_SIZE;
+			if (aCut && aLength > EVOLVE_LOG_SUPPRESSOR_LABEL_SIZE - 4) {
+				aLength = EVOLVE_LOG_SUPPRESSOR_LABEL_SIZE - 4;
+			}
+			std::memcpy(ioEntry._label, iText, aLength);
+			if (aCut) {
+				std::memcpy(ioEntry._label + aLength, "...", 3);
+				aLength += 3;
+			}
+			ioEntry._label[aLength] = '\0';
+		}
+
+		LogSuppressor::Shard& LogSuppressor::shard(unsigned long long iKey) {
+			return _shards[(iKey ^ (iKey >> 32)) % EVOLVE_LOG_SUPPRESSOR_SHARDS];
+		}
+
+		void LogSuppressor::forgetIdle(Shard& ioShard, unsigned long long iNow) {
+			//keys with nothing left to summarise and out of their window start over
+			std::unordered_map<unsigned long long, Entry>::iterator aIt = ioShard._entries.begin();
+			while (aIt != ioShard._entries.end()) {
+				if (aIt->second._suppressed == 0 && iNow >= aIt->second._lastLogged + _window) {
+					aIt = ioShard._entries.erase(aIt);
+				}
+				else {
+					++aIt;
+				}
+			}
+		}
+    }
+}
@@ -0,0 +1,200 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/logtext.cpp
+ * \brief evolve/log message text storage source file
+ * \author
+ *
+ */
+
+#include <evolve/log/logtext.h>
+#include <atomic>
+#include <mutex>
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		/**
+		 * \brief Free blocks of one size class, linked through their first bytes
+		 */
+		struct LogTextFreeList {
+			std::mutex _mutex;
+			char* _first;
+		};
+
+		static const std::size_t LogTextClassCount = 5;
+		static const std::size_t LogTextClassSizes[LogTextClassCount] = { 256, 1 << 10, 4 << 10, 16 << 10, 64 << 10 };
+
+		//constant initialized, usable from static constructors and destructors
+		static LogTextFreeList LogTextFreeLists[LogTextClassCount];
+		static std::atomic<std::size_t> LogTextReservedSize(0);
+
+		static std::size_t FindClass(std::size_t iSize) {
+			std::size_t aClass = 0;
+			while (aClass < LogTextClassCount && LogTextClassSizes[aClass] < iSize) {
+				++aClass;
+			}
+			return aClass;
+		}
+
+		char* LogTextPool::Acquire(std::size_t iSize, std::size_t& oCapacity) {
+			const std::size_t aClass = FindClass(iSize);
+			if (aClass == LogTextClassCount) {
+				oCapacity = iSize;
+				return new char[iSize];
+			}
+			oCapacity = LogTextClassSizes[aClass];
+
+			LogTextFreeList& aList = LogTextFreeLists[aClass];
+			std::lock_guard<std::mutex> aLock(aList._mutex);
+			if (aList._first == NULL) {
+				//carve a new slab, its blocks are recycled for the whole process lifetime
+				const std::size_t aSlabSize = oCapacity < EVOLVE_LOG_TEXT_SLAB_SIZE ? EVOLVE_LOG_TEXT_SLAB_SIZE : oCapacity;
+				char* aSlab = new char[aSlabSize];
+				LogTextReservedSize.fetch_add(aSlabSize, std::memory_order_relaxed);
+				for (std::size_t aOffset = 0; aOffset + oCapacity <= aSlabSize; aOffset += oCapacity) {
+					char* aBlock = aSlab + aOffset;
+					std::memcpy(aBlock, &aList._first, sizeof(char*));
+					aList._first = aBlock;
+				}
+			}
+			char* aBlock = aList._first;
+			std::memcpy(&aList._first, aBlock, sizeof(char*));
+			return aBlock;
+		}
+
+		void LogTextPool::Release(char* iBlock, std::size_t iCapacity) {
+			const std::size_t aClass = FindClass(iCapacity);
+			if (aClass == LogTextClassCount) {
+				delete[] iBlock;
+				return;
+			}
+
+			LogTextFreeList& aList = LogTextFreeLists[aClass];
+			std::lock_guard<std::mutex> aLock(aList._mutex);
+			std::memcpy(iBlock, &aList._first, sizeof(char*));
+			aList._first = iBlock;
+		}
+
+		std::size_t LogTextPool::GetReservedSize() {
+			return LogTextReservedSize.load(std::memory_order_relaxed);
+		}
+
+		void LogText::grow(std::size_t iSize) {
+			//at least double, so a text streamed char by char is copied a few times only
+			const std::size_t aNeeded = iSize + 1 > 2 * _capacity ? iSize + 1 : 2 * _capacity;
+			std::size_t aCapacity = 0;
+			char* aBlock = LogTextPool::Acquire(aNeeded, aCapacity);
+			std::memcpy(aBlock, data(), _size + 1);
+			if (_spill != NULL) {
+				LogTextPool::Release(_spill, _capacity);
+			}
+			_spill = aBlock;
+			_capacity = aCapacity;
+		}
+
+
+		LogStream::Buffer::Buffer()
+			:std::streambuf(), _text(NULL) {}
+
+		void LogStream::Buffer::attach(LogText* iText) {
+			_text = iText;
+			_text->clear();
+			setp(_text->data(), _text->data() + _text->capacity() - 1);
+		}
+
+		void LogStream::Buffer::detach() {
+			_text->resize(static_cast<std::size_t>(pptr() - pbase()));
+			setp(NULL, NULL);
+			_text = NULL;
+		}
+
+		LogStream::Buffer::int_type LogStream::Buffer::overflow(int_type iChar) {
+			if (_text == NULL) {
+				return traits_type::eof();
+			}
+			if (traits_type::eq_int_type(iChar, traits_type::eof())) {
+				return traits_type::not_eof(iChar);
+			}
+
+			//the put area is full: move to a larger block, keeping what has been written
+			const std::size_t aSize = static_cast<std::size_t>(pptr() - pbase());
+			_text->resize(aSize);
+			_text->reserve(aSize + 1);
+			setp(_text->data(), _text->data() + _text->capacity() - 1);
+			for (std::size_t aSkipped = 0; aSkipped < aSize; ) {
+				const int aStep = aSize - aSkipped < 0x40000000 ? static_cast<int>(aSize - aSkipped) : 0x40000000;
+				pbump(aStep);
+				aSkipped += static_cast<std::size_t>(aStep);
+			}
+			return sputc(traits_type::to_char_type(iChar));
+		}
+
+		LogStream::LogStream()
+			:std::ostream(NULL), _buffer(), _flags(flags()), _busy(false) {
+			rdbuf(&_buffer);
+		}
+
+		void LogStream::attach(LogText& oText) {
+			_busy = true;
+			_buffer.attach(&oText);
+			clear();
+			flags(_flags);
+			precision(6);
+			width(0);
+			fill(' ');
+		}
+
+		void LogStream::detach() {
+			_buffer.detach();
+			_busy = false;
+		}
+
+		LogStream::Scope::Scope(LogText& oText)
+			:_stream(NULL), _owned(false) {
+			static thread_local LogStream Local;
+			if (Local._busy) {
+				_stream = new LogStream();
+				_owned = true;
+			}
+			else {
+				_stream = &Local;
+			}
+			_stream->attach(oText);
+		}
+
+		LogStream::Scope::~Scope() {
+			_stream->detach();
+			if (_owned) {
+				delete _stream;
+			}
+		}
+    }
+}
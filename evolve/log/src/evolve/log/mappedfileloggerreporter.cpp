@@ -0,0 +1,248 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+
+/**
+ * \file evolve/log/mappedfileloggerreporter.cpp
+ * \brief evolve/log memory-mapped file reporter source file
+ * \author
+ *
+ */
+
+#include <evolve/log/mappedfileloggerreporter.h>
+#include <evolve/utils/clock.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		static bool SegmentExists(const std::string& iPath) {
+			std::FILE* aFile = std::fopen(iPath.c_str(), "rb");
+			if (aFile == NULL) {
+				return false;
+			}
+			std::fclose(aFile);
+			return true;
+		}
+
+#ifndef WIN32
+		static bool AllocateSegment(int iDescriptor, std::size_t iSize) {
+			//ftruncate alone gives a sparse file, and a full disk then raises SIGBUS on a copy
+#if defined(__linux__)
+			const int aError = ::posix_fallocate(iDescriptor, 0, static_cast<off_t>(iSize));
+			if (aError == 0) {
+				return true;
+			}
+			if (aError == ENOSPC) {
+				return false;
+			}
+#endif
+			//file system without fallocate: write the blocks
+			static const char aZeros[65536] = {0};
+			std::size_t aOffset = 0;
+			while (aOffset < iSize) {
+				const std::size_t aChunk = iSize - aOffset < sizeof(aZeros) ? iSize - aOffset : sizeof(aZeros);
+				const ssize_t aWritten = ::pwrite(iDescriptor, aZeros, aChunk, static_cast<off_t>(aOffset));
+				if (aWritten < 0 && errno == EINTR) {
+					continue;
+				}
+				if (aWritten <= 0) {
+					return false;
+				}
+				aOffset += static_cast<std::size_t>(aWritten);
+			}
+			return true;
+		}
+#endif
+
+        MappedFileLoggerReporter::MappedFileLoggerReporter(const char* iFile, std::size_t iSegmentSize, const char* iPattern)
+                :LoggerReporter(iPattern),
+				 _file(iFile),
+				 _segmentPath(),
+				 _segmentSize(iSegmentSize),
+				 _segmentIndex(0),
+				 _mapping(NULL),
+				 _offset(0),
+				 _retryTime(0),
+				 _lostLines(0),
+#ifdef WIN32
+				 _fileHandle(INVALID_HANDLE_VALUE),
+				 _mappingHandle(NULL),
+#else
+				 _fileDescriptor(-1),
+#endif
+				 _line() {
+			openSegment();
+		}
+
+        MappedFileLoggerReporter::~MappedFileLoggerReporter() {
+			closeSegment();
+		}
+
+        void MappedFileLoggerReporter::log(const LogMessage& iLogMessage) {
+			logBatch(&iLogMessage, 1);
+        }
+
+		void MappedFileLoggerReporter::logBatch(const LogMessage* iLogMessages, std::size_t iCount) {
+			for (std::size_t i = 0; i < iCount; ++i) {
+				formatLogMessage(iLogMessages[i], _line);
+				_line += '\n';
+				append(_line.data(), _line.size());
+			}
+		}
+
+		void MappedFileLoggerReporter::append(const char* iData, std::size_t iSize) {
+			while (iSize > 0) {
+				if (_mapping == NULL || _offset == _segmentSize) {
+					closeSegment();
+					//after a failure, don't hit the file system for every line
+					if (_retryTime != 0 && evolve::utils::Clock::Now(true) < _retryTime) {
+						++_lostLines;
+						return;
+					}
+					if (!openSegment()) {
+						++_lostLines;
+						return;
+					}
+				}
+				const std::size_t aChunk = iSize < _segmentSize - _offset ? iSize : _segmentSize - _offset;
+				std::memcpy(_mapping + _offset, iData, aChunk);
+				_offset += aChunk;
+				iData += aChunk;
+				iSize -= aChunk;
+			}
+		}
+
+		bool MappedFileLoggerReporter::openSegment() {
+			//never overwrite segments of a previous run, nor of another process sharing the name:
+			//a segment created meanwhile fails the exclusive creation, the next index is taken then
+			bool aExists = false;
+			do {
+				do {
+					std::stringstream aSs;
+					aSs << _file << "." << _segmentIndex++;
+					_segmentPath = aSs.str();
+				} while (SegmentExists(_segmentPath));
+#ifdef WIN32
+				_fileHandle = CreateFileA(_segmentPath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+				aExists = _fileHandle == INVALID_HANDLE_VALUE && GetLastError() == ERROR_FILE_EXISTS;
+#else
+				_fileDescriptor = ::open(_segmentPath.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+				aExists = _fileDescriptor < 0 && errno == EEXIST;
+#endif
+			} while (aExists);
+
+			_offset = 0;
+#ifdef WIN32
+			const bool aCreated = _fileHandle != INVALID_HANDLE_VALUE;
+			if (aCreated) {
+				const unsigned long long aSize = _segmentSize;
+				_mappingHandle = CreateFileMappingA(_fileHandle, NULL, PAGE_READWRITE, static_cast<DWORD>(aSize >> 32), static_cast<DWORD>(aSize & 0xFFFFFFFF), NULL);
+				if (_mappingHandle != NULL) {
+					_mapping = static_cast<char*>(MapViewOfFile(_mappingHandle, FILE_MAP_WRITE, 0, 0, _segmentSize));
+				}
+			}
+#else
+			const bool aCreated = _fileDescriptor >= 0;
+			if (aCreated && AllocateSegment(_fileDescriptor, _segmentSize)) {
+				void* aMapping = ::mmap(NULL, _segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, _fileDescriptor, 0);
+				_mapping = aMapping != MAP_FAILED ? static_cast<char*>(aMapping) : NULL;
+			}
+#endif
+			if (_mapping == NULL) {
+				if (_retryTime == 0) {
+					std::cerr << "Can't map log segment : " << _segmentPath << ", lines are lost until it can" << std::endl;
+				}
+				closeSegment();
+				//only the empty file created here is removed, the index is tried again later
+				if (aCreated) {
+					std::remove(_segmentPath.c_str());
+				}
+				--_segmentIndex;
+				_retryTime = evolve::utils::Clock::Now(true) + EVOLVE_LOG_MAPPED_RETRY_SECONDS * 1000000000ULL;
+				return false;
+			}
+			if (_retryTime != 0) {
+				std::cerr << "Log segment " << _segmentPath << " mapped, " << _lostLines << " lines lost" << std::endl;
+				_retryTime = 0;
+				_lostLines = 0;
+			}
+			return true;
+		}
+
+		void MappedFileLoggerReporter::closeSegment() {
+#ifdef WIN32
+			if (_mapping != NULL) {
+				UnmapViewOfFile(_mapping);
+				_mapping = NULL;
+			}
+			if (_mappingHandle != NULL) {
+				CloseHandle(_mappingHandle);
+				_mappingHandle = NULL;
+			}
+			if (_fileHandle != INVALID_HANDLE_VALUE) {
+				//shrink the preallocated segment to its real length
+				LARGE_INTEGER aLength;
+				aLength.QuadPart = static_cast<LONGLONG>(_offset);
+				SetFilePointerEx(_fileHandle, aLength, NULL, FILE_BEGIN);
+				SetEndOfFile(_fileHandle);
+				CloseHandle(_fileHandle);
+				_fileHandle = INVALID_HANDLE_VALUE;
+			}
+#else
+			if (_mapping != NULL) {
+				::munmap(_mapping, _segmentSize);
+				_mapping = NULL;
+			}
+			if (_fileDescriptor >= 0) {
+				//shrink the preallocated segment to its real length
+				if (::ftruncate(_fileDescriptor, static_cast<off_t>(_offset)) != 0) {
+					std::cerr << "Can't truncate log segment : " << _segmentPath << std::endl;
+				}
+				::close(_fileDescriptor);
+				_fileDescriptor = -1;
+			}
+#endif
+			_offset = 0;
+		}
+    }
+}
@@ -0,0 +1,374 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/rotatingfileloggerreporter.cpp
+ * \brief evolve/log rotating file reporter source file
+ * \author
+ *
+ */
+
+#include <evolve/log/rotatingfileloggerreporter.h>
+#include <evolve/utils/clock.h>
+#include <evolve/utils/threadutils.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+extern char** environ;
+#endif
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		static bool FileExists(const std::string& iPath) {
+#ifdef WIN32
+			return GetFileAttributesA(iPath.c_str()) != INVALID_FILE_ATTRIBUTES;
+#else
+			struct stat aStat;
+			return ::stat(iPath.c_str(), &aStat) == 0;
+#endif
+		}
+
+		static std::size_t FileSize(const std::string& iPath) {
+			std::ifstream aFile(iPath.c_str(), std::ifstream::binary | std::ifstream::ate);
+			const std::streamoff aSize = aFile.is_open() ? static_cast<std::streamoff>(aFile.tellg()) : 0;
+			return aSize > 0 ? static_cast<std::size_t>(aSize) : 0;
+		}
+
+		/**
+		 * \brief A file renamed for the rotation thread, ordered by staging time then counter
+		 */
+		struct StagedFile {
+			unsigned long long _time;
+			unsigned long long _index;
+			std::string _path;
+
+			bool operator<(const StagedFile& iOther) const {
+				return _time != iOther._time ? _time < iOther._time : _index < iOther._index;
+			}
+		};
+
+		//"<time>.<index>", both decimal, and nothing else: index files and compressor outputs are left out
+		static bool ParseStagedSuffix(const std::string& iSuffix, StagedFile& oFile) {
+			const std::size_t aDot = iSuffix.find('.');
+			if (aDot == 0 || aDot == std::string::npos || aDot + 1 == iSuffix.size()
+				|| iSuffix.find_first_not_of("0123456789.") != std::string::npos || iSuffix.find('.', aDot + 1) != std::string::npos) {
+				return false;
+			}
+			oFile._time = std::strtoull(iSuffix.c_str(), NULL, 10);
+			oFile._index = std::strtoull(iSuffix.c_str() + aDot + 1, NULL, 10);
+			return true;
+		}
+
+		//files a previous run staged but did not archive before it stopped, oldest first
+		static std::vector<std::string> FindStagedFiles(const std::string& iFile) {
+			const std::size_t aSeparator = iFile.find_last_of("/\\");
+			const std::string aDirectory = aSeparator != std::string::npos ? iFile.substr(0, aSeparator + 1) : std::string();
+			const std::string aPrefix = iFile.substr(aSeparator != std::string::npos ? aSeparator + 1 : 0) + ".rotating.";
+
+			std::vector<std::string> aNames;
+#ifdef WIN32
+			WIN32_FIND_DATAA aData;
+			HANDLE aFind = FindFirstFileA((iFile + ".rotating.*").c_str(), &aData);
+			if (aFind != INVALID_HANDLE_VALUE) {
+				do {
+					aNames.push_back(aData.cFileName);
+				} while (FindNextFileA(aFind, &aData));
+				FindClose(aFind);
+			}
+#else
+			DIR* aDir = ::opendir(aDirectory.empty() ? "." : aDirectory.c_str());
+			if (aDir != NULL) {
+				while (struct dirent* aEntry = ::readdir(aDir)) {
+					aNames.push_back(aEntry->d_name);
+				}
+				::closedir(aDir);
+			}
+#endif
+
+			std::vector<StagedFile> aFiles;
+			for (std::size_t i = 0; i < aNames.size(); ++i) {
+				StagedFile aFile;
+				if (aNames[i].compare(0, aPrefix.size(), aPrefix) == 0 && ParseStagedSuffix(aNames[i].substr(aPrefix.size()), aFile)) {
+					aFile._path = aDirectory + aNames[i];
+					aFiles.push_back(aFile);
+				}
+			}
+			std::sort(aFiles.begin(), aFiles.end());
+
+			std::vector<std::string> aPaths;
+			for (std::size_t i = 0; i < aFiles.size(); ++i) {
+				aPaths.push_back(aFiles[i]._path);
+			}
+			return aPaths;
+		}
+
+		LogFileCompressor::~LogFileCompressor() {
+		}
+
+		CommandLogFileCompressor::CommandLogFileCompressor(const char* iCommand, const char* iExtension)
+			:_arguments(), _extension(iExtension) {
+			std::istringstream aSs(iCommand);
+			std::string aArgument;
+			while (aSs >> aArgument) {
+				_arguments.push_back(aArgument);
+			}
+		}
+
+		bool CommandLogFileCompressor::compress(const std::string& iPath) {
+			if (_arguments.empty()) {
+				return false;
+			}
+#ifdef WIN32
+			//no shell either, the program parses its own command line
+			std::string aCommandLine;
+			for (std::size_t i = 0; i < _arguments.size(); ++i) {
+				aCommandLine += _arguments[i] + " ";
+			}
+			aCommandLine += "\"" + iPath + "\"";
+			std::vector<char> aMutableLine(aCommandLine.begin(), aCommandLine.end());
+			aMutableLine.push_back('\0');
+
+			STARTUPINFOA aStartup;
+			PROCESS_INFORMATION aProcess;
+			ZeroMemory(&aStartup, sizeof(aStartup));
+			aStartup.cb = sizeof(aStartup);
+			DWORD aStatus = 1;
+			if (CreateProcessA(NULL, &aMutableLine[0], NULL, NULL, FALSE, CREATE_NO_WINDOW, NULL, NULL, &aStartup, &aProcess)) {
+				WaitForSingleObject(aProcess.hProcess, INFINITE);
+				GetExitCodeProcess(aProcess.hProcess, &aStatus);
+				CloseHandle(aProcess.hThread);
+				CloseHandle(aProcess.hProcess);
+			}
+			const bool aSucceeded = aStatus == 0;
+#else
+			std::vector<char*> aArgv;
+			for (std::size_t i = 0; i < _arguments.size(); ++i) {
+				aArgv.push_back(const_cast<char*>(_arguments[i].c_str()));
+			}
+			aArgv.push_back(const_cast<char*>(iPath.c_str()));
+			aArgv.push_back(NULL);
+
+			pid_t aChild = 0;
+			int aStatus = 0;
+			bool aSucceeded = false;
+			if (posix_spawnp(&aChild, aArgv[0], NULL, NULL, &aArgv[0], environ) == 0) {
+				while (waitpid(aChild, &aStatus, 0) < 0 && errno == EINTR) {
+				}
+				aSucceeded = WIFEXITED(aStatus) && WEXITSTATUS(aStatus) == 0;
+			}
+#endif
+			if (!aSucceeded) {
+				std::cerr << "Can't compress log file " << iPath << " : " << _arguments[0] << " failed" << std::endl;
+			}
+			return aSucceeded;
+		}
+
+		const char* CommandLogFileCompressor::getExtension() const {
+			return _extension.c_str();
+		}
+
+		FileRotationPolicy::FileRotationPolicy(std::size_t iMaxBytes, unsigned int iIntervalSeconds, unsigned int iMaxFiles)
+			:_maxBytes(iMaxBytes), _intervalSeconds(iIntervalSeconds), _maxFiles(iMaxFiles) {
+		}
+
+		RotatingFileLoggerReporter::RotatingFileLoggerReporter(const char* iFile, const FileRotationPolicy& iRotation,
+			LogFileCompressor* iCompressor, const FileFlushPolicy& iPolicy, const char* iPattern)
+			:FileLoggerReporter(iFile, iPolicy, iPattern),
+			 _rotation(iRotation),
+			 _compressor(iCompressor),
+			 _size(FileSize(iFile)),
+			 _nextRotation(0),
+			 _stagedIndex(0),
+			 _stagedFiles(),
+			 _rotationThread(&RotatingFileLoggerReporter::loopRotation, this) {
+			//a previous run which stopped before archiving its staged files: archive them first, they are older
+			const std::vector<std::string> aLeftovers = FindStagedFiles(getFile());
+			for (std::size_t i = 0; i < aLeftovers.size(); ++i) {
+				_stagedFiles.push(aLeftovers[i]);
+			}
+			scheduleRotation();
+		}
+
+		RotatingFileLoggerReporter::~RotatingFileLoggerReporter() {
+			FileLoggerReporter::flush();
+
+			//stop after the rotations already queued
+			_stagedFiles.push(std::string());
+			_rotationThread.join();
+
+			delete _compressor;
+			_compressor = NULL;
+		}
+
+		void RotatingFileLoggerReporter::idle() {
+			FileLoggerReporter::idle();
+			checkRotation();
+		}
+
+		void RotatingFileLoggerReporter::flush() {
+			_size += getPendingSize();
+			FileLoggerReporter::flush();
+			checkRotation();
+		}
+
+		void RotatingFileLoggerReporter::checkRotation() {
+			const bool aFull = _rotation._maxBytes != 0 && _size >= _rotation._maxBytes;
+			const bool aDue = _nextRotation != 0 && evolve::utils::Clock::Now(true) >= _nextRotation;
+			if (aDue) {
+				scheduleRotation();
+			}
+			if (aFull || (aDue && _size + getPendingSize() != 0)) {
+				rotate();
+			}
+		}
+
+		void RotatingFileLoggerReporter::rotate() {
+			_size += getPendingSize();
+			FileLoggerReporter::flush();
+
+			//only a rename here, everything else is done by the rotation thread
+			std::stringstream aSs;
+			aSs << getFile() << ".rotating." << evolve::utils::Clock::Now() << "." << _stagedIndex++;
+			const std::string aStagedPath = aSs.str();
+
+			closeFile();
+			if (std::rename(getFile().c_str(), aStagedPath.c_str()) != 0) {
+				std::cerr << "Can't rotate log file " << getFile() << std::endl;
+			}
+			else {
+				//the index follows its file, if there is one
+				std::rename((getFile() + EVOLVE_LOG_INDEX_EXTENSION).c_str(), (aStagedPath + EVOLVE_LOG_INDEX_EXTENSION).c_str());
+				_size = 0;
+				_stagedFiles.push(aStagedPath);
+			}
+			openFile();
+		}
+
+		void RotatingFileLoggerReporter::scheduleRotation() {
+			if (_rotation._intervalSeconds == 0) {
+				_nextRotation = 0;
+				return;
+			}
+			const unsigned long long aInterval = static_cast<unsigned long long>(_rotation._intervalSeconds) * 1000000000ULL;
+			_nextRotation = (evolve::utils::Clock::Now(true) / aInterval + 1) * aInterval;
+		}
+
+		void RotatingFileLoggerReporter::loopRotation() {
+			evolve::utils::SetCurrentThreadName("evolve.rotation");
+
+#ifdef WIN32
+			SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#elif defined(__linux__)
+			//nice values are per thread on linux, the compressor command inherits it
+			setpriority(PRIO_PROCESS, 0, 19);
+#endif
+			std::string aStagedPath;
+			while (true) {
+				_stagedFiles.pop(aStagedPath);
+				if (aStagedPath.empty()) {
+					return;
+				}
+				archive(aStagedPath);
+			}
+		}
+
+		void RotatingFileLoggerReporter::archive(const std::string& iStagedPath) {
+			const std::string aStagedIndex = iStagedPath + EVOLVE_LOG_INDEX_EXTENSION;
+			if (_rotation._maxFiles == 0) {
+				std::remove(iStagedPath.c_str());
+				std::remove(aStagedIndex.c_str());
+				return;
+			}
+
+			//shift <file>.k to <file>.k+1, dropping the oldest, compressed or not
+			const unsigned int aVariants = _compressor != NULL ? 2 : 1;
+			for (unsigned int aCompressed = 0; aCompressed < aVariants; ++aCompressed) {
+				const std::string aOldest = getArchivePath(_rotation._maxFiles, aCompressed != 0);
+				if (FileExists(aOldest)) {
+					std::remove(aOldest.c_str());
+				}
+				for (unsigned int k = _rotation._maxFiles - 1; k >= 1; --k) {
+					const std::string aFrom = getArchivePath(k, aCompressed != 0);
+					if (FileExists(aFrom)) {
+						std::rename(aFrom.c_str(), getArchivePath(k + 1, aCompressed != 0).c_str());
+					}
+				}
+			}
+			//only uncompressed archives keep their index, offsets don't apply to compressed ones
+			std::remove((getArchivePath(_rotation._maxFiles, false) + EVOLVE_LOG_INDEX_EXTENSION).c_str());
+			for (unsigned int k = _rotation._maxFiles - 1; k >= 1; --k) {
+				const std::string aFrom = getArchivePath(k, false) + EVOLVE_LOG_INDEX_EXTENSION;
+				if (FileExists(aFrom)) {
+					std::rename(aFrom.c_str(), (getArchivePath(k + 1, false) + EVOLVE_LOG_INDEX_EXTENSION).c_str());
+				}
+			}
+
+			const std::string aNewest = getArchivePath(1, false);
+			if (std::rename(iStagedPath.c_str(), aNewest.c_str()) != 0) {
+				std::cerr << "Can't rotate log file " << iStagedPath << std::endl;
+				return;
+			}
+			if (FileExists(aStagedIndex)) {
+				if (_compressor != NULL) {
+					std::remove(aStagedIndex.c_str());
+				}
+				else {
+					std::rename(aStagedIndex.c_str(), (aNewest + EVOLVE_LOG_INDEX_EXTENSION).c_str());
+				}
+			}
+			if (_compressor != NULL) {
+				_compressor->compress(aNewest);
+			}
+		}
+
+		std::string RotatingFileLoggerReporter::getArchivePath(unsigned int iIndex, bool iCompressed) const {
+			std::stringstream aSs;
+			aSs << getFile() << "." << iIndex;
+			if (iCompressed && _compressor != NULL) {
+				aSs << _compressor->getExtension();
+			}
+			return aSs.str();
+		}
+    }
+}
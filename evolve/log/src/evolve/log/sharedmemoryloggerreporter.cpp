@@ -0,0 +1,434 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file evolve/log/sharedmemoryloggerreporter.cpp
+ * \brief evolve/log shared memory ring reporter source file
+ * \author
+ *
+ */
+
+#include <evolve/log/sharedmemoryloggerreporter.h>
+#include <evolve/utils/clock.h>
+#include <cstring>
+#include <functional>
+#include <iostream>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Namespace for all evolve classes
+ */
+namespace evolve {
+    /**
+     * Namespace for all utility classes
+     */
+    namespace log {
+
+		static const char SharedLogMagic[8] = { 'E', 'V', 'O', 'L', 'V', 'E', 'S', 'H' };
+		static const unsigned int SharedLogVersion = 1;
+
+		/**
+		 * \brief Ring offset in the shared memory object, the ring starts on its own cache line
+		 */
+		static std::size_t SharedLogHeaderSize() {
+			return (sizeof(SharedLogHeader) + EVOLVE_CACHE_LINE_SIZE - 1) & ~static_cast<std::size_t>(EVOLVE_CACHE_LINE_SIZE - 1);
+		}
+
+		static std::size_t RoundUpPowerOfTwo(std::size_t iValue) {
+			std::size_t aPower = 4096;
+			while (aPower < iValue) {
+				aPower <<= 1;
+			}
+			return aPower;
+		}
+
+		/**
+		 * \brief Shared memory object name in the platform convention
+		 */
+		static std::string SharedObjectName(const std::string& iName) {
+#ifdef WIN32
+			return iName.empty() || iName[0] != '/' ? iName : iName.substr(1);
+#else
+			return iName.empty() || iName[0] != '/' ? "/" + iName : iName;
+#endif
+		}
+
+		/**
+		 * \brief Create or open then map a shared memory object
+		 *
+		 * \param[in] iName object name
+		 * \param[in] iCreate create the object, open an existing one otherwise
+		 * \param[in,out] ioSize size to create, or to map from an existing object (0 for all of it); mapped size on return
+		 * \param[out] oHandle mapping handle to close with UnmapShared (Windows only)
+		 * \return mapped address, NULL on error
+		 */
+		static void* MapShared(const std::string& iName, bool iCreate, std::size_t& ioSize, void*& oHandle) {
+			const std::string aName = SharedObjectName(iName);
+			oHandle = NULL;
+#ifdef WIN32
+			if (iCreate) {
+				const unsigned long long aSize = ioSize;
+				oHandle = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+					static_cast<DWORD>(aSize >> 32), static_cast<DWORD>(aSize & 0xFFFFFFFF), aName.c_str());
+			}
+			else {
+				oHandle = OpenFileMappingA(FILE_MAP_READ, FALSE, aName.c_str());
+			}
+			if (oHandle == NULL) {
+				return NULL;
+			}
+			void* aMapping = MapViewOfFile(oHandle, iCreate ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, ioSize);
+			if (aMapping == NULL) {
+				CloseHandle(oHandle);
+				oHandle = NULL;
+				return NULL;
+			}
+			if (!iCreate) {
+				MEMORY_BASIC_INFORMATION aInformation;
+				VirtualQuery(aMapping, &aInformation, sizeof(aInformation));
+				ioSize = aInformation.RegionSize;
+			}
+			return aMapping;
+#else
+			int aDescriptor = -1;
+			if (iCreate) {
+				//readers of a previous run keep their mapping, they notice the new generation
+				::shm_unlink(aName.c_str());
+				aDescriptor = ::shm_open(aName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+				if (aDescriptor >= 0 && ::ftruncate(aDescriptor, static_cast<off_t>(ioSize)) != 0) {
+					::close(aDescriptor);
+					aDescriptor = -1;
+				}
+			}
+			else {
+				aDescriptor = ::shm_open(aName.c_str(), O_RDONLY, 0);
+				struct stat aStat;
+				if (aDescriptor >= 0 && ::fstat(aDescriptor, &aStat) == 0) {
+					const std::size_t aObjectSize = static_cast<std::size_t>(aStat.st_size);
+					ioSize = ioSize == 0 || ioSize > aObjectSize ? aObjectSize : ioSize;
+				}
+			}
+			if (aDescriptor < 0 || ioSize < SharedLogHeaderSize()) {
+				if (aDescriptor >= 0) {
+					::close(aDescriptor);
+				}
+				return NULL;
+			}
+			void* aMapping = ::mmap(NULL, ioSize, iCreate ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, aDescriptor, 0);
+			//the mapping keeps the object alive
+			::close(aDescriptor);
+			return aMapping != MAP_FAILED ? aMapping : NULL;
+#endif
+		}
+
+		static void UnmapShared(const void* iMapping, std::size_t iSize, void* iHandle) {
+#ifdef WIN32
+			(void)iSize;
+			if (iMapping != NULL) {
+				UnmapViewOfFile(iMapping);
+			}
+			if (iHandle != NULL) {
+				CloseHandle(iHandle);
+			}
+#else
+			(void)iHandle;
+			if (iMapping != NULL) {
+				::munmap(const_cast<void*>(iMapping), iSize);
+			}
+#endif
+		}
+
+		static void CopyToRing(char* ioRing, unsigned long long iMask, unsigned long long& ioPosition, const void* iData, std::size_t iSize) {
+			const std::size_t aOffset = static_cast<std::size_t>(ioPosition & iMask);
+			const std::size_t aFirst = iSize < iMask + 1 - aOffset ? iSize : static_cast<std::size_t>(iMask + 1 - aOffset);
+			std::memcpy(ioRing + aOffset, iData, aFirst);
+			std::memcpy(ioRing, static_cast<const char*>(iData) + aFirst, iSize - aFirst);
+			ioPosition += iSize;
+		}
+
+		static void CopyFromRing(const char* iRing, unsigned long long iMask, unsigned long long iPosition, void* oData, std::size_t iSize) {
+			const std::size_t aOffset = static_cast<std::size_t>(iPosition & iMask);
+			const std::size_t aFirst = iSize < iMask + 1 - aOffset ? iSize : static_cast<std::size_t>(iMask + 1 - aOffset);
+			std::memcpy(oData, iRing + aOffset, aFirst);
+			std::memcpy(static_cast<char*>(oData) + aFirst, iRing, iSize - aFirst);
+		}
+
+        SharedMemoryLoggerReporter::SharedMemoryLoggerReporter(const char* iName, std::size_t iSize)
+                :LoggerReporter(),
+				 _name(iName),
+				 _header(NULL),
+				 _ring(NULL),
+				 _mappingSize(SharedLogHeaderSize() + RoundUpPowerOfTwo(iSize)),
+				 _sequence(0),
+				 _message(),
+				 _fieldsLayout("%k")
+#ifdef WIN32
+				 , _mappingHandle(NULL)
+#endif
+		{
+			void* aHandle = NULL;
+			void* aMapping = MapShared(_name, true, _mappingSize, aHandle);
+#ifdef WIN32
+			_mappingHandle = aHandle;
+#endif
+			if (aMapping == NULL) {
+				std::cerr << "Can't create shared log ring : " << _name << std::endl;
+				return;
+			}
+
+			//a new object is zero filled
+			_header = static_cast<SharedLogHeader*>(aMapping);
+			_ring = static_cast<char*>(aMapping) + SharedLogHeaderSize();
+			_header->_version = SharedLogVersion;
+			_header->_headerSize = static_cast<unsigned int>(SharedLogHeaderSize());
+			_header->_capacity = _mappingSize - SharedLogHeaderSize();
+			_header->_generation = evolve::utils::Clock::Now();
+			_header->_head.store(0, std::memory_order_relaxed);
+			_header->_tail.store(0, std::memory_order_relaxed);
+			_header->_closed.store(0, std::memory_order_relaxed);
+			//readers check the magic last
+			std::atomic_thread_fence(std::memory_order_release);
+			std::memcpy(_header->_magic, SharedLogMagic, sizeof(SharedLogMagic));
+		}
+
+        SharedMemoryLoggerReporter::~SharedMemoryLoggerReporter() {
+			if (_header != NULL) {
+				_header->_closed.store(1, std::memory_order_release);
+			}
+			void* aHandle = NULL;
+#ifdef WIN32
+			aHandle = _mappingHandle;
+#endif
+			UnmapShared(_header, _mappingSize, aHandle);
+		}
+
+        void SharedMemoryLoggerReporter::log(const LogMessage& iLogMessage) {
+			logBatch(&iLogMessage, 1);
+        }
+
+		void SharedMemoryLoggerReporter::logBatch(const LogMessage* iLogMessages, std::size_t iCount) {
+			if (_header == NULL) {
+				return;
+			}
+			unsigned long long aHead = _header->_head.load(std::memory_order_relaxed);
+			for (std::size_t i = 0; i < iCount; ++i) {
+				append(iLogMessages[i], aHead);
+			}
+			//publish the whole batch at once
+			_header->_head.store(aHead, std::memory_order_release);
+		}
+
+		void SharedMemoryLoggerReporter::append(const LogMessage& iLogMessage, unsigned long long& ioHead) {
+			const unsigned long long aCapacity = _header->_capacity;
+			const unsigned long long aMask = aCapacity - 1;
+
+			const char* aMessage = iLogMessage._message.data();
+			std::size_t aMessageLength = iLogMessage._message.size();
+			if (!iLogMessage._fields.empty()) {
+				_message.assign(iLogMessage._message.data(), iLogMessage._message.size());
+				_fieldsLayout.append(iLogMessage, _message);
+				aMessage = _message.data();
+				aMessageLength = _message.size();
+			}
+
+			SharedLogRecord aRecord;
+			aRecord._level = static_cast<unsigned int>(iLogMessage._level);
+			aRecord._sequence = _sequence++;
+			aRecord._time = iLogMessage._time;
+			aRecord._threadId = std::hash<std::thread::id>()(iLogMessage._threadId);
+			aRecord._line = iLogMessage._line;
+			aRecord._threadIndex = iLogMessage._threadIndex;
+			const std::size_t aFileLength = iLogMessage._file != NULL ? std::strlen(iLogMessage._file) : 0;
+			const std::size_t aFuncLength = iLogMessage._func != NULL ? std::strlen(iLogMessage._func) : 0;
+			aRecord._fileLength = static_cast<unsigned short>(aFileLength < 0xFFFF ? aFileLength : 0xFFFF);
+			aRecord._funcLength = static_cast<unsigned short>(aFuncLength < 0xFFFF ? aFuncLength : 0xFFFF);
+			//a record never takes more than a quarter of the ring
+			const std::size_t aMaxMessage = static_cast<std::size_t>(aCapacity / 4) - sizeof(SharedLogRecord) - aRecord._fileLength - aRecord._funcLength;
+			aRecord._messageLength = static_cast<unsigned int>(aMessageLength < aMaxMessage ? aMessageLength : aMaxMessage);
+			const std::size_t aLength = sizeof(SharedLogRecord) + aRecord._fileLength + aRecord._funcLength + aRecord._messageLength;
+			aRecord._size = static_cast<unsigned int>((aLength + 7) & ~static_cast<std::size_t>(7));
+
+			//move the tail past the records about to be overwritten, before writing over them
+			unsigned long long aTail = _header->_tail.load(std::memory_order_relaxed);
+			if (ioHead + aRecord._size - aTail > aCapacity) {
+				while (ioHead + aRecord._size - aTail > aCapacity) {
+					unsigned int aSize = 0;
+					CopyFromRing(_ring, aMask, aTail, &aSize, sizeof(aSize));
+					aTail += aSize;
+				}
+				_header->_tail.store(aTail, std::memory_order_relaxed);
+				//pairs with the acquire fence of readers validating their copy
+				std::atomic_thread_fence(std::memory_order_release);
+			}
+
+			unsigned long long aPosition = ioHead;
+			CopyToRing(_ring, aMask, aPosition, &aRecord, sizeof(aRecord));
+			CopyToRing(_ring, aMask, aPosition, iLogMessage._file, aRecord._fileLength);
+			CopyToRing(_ring, aMask, aPosition, iLogMessage._func, aRecord._funcLength);
+			CopyToRing(_ring, aMask, aPosition, aMessage, aRecord._messageLength);
+			ioHead += aRecord._size;
+		}
+
+
+		SharedMemoryLogReader::SharedMemoryLogReader(const char* iName, bool iFromStart)
+			:_name(iName),
+			 _header(NULL),
+			 _ring(NULL),
+			 _mappingSize(0),
+			 _position(0),
+			 _sequence(~0ULL),
+			 _lost(0),
+			 _data()
+#ifdef WIN32
+			 , _mappingHandle(NULL)
+#endif
+		{
+			void* aHandle = NULL;
+			const void* aMapping = MapShared(_name, false, _mappingSize, aHandle);
+#ifdef WIN32
+			_mappingHandle = aHandle;
+#endif
+			if (aMapping == NULL) {
+				return;
+			}
+
+			const SharedLogHeader* aHeader = static_cast<const SharedLogHeader*>(aMapping);
+			const bool aValid = std::memcmp(aHeader->_magic, SharedLogMagic, sizeof(SharedLogMagic)) == 0
+				&& aHeader->_version == SharedLogVersion
+				&& aHeader->_headerSize + aHeader->_capacity <= _mappingSize;
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (!aValid) {
+				std::cerr << "Can't read shared log ring : " << _name << " is not a log ring" << std::endl;
+				UnmapShared(aMapping, _mappingSize, aHandle);
+#ifdef WIN32
+				_mappingHandle = NULL;
+#endif
+				return;
+			}
+
+			_header = aHeader;
+			_ring = static_cast<const char*>(aMapping) + aHeader->_headerSize;
+			_position = iFromStart ? _header->_tail.load(std::memory_order_acquire) : _header->_head.load(std::memory_order_acquire);
+		}
+
+		SharedMemoryLogReader::~SharedMemoryLogReader() {
+			void* aHandle = NULL;
+#ifdef WIN32
+			aHandle = _mappingHandle;
+#endif
+			UnmapShared(_header, _mappingSize, aHandle);
+		}
+
+		bool SharedMemoryLogReader::isOpen() const {
+			return _header != NULL;
+		}
+
+		bool SharedMemoryLogReader::next(BinaryLogRecord& oRecord) {
+			if (_header == NULL) {
+				return false;
+			}
+
+			while (true) {
+				const unsigned long long aHead = _header->_head.load(std::memory_order_acquire);
+				const unsigned long long aTail = _header->_tail.load(std::memory_order_acquire);
+				if (_position < aTail) {
+					_position = aTail;
+				}
+				if (_position >= aHead) {
+					return false;
+				}
+
+				SharedLogRecord aRecord;
+				const bool aCopied = copy(_position, sizeof(aRecord), _data);
+				if (aCopied) {
+					std::memcpy(&aRecord, _data.data(), sizeof(aRecord));
+				}
+				const std::size_t aLength = sizeof(aRecord) + aRecord._fileLength + aRecord._funcLength + aRecord._messageLength;
+				if (!aCopied || aRecord._size < aLength || aRecord._size > _header->_capacity
+					|| !copy(_position, aRecord._size, _data)) {
+					//overwritten meanwhile: the tail moved, start again from it
+					continue;
+				}
+
+				const char* aText = _data.data() + sizeof(aRecord);
+				oRecord._time = aRecord._time;
+				oRecord._level = aRecord._level <= LEVEL_OFF ? static_cast<LogLevel>(aRecord._level) : LEVEL_OFF;
+				oRecord._file.assign(aText, aRecord._fileLength);
+				aText += aRecord._fileLength;
+				oRecord._func.assign(aText, aRecord._funcLength);
+				aText += aRecord._funcLength;
+				oRecord._message.assign(aText, aRecord._messageLength);
+				oRecord._line = aRecord._line;
+				oRecord._threadIndex = aRecord._threadIndex;
+				oRecord._threadId = aRecord._threadId;
+
+				if (_sequence != ~0ULL && aRecord._sequence > _sequence) {
+					_lost += aRecord._sequence - _sequence;
+				}
+				_sequence = aRecord._sequence + 1;
+				_position += aRecord._size;
+				return true;
+			}
+		}
+
+		bool SharedMemoryLogReader::copy(unsigned long long iPosition, std::size_t iSize, std::string& oData) const {
+			oData.resize(iSize);
+			CopyFromRing(_ring, _header->_capacity - 1, iPosition, &oData[0], iSize);
+			//the copy is only valid if the writer did not move the tail past it meanwhile
+			std::atomic_thread_fence(std::memory_order_acquire);
+			return _header->_tail.load(std::memory_order_relaxed) <= iPosition;
+		}
+
+		bool SharedMemoryLogReader::isClosed() const {
+			return _header == NULL || _header->_closed.load(std::memory_order_acquire) != 0;
+		}
+
+		bool SharedMemoryLogReader::isReplaced() const {
+			//the header only: cheap enough to be polled while the ring is idle
+			std::size_t aSize = SharedLogHeaderSize();
+			void* aHandle = NULL;
+			const void* aMapping = MapShared(_name, false, aSize, aHandle);
+			if (aMapping == NULL) {
+				return false;
+			}
+			const SharedLogHeader* aHeader = static_cast<const SharedLogHeader*>(aMapping);
+			const bool aReplaced = _header == NULL
+				|| std::memcmp(aHeader->_magic, SharedLogMagic, sizeof(SharedLogMagic)) != 0
+				|| aHeader->_generation != _header->_generation;
+			UnmapShared(aMapping, aSize, aHandle);
+			return aReplaced;
+		}
+
+		unsigned long long SharedMemoryLogReader::getLostCount() const {
+			return _lost;
+		}
+    }
+}
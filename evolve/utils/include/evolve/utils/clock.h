@@ -21,70 +21,270 @@
 * under the License.                                             *
 ******************************************************************/
 
+/**
+ * \file evolve/utils/clock.h
+ * \brief evolve/utils wall clock timestamps and formatting
+ * \author
+ *
+ */
+
 #ifndef EVOLVE_CLOCK_H
 #define EVOLVE_CLOCK_H
 
 #ifdef WIN32
 #include <windows.h>
 #else
-#include <ctime>
+#include <time.h>
 #endif
 
-#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <string>
 
 namespace evolve {
     namespace utils {
+        /**
+         * \brief Wall clock timestamps and their text formatting
+         *
+         * Timestamps are nanoseconds since 1970-01-01 00:00:00 UTC, cheap enough to
+         * be taken on the producer thread for every log message. Formatting caches the
+         * "YYYY-MM-DD HH:MM:SS" prefix of the last formatted second, so only the
+         * fractional suffix is rewritten for messages within the same second.
+         */
         class Clock {
         public:
-            inline explicit Clock() {
-
+            /**
+             * \brief Constructor
+             *
+             * \param[in] iFractionDigits digits after the seconds: 3 (milliseconds), 6 (microseconds) or 9
+             */
+            inline explicit Clock(unsigned int iFractionDigits = 3)
+				:_fractionDigits(iFractionDigits > 9 ? 9 : iFractionDigits), _cachedSecond(-1) {
+				_cachedPrefix[0] = '\0';
             }
             inline ~Clock() {}
-            inline std::string getFormattedDateAndTime() {
+
+            /**
+             * \brief Current time
+             *
+             * \param[in] iCoarse use the cheapest, tick-resolution clock
+             *            (CLOCK_REALTIME_COARSE on Linux, GetSystemTimeAsFileTime on Windows)
+             * \return nanoseconds since epoch (UTC)
+             */
+			static inline unsigned long long Now(bool iCoarse = false) {
 #ifdef WIN32
-				SYSTEMTIME time;
-				GetSystemTime(&time);
-				std::stringstream aSs;
+				FILETIME aTime;
+				if (iCoarse) {
+					GetSystemTimeAsFileTime(&aTime);
+				}
+				else {
+					GetSystemTimePreciseAsFileTime(&aTime);
+				}
+				const unsigned long long aTicks = (static_cast<unsigned long long>(aTime.dwHighDateTime) << 32) | aTime.dwLowDateTime;
+				//FILETIME counts 100ns since 1601-01-01
+				return (aTicks - 116444736000000000ULL) * 100ULL;
+#else
+				struct timespec aTime;
+#ifdef CLOCK_REALTIME_COARSE
+				clock_gettime(iCoarse ? CLOCK_REALTIME_COARSE : CLOCK_REALTIME, &aTime);
+#else
+				clock_gettime(CLOCK_REALTIME, &aTime);
+#endif
+				return static_cast<unsigned long long>(aTime.tv_sec) * 1000000000ULL + static_cast<unsigned long long>(aTime.tv_nsec);
+#endif
+			}
 
-				aSs.width(4);
-				aSs.fill('0');
-				aSs << time.wYear << "-";
+            /**
+             * \brief Format the current time
+             *
+             * \return "YYYY-MM-DD HH:MM:SS.mmm"
+             */
+            inline std::string getFormattedDateAndTime() {
+				char aText[32];
+				return std::string(aText, formatDateAndTime(Now(), aText));
+            }
 
-				aSs.width(2);
-				aSs.fill('0');
-				aSs << time.wMonth << "-";
+            /**
+             * \brief Format a timestamp, reusing the cached prefix when in the same second
+             *
+             * \param[in] iTime nanoseconds since epoch (UTC)
+             * \param[out] oText buffer of at least 30 characters, null terminated
+             * \return number of characters written
+             */
+			inline std::size_t formatDateAndTime(unsigned long long iTime, char* oText) {
+				const long long aSecond = static_cast<long long>(iTime / 1000000000ULL);
+				if (aSecond != _cachedSecond) {
+					_cachedSecond = aSecond;
+					FormatSecond(aSecond, _cachedPrefix);
+				}
+				std::memcpy(oText, _cachedPrefix, 19);
+				if (_fractionDigits == 0) {
+					oText[19] = '\0';
+					return 19;
+				}
 
-				aSs.width(2);
-				aSs.fill('0');
-				aSs << time.wDay << " ";
+				unsigned long long aFraction = iTime % 1000000000ULL;
+				for (unsigned int i = _fractionDigits; i < 9; ++i) {
+					aFraction /= 10;
+				}
+				oText[19] = '.';
+				for (unsigned int i = _fractionDigits; i > 0; --i) {
+					oText[19 + i] = static_cast<char>('0' + aFraction % 10);
+					aFraction /= 10;
+				}
+				oText[20 + _fractionDigits] = '\0';
+				return 20 + _fractionDigits;
+			}
 
-				aSs.width(2);
-				aSs.fill('0');
-				aSs << time.wHour << ":";
+            /**
+             * \brief Timestamp of a UTC date and time
+             *
+             * \return nanoseconds since epoch
+             */
+			static inline unsigned long long FromDateAndTime(int iYear, unsigned int iMonth, unsigned int iDay,
+				unsigned int iHour, unsigned int iMinute, unsigned int iSecond) {
+				const long long aSeconds = DaysFromCivil(iYear, iMonth, iDay) * 86400LL + iHour * 3600LL + iMinute * 60LL + iSecond;
+				return static_cast<unsigned long long>(aSeconds) * 1000000000ULL;
+			}
 
-				aSs.width(2);
-				aSs.fill('0');
-				aSs << time.wMinute << ":";
+            /**
+             * \brief Parse a UTC date and time as formatted by formatDateAndTime
+             *
+             * Accepts "YYYY-MM-DD HH:MM:SS", with 'T' instead of the space and an
+             * optional fraction of second of any number of digits.
+             *
+             * \param[in] iText the text
+             * \param[in] iLength length of the text, every character must be used
+             * \param[out] oTime nanoseconds since epoch
+             * \return false if the text is not a date and time
+             */
+			static inline bool ParseDateAndTime(const char* iText, std::size_t iLength, unsigned long long& oTime) {
+				const char* aCursor = iText;
+				const char* aEnd = iText + iLength;
+				unsigned int aYear, aMonth, aDay, aHour, aMinute, aSecond;
+				if (!ReadNumber(aCursor, aEnd, 4, aYear) || !Expect(aCursor, aEnd, '-', '-')
+					|| !ReadNumber(aCursor, aEnd, 2, aMonth) || !Expect(aCursor, aEnd, '-', '-')
+					|| !ReadNumber(aCursor, aEnd, 2, aDay) || !Expect(aCursor, aEnd, ' ', 'T')
+					|| !ReadNumber(aCursor, aEnd, 2, aHour) || !Expect(aCursor, aEnd, ':', ':')
+					|| !ReadNumber(aCursor, aEnd, 2, aMinute) || !Expect(aCursor, aEnd, ':', ':')
+					|| !ReadNumber(aCursor, aEnd, 2, aSecond)
+					|| aMonth < 1 || aMonth > 12 || aDay < 1 || aDay > 31 || aHour > 23 || aMinute > 59 || aSecond > 60) {
+					return false;
+				}
 
-				aSs.width(2);
-				aSs.fill('0');
-				aSs << time.wSecond << ".";
+				unsigned long long aFraction = 0;
+				if (aCursor != aEnd) {
+					if (*aCursor != '.' || ++aCursor == aEnd) {
+						return false;
+					}
+					unsigned long long aScale = 100000000ULL;
+					for (; aCursor != aEnd; ++aCursor) {
+						if (*aCursor < '0' || *aCursor > '9') {
+							return false;
+						}
+						aFraction += static_cast<unsigned long long>(*aCursor - '0') * aScale;
+						aScale /= 10;
+					}
+				}
+				oTime = FromDateAndTime(static_cast<int>(aYear), aMonth, aDay, aHour, aMinute, aSecond) + aFraction;
+				return true;
+			}
 
-				aSs.width(3);
-				aSs.fill('0');
-				aSs << time.wMilliseconds;
+            /**
+             * \brief Parse a time given on a command line
+             *
+             * \param[in] iText UTC date and time (see ParseDateAndTime) or seconds since epoch
+             * \param[out] oTime nanoseconds since epoch
+             * \return false if the text is neither
+             */
+			static inline bool Parse(const char* iText, unsigned long long& oTime) {
+				if (ParseDateAndTime(iText, std::strlen(iText), oTime)) {
+					return true;
+				}
+				char* aEnd = NULL;
+				const double aSeconds = std::strtod(iText, &aEnd);
+				if (aEnd == iText || *aEnd != '\0' || aSeconds < 0.0) {
+					return false;
+				}
+				oTime = static_cast<unsigned long long>(aSeconds * 1e9);
+				return true;
+			}
 
-				return aSs.str();
-#else
-                start = std::clock();
-#endif
-            }
         private:
-#ifdef WIN32
-			SYSTEMTIME time;
-#else
-            unsigned long start;
-#endif
+			//days since 1970-01-01 of a proleptic Gregorian date
+			static inline long long DaysFromCivil(long long iYear, unsigned int iMonth, unsigned int iDay) {
+				iYear -= iMonth <= 2;
+				const long long aEra = (iYear >= 0 ? iYear : iYear - 399) / 400;
+				const unsigned int aYearOfEra = static_cast<unsigned int>(iYear - aEra * 400);
+				const unsigned int aDayOfYear = (153 * (iMonth > 2 ? iMonth - 3 : iMonth + 9) + 2) / 5 + iDay - 1;
+				const unsigned int aDayOfEra = aYearOfEra * 365 + aYearOfEra / 4 - aYearOfEra / 100 + aDayOfYear;
+				return aEra * 146097 + static_cast<long long>(aDayOfEra) - 719468;
+			}
+
+			//"YYYY-MM-DD HH:MM:SS" of a second since epoch, without the C library (no locale, no lock)
+			static inline void FormatSecond(long long iSecond, char* oText) {
+				long long aDays = iSecond / 86400;
+				long long aSecondOfDay = iSecond % 86400;
+				if (aSecondOfDay < 0) {
+					aSecondOfDay += 86400;
+					--aDays;
+				}
+
+				aDays += 719468;
+				const long long aEra = (aDays >= 0 ? aDays : aDays - 146096) / 146097;
+				const unsigned int aDayOfEra = static_cast<unsigned int>(aDays - aEra * 146097);
+				const unsigned int aYearOfEra = (aDayOfEra - aDayOfEra / 1460 + aDayOfEra / 36524 - aDayOfEra / 146096) / 365;
+				const unsigned int aDayOfYear = aDayOfEra - (365 * aYearOfEra + aYearOfEra / 4 - aYearOfEra / 100);
+				const unsigned int aMonthIndex = (5 * aDayOfYear + 2) / 153;
+				const unsigned int aDay = aDayOfYear - (153 * aMonthIndex + 2) / 5 + 1;
+				const unsigned int aMonth = aMonthIndex < 10 ? aMonthIndex + 3 : aMonthIndex - 9;
+				const long long aYear = static_cast<long long>(aYearOfEra) + aEra * 400 + (aMonth <= 2);
+
+				const unsigned int aYearDigits = static_cast<unsigned int>(aYear < 0 ? 0 : aYear % 10000);
+				WriteDigits(oText, aYearDigits / 100);
+				WriteDigits(oText + 2, aYearDigits % 100);
+				oText[4] = '-';
+				WriteDigits(oText + 5, aMonth);
+				oText[7] = '-';
+				WriteDigits(oText + 8, aDay);
+				oText[10] = ' ';
+				WriteDigits(oText + 11, static_cast<unsigned int>(aSecondOfDay / 3600));
+				oText[13] = ':';
+				WriteDigits(oText + 14, static_cast<unsigned int>((aSecondOfDay / 60) % 60));
+				oText[16] = ':';
+				WriteDigits(oText + 17, static_cast<unsigned int>(aSecondOfDay % 60));
+				oText[19] = '\0';
+			}
+
+			//unsigned decimal number of 1 to iMaxDigits digits
+			static inline bool ReadNumber(const char*& ioCursor, const char* iEnd, unsigned int iMaxDigits, unsigned int& oValue) {
+				oValue = 0;
+				unsigned int aDigits = 0;
+				while (ioCursor != iEnd && *ioCursor >= '0' && *ioCursor <= '9' && aDigits < iMaxDigits) {
+					oValue = oValue * 10 + static_cast<unsigned int>(*ioCursor++ - '0');
+					++aDigits;
+				}
+				return aDigits != 0;
+			}
+
+			//one of two separators
+			static inline bool Expect(const char*& ioCursor, const char* iEnd, char iSeparator, char iOther) {
+				if (ioCursor == iEnd || (*ioCursor != iSeparator && *ioCursor != iOther)) {
+					return false;
+				}
+				++ioCursor;
+				return true;
+			}
+
+			//two decimal digits of a value below 100
+			static inline void WriteDigits(char* oText, unsigned int iValue) {
+				oText[0] = static_cast<char>('0' + iValue / 10);
+				oText[1] = static_cast<char>('0' + iValue % 10);
+			}
+
+			unsigned int _fractionDigits; ///< digits after the seconds
+			long long _cachedSecond; ///< second of _cachedPrefix
+			char _cachedPrefix[20]; ///< "YYYY-MM-DD HH:MM:SS" of _cachedSecond
         };
     }
 }
@@ -32,7 +32,7 @@
 #define EVOLVE_POLICIES_H
 
 #include <evolve/utils/export.h>
-#include <evolve/utils/singletonLazyInstance.h>
+#include <evolve/utils/singletonlazyinstance.h>
 #include <exception>
 #include <cstring>
 
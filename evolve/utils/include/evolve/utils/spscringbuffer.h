@@ -0,0 +1,280 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+
+/**
+* \file evolve/utils/spscringbuffer.h
+* \brief evolve/utils bounded single-producer/single-consumer ring buffer
+* \author
+*
+*/
+
+#ifndef EVOLVE_SPSC_RING_BUFFER_H
+#define EVOLVE_SPSC_RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+
+/**
+* Cache line size used to pad the producer and consumer indexes
+*/
+#ifndef EVOLVE_CACHE_LINE_SIZE
+#define EVOLVE_CACHE_LINE_SIZE 64
+#endif
+
+/**
+* Namespace for all evolve classes
+*/
+namespace evolve {
+	/**
+	* Namespace for all utility classes
+	*/
+	namespace utils {
+
+		/**
+		* \brief Bounded lock-free ring buffer for one producer and one consumer
+		*
+		* Each slot carries a sequence number telling whether it is free for the
+		* producer or ready for the consumer, so both sides only share the slots
+		* they hand over. The consumer claims ready slots with a single
+		* compare-and-swap on the head index per bulk pop; this lets the producer
+		* of a full ring claim the oldest slot the same way and overwrite it
+		* (pushOverwrite). The ring never blocks: waiting policy is left to the caller.
+		*
+		* \tparam T Item type, must be default constructible and movable
+		*/
+		template <class T>
+		class SpscRingBuffer {
+		public:
+			/**
+			* \brief Constructor
+			*
+			* \param[in] iCapacity number of slots, rounded up to a power of two
+			*/
+			explicit SpscRingBuffer(std::size_t iCapacity)
+				:_capacity(RoundUpPowerOfTwo(iCapacity)),
+				 _mask(_capacity - 1),
+				 _slots(new Slot[_capacity]),
+				 _tail(0),
+				 _head(0) {
+				for (std::size_t i = 0; i < _capacity; ++i) {
+					_slots[i]._sequence.store(i, std::memory_order_relaxed);
+				}
+			}
+
+			/**
+			* \brief Destructor
+			*/
+			~SpscRingBuffer() {
+				delete[] _slots;
+			}
+
+			/**
+			* \brief Push an item if the ring is not full
+			*
+			* Must only be called from the producer thread.
+			*
+			* \param[in] iItem The item to push
+			* \return false if the ring is full
+			*/
+			bool tryPush(const T& iItem) {
+				Slot& aSlot = _slots[_tail & _mask];
+				if (aSlot._sequence.load(std::memory_order_acquire) != _tail) {
+					return false;
+				}
+				aSlot._item = iItem;
+				publish(aSlot);
+				return true;
+			}
+
+			/**
+			* \brief Push an item by moving it if the ring is not full
+			*
+			* Must only be called from the producer thread.
+			*
+			* \param[in] iItem The item to push
+			* \return false if the ring is full, iItem is left untouched
+			*/
+			bool tryPush(T&& iItem) {
+				Slot& aSlot = _slots[_tail & _mask];
+				if (aSlot._sequence.load(std::memory_order_acquire) != _tail) {
+					return false;
+				}
+				aSlot._item = std::move(iItem);
+				publish(aSlot);
+				return true;
+			}
+
+			/**
+			* \brief Push an item, overwriting the oldest one if the ring is full
+			*
+			* Must only be called from the producer thread. Waits only while the
+			* consumer is moving the oldest item out.
+			*
+			* \param[in] iItem The item to push
+			* \return true if the oldest item has been dropped
+			*/
+			bool pushOverwrite(const T& iItem) {
+				return overwrite(iItem);
+			}
+
+			/**
+			* \brief Push an item by moving it, overwriting the oldest one if the ring is full
+			*
+			* Must only be called from the producer thread.
+			*
+			* \param[in] iItem The item to push
+			* \return true if the oldest item has been dropped
+			*/
+			bool pushOverwrite(T&& iItem) {
+				return overwrite(std::move(iItem));
+			}
+
+			/**
+			* \brief Pop all available items, up to iMax, in one pass
+			*
+			* Items are move-assigned into oItems so their storage can be reused
+			* from one call to the next. Must only be called from the consumer thread.
+			*
+			* \param[out] oItems destination array
+			* \param[in] iMax destination array size
+			* \return number of popped items
+			*/
+			std::size_t popBulk(T* oItems, std::size_t iMax) {
+				std::size_t aHead = _head.load(std::memory_order_relaxed);
+				std::size_t aCount = 0;
+				while (true) {
+					aCount = 0;
+					while (aCount < iMax
+						&& _slots[(aHead + aCount) & _mask]._sequence.load(std::memory_order_acquire) == aHead + aCount + 1) {
+						++aCount;
+					}
+					if (aCount == 0) {
+						return 0;
+					}
+					//fails only if the producer overwrote the oldest item meanwhile
+					if (_head.compare_exchange_weak(aHead, aHead + aCount, std::memory_order_acq_rel)) {
+						break;
+					}
+				}
+				for (std::size_t i = 0; i < aCount; ++i) {
+					Slot& aSlot = _slots[(aHead + i) & _mask];
+					oItems[i] = std::move(aSlot._item);
+					aSlot._sequence.store(aHead + i + _capacity, std::memory_order_release);
+				}
+				return aCount;
+			}
+
+			/**
+			* \brief Check if the consumer has nothing to pop
+			*
+			* \return true if the next slot is not ready
+			*/
+			bool empty() const {
+				const std::size_t aHead = _head.load(std::memory_order_acquire);
+				return _slots[aHead & _mask]._sequence.load(std::memory_order_acquire) != aHead + 1;
+			}
+
+			/**
+			* \brief Approximate number of items waiting, seen from the producer
+			*
+			* Must only be called from the producer thread.
+			*
+			* \return pushed items not yet claimed by the consumer
+			*/
+			std::size_t size() const {
+				return _tail - _head.load(std::memory_order_relaxed);
+			}
+
+			/**
+			* \brief Ring capacity
+			*
+			* \return number of slots
+			*/
+			std::size_t capacity() const {
+				return _capacity;
+			}
+
+		private:
+			struct Slot {
+				std::atomic<std::size_t> _sequence;
+				T _item;
+			};
+
+			static std::size_t RoundUpPowerOfTwo(std::size_t iValue) {
+				std::size_t aPower = 2;
+				while (aPower < iValue) {
+					aPower <<= 1;
+				}
+				return aPower;
+			}
+
+			void publish(Slot& ioSlot) {
+				ioSlot._sequence.store(_tail + 1, std::memory_order_release);
+				++_tail;
+			}
+
+			template <class U>
+			bool overwrite(U&& iItem) {
+				Slot& aSlot = _slots[_tail & _mask];
+				unsigned int aSpin = 0;
+				while (true) {
+					const std::size_t aSequence = aSlot._sequence.load(std::memory_order_acquire);
+					if (aSequence == _tail) {
+						aSlot._item = std::forward<U>(iItem);
+						publish(aSlot);
+						return false;
+					}
+					//ready but not consumed: the slot holds the oldest item, claim it before the consumer does
+					std::size_t aOldest = _tail - _capacity;
+					if (aSequence == aOldest + 1
+						&& _head.compare_exchange_strong(aOldest, aOldest + 1, std::memory_order_acq_rel)) {
+						aSlot._item = std::forward<U>(iItem);
+						publish(aSlot);
+						return true;
+					}
+					if (++aSpin > 64) {
+						std::this_thread::yield();
+					}
+				}
+			}
+
+			const std::size_t _capacity; ///< number of slots (power of two)
+			const std::size_t _mask; ///< index mask
+			Slot* _slots; ///< slot storage
+
+			char _padding0[EVOLVE_CACHE_LINE_SIZE];
+			std::size_t _tail; ///< next position written by the producer
+			char _padding1[EVOLVE_CACHE_LINE_SIZE - sizeof(std::size_t)];
+			std::atomic<std::size_t> _head; ///< next position read by the consumer, claimed by the producer on overwrite
+			char _padding2[EVOLVE_CACHE_LINE_SIZE - sizeof(std::atomic<std::size_t>)];
+
+			SpscRingBuffer(const SpscRingBuffer&);
+			SpscRingBuffer& operator=(const SpscRingBuffer&);
+		};
+	}
+}
+
+#endif
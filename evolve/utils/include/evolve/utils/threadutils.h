@@ -25,10 +25,71 @@
 #define EVOLVE_THREADUTILS_H
 
 #include <evolve/utils/export.h>
+#include <string>
 #include <thread>
 
+/**
+ * Number of threads whose name and id are kept by the thread registry
+ */
+#ifndef EVOLVE_THREAD_REGISTRY_SIZE
+#define EVOLVE_THREAD_REGISTRY_SIZE 256
+#endif
+
+/**
+ * Maximum length of a registered thread name
+ */
+#ifndef EVOLVE_THREAD_NAME_SIZE
+#define EVOLVE_THREAD_NAME_SIZE 32
+#endif
+
 namespace evolve {
     namespace utils {
+		/**
+		 * \brief Get the dense index of the calling thread
+		 *
+		 * A thread takes the lowest free index on first use and gives it back
+		 * when it exits, so a later thread may get the same index. The index is
+		 * kept in a thread_local: only the first call of a thread touches shared
+		 * state.
+		 *
+		 * \return the calling thread index, EVOLVE_THREAD_REGISTRY_SIZE if the registry
+		 *         is full or the thread is exiting
+		 */
+		unsigned int EVOLVE_UTILS_EXPORT GetCurrentThreadIndex();
+
+		/**
+		 * \brief Get the index of the calling thread without ever registering it
+		 *
+		 * A plain thread_local read, safe in a signal handler.
+		 *
+		 * \return the calling thread index, EVOLVE_THREAD_REGISTRY_SIZE if it has none yet
+		 */
+		unsigned int EVOLVE_UTILS_EXPORT PeekCurrentThreadIndex();
+
+		/**
+		 * \brief Name the calling thread
+		 *
+		 * \param[in] iName thread name, truncated to EVOLVE_THREAD_NAME_SIZE - 1 characters
+		 */
+		void EVOLVE_UTILS_EXPORT SetCurrentThreadName(const char* iName);
+
+		/**
+		 * \brief Get the name of a thread, from any thread
+		 *
+		 * \param[in] iIndex thread index
+		 * \param[out] oName thread name, empty if the thread has not been named
+		 * \return false if the thread has not been named
+		 */
+		bool EVOLVE_UTILS_EXPORT GetThreadName(unsigned int iIndex, std::string& oName);
+
+		/**
+		 * \brief Get the dense index of a thread from its id
+		 *
+		 * Prefer GetCurrentThreadIndex(), this looks the registry up.
+		 *
+		 * \param[in] iId thread id
+		 * \return the thread index, EVOLVE_THREAD_REGISTRY_SIZE if iId has no index
+		 */
 		unsigned int EVOLVE_UTILS_EXPORT GetThreadId(const std::thread::id& iId);
     }
 }
@@ -22,14 +22,14 @@
 ******************************************************************/
 
 /**
- * \file evolve/utils/Policies.cpp
- * \brief evolve/utils policy source file
+ * \file evolve/utils/threadutils.cpp
+ * \brief evolve/utils thread registry source file
  * \author
  *
  */
 
 #include <evolve/utils/threadutils.h>
-#include <map>
+#include <atomic>
 
 /**
  * Namespace for all evolve classes
@@ -40,19 +40,127 @@ namespace evolve {
      */
     namespace utils {
 
-		unsigned int GetThreadId(const std::thread::id& iId) {
-			static std::map<std::thread::id, unsigned int> aThreadIdMap;
-			static unsigned int aThreadIdCount = 0;
+		/**
+		 * \brief Registry slot of one thread
+		 */
+		struct ThreadSlot {
+			std::atomic<bool> _used; ///< claimed by a living thread
+			std::atomic<std::thread::id> _id; ///< id of the owner, default id when free
+			std::atomic<unsigned int> _nameSequence; ///< odd while the name is being written
+			std::atomic<char> _name[EVOLVE_THREAD_NAME_SIZE]; ///< null terminated name
+		};
+
+		static ThreadSlot gThreadSlots[EVOLVE_THREAD_REGISTRY_SIZE];
+		static std::atomic<unsigned int> gThreadCount(0); ///< slots used at least once
+
+		//plain constant-initialised thread_local: the fast path has no initialisation guard
+		static const unsigned int UnregisteredThread = ~0U;
+		static thread_local unsigned int tThreadIndex = UnregisteredThread;
+
+		static void WriteThreadName(ThreadSlot& ioSlot, const char* iName) {
+			//seqlock: readers retry while the sequence is odd or has changed
+			ioSlot._nameSequence.fetch_add(1, std::memory_order_acq_rel);
+			std::size_t i = 0;
+			for (; iName != NULL && iName[i] != '\0' && i + 1 < EVOLVE_THREAD_NAME_SIZE; ++i) {
+				ioSlot._name[i].store(iName[i], std::memory_order_relaxed);
+			}
+			ioSlot._name[i].store('\0', std::memory_order_relaxed);
+			ioSlot._nameSequence.fetch_add(1, std::memory_order_release);
+		}
+
+		static unsigned int RegisterCurrentThread() {
+			for (unsigned int i = 0; i < EVOLVE_THREAD_REGISTRY_SIZE; ++i) {
+				bool aFree = false;
+				if (!gThreadSlots[i]._used.load(std::memory_order_relaxed)
+					&& gThreadSlots[i]._used.compare_exchange_strong(aFree, true, std::memory_order_acquire)) {
+					gThreadSlots[i]._id.store(std::this_thread::get_id(), std::memory_order_release);
+					unsigned int aCount = gThreadCount.load(std::memory_order_relaxed);
+					while (aCount <= i && !gThreadCount.compare_exchange_weak(aCount, i + 1, std::memory_order_release)) {
+					}
+					return i;
+				}
+			}
+			return EVOLVE_THREAD_REGISTRY_SIZE;
+		}
+
+		static void UnregisterThread(unsigned int iIndex) {
+			ThreadSlot& aSlot = gThreadSlots[iIndex];
+			aSlot._id.store(std::thread::id(), std::memory_order_relaxed);
+			WriteThreadName(aSlot, NULL);
+			aSlot._used.store(false, std::memory_order_release);
+		}
+
+		/**
+		 * \brief Gives the slot of a thread back when the thread exits
+		 */
+		struct ThreadRegistration {
+			ThreadRegistration() {
+				tThreadIndex = RegisterCurrentThread();
+			}
+			~ThreadRegistration() {
+				if (tThreadIndex < EVOLVE_THREAD_REGISTRY_SIZE) {
+					UnregisterThread(tThreadIndex);
+				}
+				//late callers, such as other thread_local destructors, get no index
+				tThreadIndex = EVOLVE_THREAD_REGISTRY_SIZE;
+			}
+		};
 
-			std::map<std::thread::id, unsigned int>::const_iterator aIt = aThreadIdMap.find(iId);
-			if (aIt != aThreadIdMap.end()) {
-				return aIt->second;
+		unsigned int GetCurrentThreadIndex() {
+			if (tThreadIndex != UnregisteredThread) {
+				return tThreadIndex;
 			}
-			else {
-				aThreadIdMap[iId] = aThreadIdCount;
-				return aThreadIdCount++;
+			static thread_local ThreadRegistration aRegistration;
+			return tThreadIndex;
+		}
+
+		unsigned int PeekCurrentThreadIndex() {
+			return tThreadIndex != UnregisteredThread ? tThreadIndex : EVOLVE_THREAD_REGISTRY_SIZE;
+		}
+
+		void SetCurrentThreadName(const char* iName) {
+			const unsigned int aIndex = GetCurrentThreadIndex();
+			if (aIndex >= EVOLVE_THREAD_REGISTRY_SIZE) {
+				return;
+			}
+			WriteThreadName(gThreadSlots[aIndex], iName);
+		}
+
+		bool GetThreadName(unsigned int iIndex, std::string& oName) {
+			oName.clear();
+			if (iIndex >= EVOLVE_THREAD_REGISTRY_SIZE) {
+				return false;
 			}
+
+			const ThreadSlot& aSlot = gThreadSlots[iIndex];
+			char aName[EVOLVE_THREAD_NAME_SIZE];
+			unsigned int aSequence = 0;
+			do {
+				aSequence = aSlot._nameSequence.load(std::memory_order_acquire);
+				for (std::size_t i = 0; i < EVOLVE_THREAD_NAME_SIZE; ++i) {
+					aName[i] = aSlot._name[i].load(std::memory_order_relaxed);
+				}
+				std::atomic_thread_fence(std::memory_order_acquire);
+			} while ((aSequence & 1) != 0 || aSlot._nameSequence.load(std::memory_order_relaxed) != aSequence);
+
+			aName[EVOLVE_THREAD_NAME_SIZE - 1] = '\0';
+			oName = aName;
+			return !oName.empty();
 		}
 
+		unsigned int GetThreadId(const std::thread::id& iId) {
+			if (iId == std::this_thread::get_id()) {
+				return GetCurrentThreadIndex();
+			}
+
+			//only the thread itself registers, so another thread's slot is never claimed twice
+			const unsigned int aCount = gThreadCount.load(std::memory_order_acquire);
+			for (unsigned int i = 0; i < aCount && i < EVOLVE_THREAD_REGISTRY_SIZE; ++i) {
+				if (gThreadSlots[i]._id.load(std::memory_order_acquire) == iId) {
+					return i;
+				}
+			}
+			return EVOLVE_THREAD_REGISTRY_SIZE;
+		}
 	}
 }
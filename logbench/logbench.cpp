@@ -0,0 +1,502 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file logbench/logbench.cpp
+ * \brief evolve/log throughput and latency benchmark
+ * \author
+ *
+ * Runs one scenario per combination of producer thread count, message size,
+ * reporter and logging macro. For each scenario it measures:
+ *  - the producer latency of every call (p50, p99, p99.9, max, mean),
+ *  - the end-to-end throughput, from the first call until the reporter has
+ *    written the last message (Logger::sync),
+ *  - the queue depth over time: messages logged but not yet delivered to
+ *    the reporter, sampled by a separate thread.
+ *
+ * Results are printed on the standard output, one line per scenario, as
+ * JSON objects (default) or CSV. Progress goes to the standard error.
+ *
+ * Usage: evolve_logbench [--threads 1,4,16,64] [--sizes 16,128,1024]
+ *                        [--reporters null,file,buffered,binary,json,mapped]
+ *                        [--macros stream,deferred] [--messages N] [--warmup N]
+ *                        [--policy block|drop-newest|drop-oldest|sample]
+ *                        [--sink-capacity N] [--sample-ms N] [--dir PATH]
+ *                        [--format json|csv] [--series] [--budget-ns N]
+ *
+ * With --budget-ns, the exit code is non zero if the p99.9 latency of any
+ * scenario is above the budget.
+ */
+
+#include <evolve/log/log.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief Reporter discarding all messages, so only the logger itself is measured
+ */
+class NullLoggerReporter : public evolve::log::LoggerReporter {
+public:
+	virtual void log(const evolve::log::LogMessage&) {}
+
+	virtual void logBatch(const evolve::log::LogMessage*, std::size_t) {}
+};
+
+/**
+ * \brief Benchmark options
+ */
+struct Options {
+	Options()
+		:_threads(), _sizes(), _reporters(), _macros(), _messages(100000), _warmup(1000),
+		 _policy(evolve::log::OVERFLOW_BLOCK), _policyName("block"), _sinkCapacity(EVOLVE_LOG_SINK_CAPACITY),
+		 _sampleMs(1), _dir("."), _csv(false), _series(false), _budgetNs(0) {}
+
+	std::vector<unsigned int> _threads; ///< producer thread counts
+	std::vector<unsigned int> _sizes; ///< message payload sizes in bytes
+	std::vector<std::string> _reporters; ///< reporter names
+	std::vector<std::string> _macros; ///< "stream" (EVOLVE_LOG) or "deferred" (EVOLVE_LOGF)
+	unsigned int _messages; ///< measured messages per thread
+	unsigned int _warmup; ///< unmeasured messages per thread, logged first
+	evolve::log::LogOverflowPolicy _policy; ///< staging buffer and reporter queue overflow policy
+	std::string _policyName; ///< overflow policy name
+	std::size_t _sinkCapacity; ///< reporter queue capacity
+	unsigned int _sampleMs; ///< queue depth sampling period
+	std::string _dir; ///< directory of the reporter output files
+	bool _csv; ///< CSV output instead of JSON lines
+	bool _series; ///< also print the sampled queue depths (JSON only)
+	unsigned long long _budgetNs; ///< p99.9 latency budget, 0 for none
+};
+
+/**
+ * \brief Results of one scenario
+ */
+struct Result {
+	Result()
+		:_p50(0), _p99(0), _p999(0), _max(0), _mean(0.0), _producerSeconds(0.0), _totalSeconds(0.0),
+		 _delivered(0), _dropped(0), _synced(false), _maxDepth(0), _meanDepth(0.0), _depths() {}
+
+	unsigned long long _p50; ///< median call latency in nanoseconds
+	unsigned long long _p99; ///< 99th percentile call latency
+	unsigned long long _p999; ///< 99.9th percentile call latency
+	unsigned long long _max; ///< worst call latency
+	double _mean; ///< mean call latency
+	double _producerSeconds; ///< time until the last producer returned
+	double _totalSeconds; ///< time until the reporter wrote the last message
+	unsigned long long _delivered; ///< messages handed to the reporter
+	unsigned long long _dropped; ///< messages dropped by the staging buffers or the reporter queue
+	bool _synced; ///< false if the reporter did not catch up within the sync timeout
+	unsigned long long _maxDepth; ///< highest sampled queue depth
+	double _meanDepth; ///< mean sampled queue depth
+	std::vector<unsigned long long> _depths; ///< sampled queue depths
+};
+
+static bool ParseList(const char* iText, std::vector<unsigned int>& oValues) {
+	oValues.clear();
+	std::stringstream aSs(iText);
+	std::string aItem;
+	while (std::getline(aSs, aItem, ',')) {
+		const int aValue = std::atoi(aItem.c_str());
+		if (aValue <= 0) {
+			return false;
+		}
+		oValues.push_back(static_cast<unsigned int>(aValue));
+	}
+	return !oValues.empty();
+}
+
+static void ParseList(const char* iText, std::vector<std::string>& oValues) {
+	oValues.clear();
+	std::stringstream aSs(iText);
+	std::string aItem;
+	while (std::getline(aSs, aItem, ',')) {
+		if (!aItem.empty()) {
+			oValues.push_back(aItem);
+		}
+	}
+}
+
+static std::string OutputPath(const Options& iOptions, const char* iName) {
+	return iOptions._dir + "/evolve_logbench." + iName;
+}
+
+/**
+ * \brief Create a reporter from its name
+ *
+ * \return the reporter, NULL if the name is unknown
+ */
+static evolve::log::LoggerReporter* CreateReporter(const Options& iOptions, const std::string& iName) {
+	if (iName == "null") {
+		return new NullLoggerReporter();
+	}
+	if (iName == "file") {
+		return new evolve::log::FileLoggerReporter(OutputPath(iOptions, "log").c_str());
+	}
+	if (iName == "buffered") {
+		return new evolve::log::FileLoggerReporter(OutputPath(iOptions, "log").c_str(), evolve::log::FileFlushPolicy::Buffered());
+	}
+	if (iName == "binary") {
+		return new evolve::log::BinaryFileLoggerReporter(OutputPath(iOptions, "bin").c_str(), evolve::log::FileFlushPolicy::Buffered());
+	}
+	if (iName == "json") {
+		return new evolve::log::JsonLinesLoggerReporter(OutputPath(iOptions, "jsonl").c_str(), evolve::log::FileFlushPolicy::Buffered());
+	}
+	if (iName == "mapped") {
+		return new evolve::log::MappedFileLoggerReporter(OutputPath(iOptions, "mapped").c_str());
+	}
+	return NULL;
+}
+
+/**
+ * \brief Remove the files written by a scenario
+ */
+static void RemoveOutputs(const Options& iOptions) {
+	std::remove(OutputPath(iOptions, "log").c_str());
+	std::remove(OutputPath(iOptions, "bin").c_str());
+	std::remove(OutputPath(iOptions, "jsonl").c_str());
+	for (unsigned int i = 0; ; ++i) {
+		std::stringstream aSs;
+		aSs << OutputPath(iOptions, "mapped") << "." << i;
+		if (std::remove(aSs.str().c_str()) != 0) {
+			break;
+		}
+	}
+}
+
+/**
+ * \brief Get the value at a given rank of sorted latencies
+ */
+static unsigned long long Percentile(const std::vector<unsigned long long>& iSorted, double iRank) {
+	if (iSorted.empty()) {
+		return 0;
+	}
+	std::size_t aIndex = static_cast<std::size_t>(iRank * static_cast<double>(iSorted.size()));
+	return iSorted[aIndex < iSorted.size() ? aIndex : iSorted.size() - 1];
+}
+
+/**
+ * \brief Run one scenario
+ */
+static Result RunScenario(const Options& iOptions, unsigned int iThreads, unsigned int iSize,
+	const std::string& iReporter, bool iDeferred) {
+	Result aResult;
+	evolve::log::Logger* aLogger = evolve::log::Logger::Instance();
+	evolve::log::LoggerReporter* aReporter = CreateReporter(iOptions, iReporter);
+	aLogger->attachReporter(aReporter, evolve::log::LEVEL_DEBUG, iOptions._sinkCapacity, iOptions._policy);
+	//new threads only, they get staging buffers with this policy
+	aLogger->setOverflowPolicy(iOptions._policy);
+
+	const std::string aPayload(iSize, 'x');
+	const unsigned long long aDroppedBefore = aLogger->getDroppedCount();
+	std::vector<std::vector<unsigned long long> > aLatencies(iThreads);
+	//one cache line per producer counter, a shared line would slow the producers down
+	const std::size_t aStride = EVOLVE_CACHE_LINE_SIZE / sizeof(std::atomic<unsigned long long>);
+	std::vector<std::atomic<unsigned long long> > aLogged(iThreads * aStride);
+	std::atomic<unsigned int> aReady(0);
+	std::atomic<unsigned int> aDone(0);
+	std::atomic<bool> aGo(false);
+	std::vector<std::thread> aThreads;
+
+	for (unsigned int t = 0; t < iThreads; ++t) {
+		aLogged[t * aStride].store(0);
+		aLatencies[t].resize(iOptions._messages);
+		aThreads.push_back(std::thread([&, t]() {
+			const char* aText = aPayload.c_str();
+			for (unsigned int i = 0; i < iOptions._warmup; ++i) {
+				EVOLVE_LOGF(evolve::log::LEVEL_INFO, "warmup {}", i);
+			}
+			++aReady;
+			while (!aGo.load()) {
+				std::this_thread::yield();
+			}
+			unsigned long long* aOut = aLatencies[t].data();
+			for (unsigned int i = 0; i < iOptions._messages; ++i) {
+				const std::chrono::steady_clock::time_point aStart = std::chrono::steady_clock::now();
+				//not the EVOLVE_LOG_INFO family, so the result does not depend on USE_EVOLVE_LOG_*
+				if (iDeferred) {
+					EVOLVE_LOGF(evolve::log::LEVEL_INFO, "{} {}", aText, i);
+				}
+				else {
+					EVOLVE_LOG(evolve::log::LEVEL_INFO, aText << " " << i);
+				}
+				aOut[i] = static_cast<unsigned long long>(
+					std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - aStart).count());
+				aLogged[t * aStride].store(i + 1, std::memory_order_relaxed);
+			}
+			++aDone;
+		}));
+	}
+	while (aReady.load() != iThreads) {
+		std::this_thread::yield();
+	}
+
+	//the warmup messages must not count in the depth nor the throughput
+	aLogger->sync(60000);
+	evolve::log::LoggerSinkStatistics aStatistics;
+	aLogger->getStatistics(aReporter, aStatistics);
+	const unsigned long long aDeliveredBefore = aStatistics._delivered;
+	const unsigned long long aSinkDroppedBefore = aStatistics._dropped;
+
+	const std::chrono::steady_clock::time_point aStart = std::chrono::steady_clock::now();
+	aGo = true;
+
+	//sample the depth until everything has been logged and delivered
+	std::chrono::steady_clock::time_point aProducersEnd = aStart;
+	bool aProducing = true;
+	while (true) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(iOptions._sampleMs));
+		unsigned long long aTotalLogged = 0;
+		for (unsigned int t = 0; t < iThreads; ++t) {
+			aTotalLogged += aLogged[t * aStride].load(std::memory_order_relaxed);
+		}
+		aLogger->getStatistics(aReporter, aStatistics);
+		const unsigned long long aHandled = (aStatistics._delivered - aDeliveredBefore)
+			+ (aStatistics._dropped - aSinkDroppedBefore) + (aLogger->getDroppedCount() - aDroppedBefore);
+		aResult._depths.push_back(aTotalLogged > aHandled ? aTotalLogged - aHandled : 0);
+
+		if (aProducing && aDone.load() == iThreads) {
+			aProducing = false;
+			aProducersEnd = std::chrono::steady_clock::now();
+		}
+		if (!aProducing && aHandled >= aTotalLogged) {
+			break;
+		}
+		if (!aProducing && std::chrono::steady_clock::now() - aProducersEnd > std::chrono::seconds(60)) {
+			break;
+		}
+	}
+	for (std::thread& aThread : aThreads) {
+		aThread.join();
+	}
+	aResult._synced = aLogger->sync(60000);
+	const std::chrono::steady_clock::time_point aEnd = std::chrono::steady_clock::now();
+
+	aLogger->getStatistics(aReporter, aStatistics);
+	aResult._delivered = aStatistics._delivered - aDeliveredBefore;
+	aResult._dropped = (aStatistics._dropped - aSinkDroppedBefore) + (aLogger->getDroppedCount() - aDroppedBefore);
+	aResult._producerSeconds = std::chrono::duration<double>(aProducersEnd - aStart).count();
+	aResult._totalSeconds = std::chrono::duration<double>(aEnd - aStart).count();
+	aLogger->detachReporter(aReporter);
+	RemoveOutputs(iOptions);
+
+	std::vector<unsigned long long> aAll;
+	aAll.reserve(static_cast<std::size_t>(iThreads) * iOptions._messages);
+	for (unsigned int t = 0; t < iThreads; ++t) {
+		aAll.insert(aAll.end(), aLatencies[t].begin(), aLatencies[t].end());
+	}
+	std::sort(aAll.begin(), aAll.end());
+	double aSum = 0.0;
+	for (std::size_t i = 0; i < aAll.size(); ++i) {
+		aSum += static_cast<double>(aAll[i]);
+	}
+	aResult._p50 = Percentile(aAll, 0.50);
+	aResult._p99 = Percentile(aAll, 0.99);
+	aResult._p999 = Percentile(aAll, 0.999);
+	aResult._max = aAll.empty() ? 0 : aAll.back();
+	aResult._mean = aAll.empty() ? 0.0 : aSum / static_cast<double>(aAll.size());
+
+	double aDepthSum = 0.0;
+	for (std::size_t i = 0; i < aResult._depths.size(); ++i) {
+		aResult._maxDepth = std::max(aResult._maxDepth, aResult._depths[i]);
+		aDepthSum += static_cast<double>(aResult._depths[i]);
+	}
+	aResult._meanDepth = aResult._depths.empty() ? 0.0 : aDepthSum / static_cast<double>(aResult._depths.size());
+	return aResult;
+}
+
+static void PrintResult(const Options& iOptions, unsigned int iThreads, unsigned int iSize,
+	const std::string& iReporter, const std::string& iMacro, const Result& iResult) {
+	const double aMessages = static_cast<double>(iThreads) * iOptions._messages;
+	const double aThroughput = iResult._totalSeconds > 0.0 ? aMessages / iResult._totalSeconds : 0.0;
+	const double aProducerThroughput = iResult._producerSeconds > 0.0 ? aMessages / iResult._producerSeconds : 0.0;
+
+	std::stringstream aSs;
+	aSs.setf(std::ios::fixed);
+	aSs.precision(1);
+	if (iOptions._csv) {
+		aSs << iReporter << "," << iMacro << "," << iThreads << "," << iSize << "," << iOptions._policyName << ","
+			<< static_cast<unsigned long long>(aMessages) << "," << iResult._p50 << "," << iResult._p99 << ","
+			<< iResult._p999 << "," << iResult._max << "," << iResult._mean << "," << aProducerThroughput << ","
+			<< aThroughput << "," << iResult._delivered << "," << iResult._dropped << "," << iResult._maxDepth << ","
+			<< iResult._meanDepth << "," << (iResult._synced ? "true" : "false");
+	}
+	else {
+		aSs << "{\"reporter\":\"" << iReporter << "\",\"macro\":\"" << iMacro << "\",\"threads\":" << iThreads
+			<< ",\"size\":" << iSize << ",\"policy\":\"" << iOptions._policyName << "\""
+			<< ",\"messages\":" << static_cast<unsigned long long>(aMessages)
+			<< ",\"latency_ns\":{\"p50\":" << iResult._p50 << ",\"p99\":" << iResult._p99
+			<< ",\"p99.9\":" << iResult._p999 << ",\"max\":" << iResult._max << ",\"mean\":" << iResult._mean << "}"
+			<< ",\"producer_msg_per_s\":" << aProducerThroughput << ",\"end_to_end_msg_per_s\":" << aThroughput
+			<< ",\"delivered\":" << iResult._delivered << ",\"dropped\":" << iResult._dropped
+			<< ",\"depth\":{\"max\":" << iResult._maxDepth << ",\"mean\":" << iResult._meanDepth
+			<< ",\"sample_ms\":" << iOptions._sampleMs;
+		if (iOptions._series) {
+			aSs << ",\"series\":[";
+			for (std::size_t i = 0; i < iResult._depths.size(); ++i) {
+				aSs << (i == 0 ? "" : ",") << iResult._depths[i];
+			}
+			aSs << "]";
+		}
+		aSs << "},\"synced\":" << (iResult._synced ? "true" : "false") << "}";
+	}
+	std::cout << aSs.str() << std::endl;
+}
+
+static int Usage() {
+	std::cerr << "usage: evolve_logbench [--threads 1,4,16,64] [--sizes 16,128,1024]" << std::endl;
+	std::cerr << "         [--reporters null,file,buffered,binary,json,mapped] [--macros stream,deferred]" << std::endl;
+	std::cerr << "         [--messages N] [--warmup N] [--policy block|drop-newest|drop-oldest|sample]" << std::endl;
+	std::cerr << "         [--sink-capacity N] [--sample-ms N] [--dir PATH] [--format json|csv] [--series]" << std::endl;
+	std::cerr << "         [--budget-ns N]" << std::endl;
+	return EXIT_FAILURE;
+}
+
+int main(int argc, char** argv) {
+	Options aOptions;
+	ParseList("1,4,16,64", aOptions._threads);
+	ParseList("16,128,1024", aOptions._sizes);
+	ParseList("null,buffered", aOptions._reporters);
+	ParseList("stream,deferred", aOptions._macros);
+
+	for (int i = 1; i < argc; ++i) {
+		const bool aHasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--threads") == 0 && aHasValue) {
+			if (!ParseList(argv[++i], aOptions._threads)) {
+				return Usage();
+			}
+		}
+		else if (std::strcmp(argv[i], "--sizes") == 0 && aHasValue) {
+			if (!ParseList(argv[++i], aOptions._sizes)) {
+				return Usage();
+			}
+		}
+		else if (std::strcmp(argv[i], "--reporters") == 0 && aHasValue) {
+			ParseList(argv[++i], aOptions._reporters);
+		}
+		else if (std::strcmp(argv[i], "--macros") == 0 && aHasValue) {
+			ParseList(argv[++i], aOptions._macros);
+		}
+		else if (std::strcmp(argv[i], "--messages") == 0 && aHasValue) {
+			aOptions._messages = static_cast<unsigned int>(std::atoi(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--warmup") == 0 && aHasValue) {
+			aOptions._warmup = static_cast<unsigned int>(std::atoi(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--policy") == 0 && aHasValue) {
+			aOptions._policyName = argv[++i];
+			if (aOptions._policyName == "block") {
+				aOptions._policy = evolve::log::OVERFLOW_BLOCK;
+			}
+			else if (aOptions._policyName == "drop-newest") {
+				aOptions._policy = evolve::log::OVERFLOW_DROP_NEWEST;
+			}
+			else if (aOptions._policyName == "drop-oldest") {
+				aOptions._policy = evolve::log::OVERFLOW_DROP_OLDEST;
+			}
+			else if (aOptions._policyName == "sample") {
+				aOptions._policy = evolve::log::OVERFLOW_SAMPLE;
+			}
+			else {
+				return Usage();
+			}
+		}
+		else if (std::strcmp(argv[i], "--sink-capacity") == 0 && aHasValue) {
+			aOptions._sinkCapacity = static_cast<std::size_t>(std::atoll(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--sample-ms") == 0 && aHasValue) {
+			aOptions._sampleMs = static_cast<unsigned int>(std::max(1, std::atoi(argv[++i])));
+		}
+		else if (std::strcmp(argv[i], "--dir") == 0 && aHasValue) {
+			aOptions._dir = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--format") == 0 && aHasValue) {
+			const std::string aFormat(argv[++i]);
+			if (aFormat != "json" && aFormat != "csv") {
+				return Usage();
+			}
+			aOptions._csv = aFormat == "csv";
+		}
+		else if (std::strcmp(argv[i], "--series") == 0) {
+			aOptions._series = true;
+		}
+		else if (std::strcmp(argv[i], "--budget-ns") == 0 && aHasValue) {
+			aOptions._budgetNs = std::strtoull(argv[++i], NULL, 10);
+		}
+		else {
+			return Usage();
+		}
+	}
+	if (aOptions._messages == 0 || aOptions._reporters.empty() || aOptions._macros.empty()) {
+		return Usage();
+	}
+	for (std::size_t r = 0; r < aOptions._reporters.size(); ++r) {
+		evolve::log::LoggerReporter* aReporter = CreateReporter(aOptions, aOptions._reporters[r]);
+		if (aReporter == NULL) {
+			std::cerr << "Can't create reporter " << aOptions._reporters[r] << std::endl;
+			return Usage();
+		}
+		delete aReporter;
+		RemoveOutputs(aOptions);
+	}
+	for (std::size_t m = 0; m < aOptions._macros.size(); ++m) {
+		if (aOptions._macros[m] != "stream" && aOptions._macros[m] != "deferred") {
+			return Usage();
+		}
+	}
+
+	//log everything, whatever EVOLVE_LOG_LEVEL says
+	evolve::log::Logger::SetLevel(evolve::log::LEVEL_DEBUG);
+
+	if (aOptions._csv) {
+		std::cout << "reporter,macro,threads,size,policy,messages,p50_ns,p99_ns,p99.9_ns,max_ns,mean_ns,"
+			"producer_msg_per_s,end_to_end_msg_per_s,delivered,dropped,max_depth,mean_depth,synced" << std::endl;
+	}
+
+	bool aOverBudget = false;
+	for (std::size_t r = 0; r < aOptions._reporters.size(); ++r) {
+		for (std::size_t m = 0; m < aOptions._macros.size(); ++m) {
+			for (std::size_t s = 0; s < aOptions._sizes.size(); ++s) {
+				for (std::size_t t = 0; t < aOptions._threads.size(); ++t) {
+					std::cerr << aOptions._reporters[r] << " " << aOptions._macros[m] << " size " << aOptions._sizes[s]
+						<< " threads " << aOptions._threads[t] << std::endl;
+					const Result aResult = RunScenario(aOptions, aOptions._threads[t], aOptions._sizes[s],
+						aOptions._reporters[r], aOptions._macros[m] == "deferred");
+					PrintResult(aOptions, aOptions._threads[t], aOptions._sizes[s], aOptions._reporters[r], aOptions._macros[m], aResult);
+					if (aOptions._budgetNs != 0 && aResult._p999 > aOptions._budgetNs) {
+						aOverBudget = true;
+					}
+				}
+			}
+		}
+	}
+
+	return aOverBudget ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,114 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file logdecode/logdecode.cpp
+ * \brief evolve_logdecode, binary log file to text converter
+ * \author
+ *
+ * Reads files written by evolve::log::BinaryFileLoggerReporter and prints
+ * them in the text format of the other reporters.
+ *
+ * Usage: evolve_logdecode <file> [--level LEVEL] [--thread INDEX]
+ *                         [--from TIME] [--to TIME] [--pattern PATTERN]
+ * TIME is either "YYYY-MM-DD HH:MM:SS" (UTC) or seconds since epoch.
+ * PATTERN is a LogLayout pattern, the reporters default layout if omitted.
+ */
+
+#include <evolve/log/log.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+static int Usage() {
+	std::cerr << "usage: evolve_logdecode <file> [--level LEVEL] [--thread INDEX] [--from TIME] [--to TIME] [--pattern PATTERN]" << std::endl;
+	std::cerr << "  TIME is \"YYYY-MM-DD HH:MM:SS\" (UTC) or seconds since epoch" << std::endl;
+	return EXIT_FAILURE;
+}
+
+int main(int argc, char** argv) {
+	const char* aFile = NULL;
+	evolve::log::LogLevel aLevel = evolve::log::LEVEL_DEBUG;
+	long long aThread = -1;
+	unsigned long long aFrom = 0;
+	unsigned long long aTo = ~0ULL;
+	const char* aPattern = EVOLVE_LOG_DEFAULT_PATTERN;
+
+	for (int i = 1; i < argc; ++i) {
+		const bool aHasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--level") == 0 && aHasValue) {
+			aLevel = evolve::log::Logger::ParseLevel(argv[++i], evolve::log::LEVEL_OFF);
+			if (aLevel == evolve::log::LEVEL_OFF) {
+				return Usage();
+			}
+		}
+		else if (std::strcmp(argv[i], "--thread") == 0 && aHasValue) {
+			aThread = std::atoll(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--from") == 0 && aHasValue) {
+			if (!evolve::utils::Clock::Parse(argv[++i], aFrom)) {
+				return Usage();
+			}
+		}
+		else if (std::strcmp(argv[i], "--to") == 0 && aHasValue) {
+			if (!evolve::utils::Clock::Parse(argv[++i], aTo)) {
+				return Usage();
+			}
+		}
+		else if (std::strcmp(argv[i], "--pattern") == 0 && aHasValue) {
+			aPattern = argv[++i];
+		}
+		else if (aFile == NULL && argv[i][0] != '-') {
+			aFile = argv[i];
+		}
+		else {
+			return Usage();
+		}
+	}
+	if (aFile == NULL) {
+		return Usage();
+	}
+
+	evolve::log::BinaryLogReader aReader(aFile);
+	if (!aReader.isOpen()) {
+		std::cerr << "Can't open " << aFile << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	evolve::log::BinaryLogRecord aRecord;
+	evolve::log::LogLayout aLayout(aPattern);
+	std::string aLine;
+	while (aReader.next(aRecord)) {
+		if (aRecord._level < aLevel
+			|| (aThread >= 0 && aRecord._threadIndex != static_cast<unsigned long long>(aThread))
+			|| aRecord._time < aFrom || aRecord._time > aTo) {
+			continue;
+		}
+		aLine.clear();
+		aLayout.append(aRecord, aLine);
+		std::cout << aLine << '\n';
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,322 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file logquery/logquery.cpp
+ * \brief evolve_logquery, indexed search of text log files
+ * \author
+ *
+ * Reads the sidecar index written by a FileLoggerReporter whose flush policy
+ * has withIndex(), then reads only the blocks which may hold matching
+ * messages instead of scanning the whole file. Parts of the file the index
+ * does not describe are always read. Without an index the whole file is read.
+ *
+ * Blocks are filtered by time, level and thread, then each line is filtered
+ * exactly: JSON lines (JsonLinesLoggerReporter) by their keys, other lines by
+ * reading them back with the LogLayout pattern they were written with. Lines
+ * which don't follow the pattern, as the rest of a multi-line message, go
+ * with the line before them. --grep narrows lines down further.
+ *
+ * Named threads only show their name in %t: select them with --thread NAME,
+ * or write %i in the pattern to select them by index.
+ *
+ * Usage: evolve_logquery <file> [--level LEVEL] [--thread INDEX|NAME] [--from TIME]
+ *                        [--to TIME] [--pattern PATTERN] [--grep TEXT] [--stats]
+ * TIME is either "YYYY-MM-DD HH:MM:SS" (UTC) or seconds since epoch.
+ * PATTERN is a LogLayout pattern, the reporters default layout if omitted.
+ */
+
+#include <evolve/log/log.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Byte range of the log file to read
+ */
+struct Range {
+	unsigned long long _offset;
+	unsigned long long _end;
+};
+
+/**
+ * \brief Query parameters
+ */
+struct Query {
+	evolve::log::LogLevel _level;
+	long long _thread;
+	const char* _threadName; ///< --thread of a named thread, text lines only
+	unsigned long long _from;
+	unsigned long long _to;
+	const char* _grep;
+	const evolve::log::LogLayout* _layout; ///< layout of text lines
+};
+
+/**
+ * \brief Check a block summary against the query
+ */
+static bool MatchEntry(const evolve::log::LogIndexEntry& iEntry, const Query& iQuery) {
+	return iEntry._lastTime >= iQuery._from && iEntry._firstTime <= iQuery._to
+		&& iEntry.hasLevel(iQuery._level)
+		&& (iQuery._thread < 0 || iEntry.hasThread(static_cast<unsigned int>(iQuery._thread)));
+}
+
+/**
+ * \brief Find a top-level JSON key, as written by JsonLinesLoggerReporter, before iEnd
+ */
+static std::size_t FindJsonKey(const std::string& iLine, const char* iKey, std::size_t iEnd) {
+	const std::size_t aPosition = iLine.find(iKey);
+	return aPosition != std::string::npos && aPosition < iEnd ? aPosition : std::string::npos;
+}
+
+/**
+ * \brief Read an unsigned number following a top-level JSON key, before iEnd
+ */
+static bool ReadJsonNumber(const std::string& iLine, const char* iKey, std::size_t iEnd, unsigned long long& oValue) {
+	const std::size_t aPosition = FindJsonKey(iLine, iKey, iEnd);
+	if (aPosition == std::string::npos) {
+		return false;
+	}
+	oValue = std::strtoull(iLine.c_str() + aPosition + std::strlen(iKey), NULL, 10);
+	return true;
+}
+
+/**
+ * \brief Check a line read back with the layout against the query
+ *
+ * \param[in,out] ioMatching verdict of the last line following the layout, kept for the lines which don't
+ */
+static bool MatchText(const std::string& iLine, const Query& iQuery, bool& ioMatching) {
+	evolve::log::LogLineHeader aHeader;
+	if (!iQuery._layout->parse(iLine.data(), iLine.size(), aHeader)) {
+		return ioMatching;
+	}
+	ioMatching = (!aHeader._hasTime || (aHeader._time >= iQuery._from && aHeader._time <= iQuery._to))
+		&& (!aHeader._hasLevel || aHeader._level >= iQuery._level)
+		&& (iQuery._thread < 0 || (aHeader._hasThread ? aHeader._threadIndex == static_cast<unsigned long long>(iQuery._thread) : aHeader._threadName.empty()))
+		&& (iQuery._threadName == NULL || aHeader._threadName == iQuery._threadName);
+	return ioMatching;
+}
+
+/**
+ * \brief Check a line against the query
+ *
+ * \param[in,out] ioMatching verdict of the last text line, see MatchText
+ */
+static bool MatchLine(const std::string& iLine, const Query& iQuery, bool& ioMatching) {
+	if (iLine.compare(0, 9, "{\"time\":\"") != 0) {
+		const bool aMatching = MatchText(iLine, iQuery, ioMatching);
+		return aMatching && (iQuery._grep == NULL || iLine.find(iQuery._grep) != std::string::npos);
+	}
+	if (iQuery._grep != NULL && iLine.find(iQuery._grep) == std::string::npos) {
+		return false;
+	}
+	//the fields object comes after the message, and may use the same keys: only look before it.
+	//quotes are escaped inside strings, so the first ,"message": is the top-level one
+	const std::size_t aHeaderEnd = iLine.find(",\"message\":");
+	unsigned long long aValue;
+	if (ReadJsonNumber(iLine, "\"time_ns\":", aHeaderEnd, aValue) && (aValue < iQuery._from || aValue > iQuery._to)) {
+		return false;
+	}
+	if (iQuery._thread >= 0 && ReadJsonNumber(iLine, "\"thread\":", aHeaderEnd, aValue) && aValue != static_cast<unsigned long long>(iQuery._thread)) {
+		return false;
+	}
+	if (iQuery._threadName != NULL && FindJsonKey(iLine, ("\"thread_name\":\"" + std::string(iQuery._threadName) + '"').c_str(), aHeaderEnd) == std::string::npos) {
+		return false;
+	}
+	const std::size_t aLevel = FindJsonKey(iLine, "\"level\":\"", aHeaderEnd);
+	if (aLevel != std::string::npos) {
+		const std::size_t aStart = aLevel + 9;
+		const std::string aName = iLine.substr(aStart, iLine.find('"', aStart) - aStart);
+		if (evolve::log::Logger::ParseLevel(aName.c_str(), evolve::log::LEVEL_OFF) < iQuery._level) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static int Usage() {
+	std::cerr << "usage: evolve_logquery <file> [--level LEVEL] [--thread INDEX|NAME] [--from TIME] [--to TIME] [--pattern PATTERN] [--grep TEXT] [--stats]" << std::endl;
+	std::cerr << "  TIME is \"YYYY-MM-DD HH:MM:SS\" (UTC) or seconds since epoch" << std::endl;
+	return EXIT_FAILURE;
+}
+
+int main(int argc, char** argv) {
+	const char* aFile = NULL;
+	Query aQuery;
+	aQuery._level = evolve::log::LEVEL_DEBUG;
+	aQuery._thread = -1;
+	aQuery._threadName = NULL;
+	aQuery._from = 0;
+	aQuery._to = ~0ULL;
+	aQuery._grep = NULL;
+	aQuery._layout = NULL;
+	const char* aPattern = EVOLVE_LOG_DEFAULT_PATTERN;
+	bool aStats = false;
+
+	for (int i = 1; i < argc; ++i) {
+		const bool aHasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--level") == 0 && aHasValue) {
+			aQuery._level = evolve::log::Logger::ParseLevel(argv[++i], evolve::log::LEVEL_OFF);
+			if (aQuery._level == evolve::log::LEVEL_OFF) {
+				return Usage();
+			}
+		}
+		else if (std::strcmp(argv[i], "--thread") == 0 && aHasValue) {
+			const char* aThread = argv[++i];
+			if (aThread[0] >= '0' && aThread[0] <= '9') {
+				aQuery._thread = std::atoll(aThread);
+			}
+			else {
+				aQuery._threadName = aThread;
+			}
+		}
+		else if (std::strcmp(argv[i], "--from") == 0 && aHasValue) {
+			if (!evolve::utils::Clock::Parse(argv[++i], aQuery._from)) {
+				return Usage();
+			}
+		}
+		else if (std::strcmp(argv[i], "--to") == 0 && aHasValue) {
+			if (!evolve::utils::Clock::Parse(argv[++i], aQuery._to)) {
+				return Usage();
+			}
+		}
+		else if (std::strcmp(argv[i], "--pattern") == 0 && aHasValue) {
+			aPattern = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--grep") == 0 && aHasValue) {
+			aQuery._grep = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--stats") == 0) {
+			aStats = true;
+		}
+		else if (aFile == NULL && argv[i][0] != '-') {
+			aFile = argv[i];
+		}
+		else {
+			return Usage();
+		}
+	}
+	if (aFile == NULL) {
+		return Usage();
+	}
+
+	std::ifstream aLog(aFile, std::ifstream::in | std::ifstream::binary | std::ifstream::ate);
+	if (!aLog.is_open()) {
+		std::cerr << "Can't open " << aFile << std::endl;
+		return EXIT_FAILURE;
+	}
+	const unsigned long long aSize = static_cast<unsigned long long>(aLog.tellg());
+	char aMagic[sizeof(EVOLVE_BINARY_LOG_MAGIC) - 1];
+	aLog.seekg(0);
+	if (aLog.read(aMagic, sizeof(aMagic)) && std::memcmp(aMagic, EVOLVE_BINARY_LOG_MAGIC, sizeof(aMagic)) == 0) {
+		std::cerr << aFile << " is a binary log, use evolve_logdecode" << std::endl;
+		return EXIT_FAILURE;
+	}
+	aLog.clear();
+
+	std::vector<evolve::log::LogIndexEntry> aEntries;
+	if (!evolve::log::ReadLogIndex(aFile, aEntries)) {
+		std::cerr << "No index for " << aFile << ", reading the whole file" << std::endl;
+	}
+
+	//matching blocks, plus whatever the index doesn't describe, merged when contiguous
+	std::vector<Range> aRanges;
+	unsigned long long aCovered = 0;
+	std::size_t aMatching = 0;
+	for (std::size_t i = 0; i < aEntries.size(); ++i) {
+		const evolve::log::LogIndexEntry& aEntry = aEntries[i];
+		if (aEntry._offset < aCovered || aEntry._offset + aEntry._size > aSize) {
+			continue;
+		}
+		if (aEntry._offset > aCovered) {
+			Range aGap = { aCovered, aEntry._offset };
+			aRanges.push_back(aGap);
+		}
+		if (MatchEntry(aEntry, aQuery)) {
+			Range aBlock = { aEntry._offset, aEntry._offset + aEntry._size };
+			aRanges.push_back(aBlock);
+			++aMatching;
+		}
+		aCovered = aEntry._offset + aEntry._size;
+	}
+	if (aCovered < aSize) {
+		Range aTail = { aCovered, aSize };
+		aRanges.push_back(aTail);
+	}
+	std::vector<Range> aMerged;
+	for (std::size_t i = 0; i < aRanges.size(); ++i) {
+		if (!aMerged.empty() && aMerged.back()._end == aRanges[i]._offset) {
+			aMerged.back()._end = aRanges[i]._end;
+		}
+		else {
+			aMerged.push_back(aRanges[i]);
+		}
+	}
+
+	const evolve::log::LogLayout aLayout(aPattern);
+	aQuery._layout = &aLayout;
+	std::vector<char> aChunk(1 << 20);
+	std::string aLine;
+	unsigned long long aRead = 0;
+	unsigned long long aPrinted = 0;
+	for (std::size_t r = 0; r < aMerged.size(); ++r) {
+		aLog.seekg(static_cast<std::streamoff>(aMerged[r]._offset));
+		unsigned long long aLeft = aMerged[r]._end - aMerged[r]._offset;
+		aLine.clear();
+		//blocks start on a message, before the first one nothing is known
+		bool aMatching = true;
+		while (aLeft != 0 && aLog) {
+			const std::size_t aCount = static_cast<std::size_t>(std::min<unsigned long long>(aLeft, aChunk.size()));
+			aLog.read(aChunk.data(), aCount);
+			const std::size_t aGot = static_cast<std::size_t>(aLog.gcount());
+			aLeft -= aGot;
+			aRead += aGot;
+			for (std::size_t i = 0; i < aGot; ++i) {
+				if (aChunk[i] != '\n') {
+					aLine += aChunk[i];
+					continue;
+				}
+				if (MatchLine(aLine, aQuery, aMatching)) {
+					std::cout << aLine << '\n';
+					++aPrinted;
+				}
+				aLine.clear();
+			}
+		}
+		if (!aLine.empty() && MatchLine(aLine, aQuery, aMatching)) {
+			std::cout << aLine << '\n';
+			++aPrinted;
+		}
+	}
+
+	if (aStats) {
+		std::cerr << aEntries.size() << " index entries, " << aMatching << " matching, "
+			<< aRead << " of " << aSize << " bytes read, " << aPrinted << " lines printed" << std::endl;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,171 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file logtail/logtail.cpp
+ * \brief evolve_logtail, live reader of a shared memory log ring
+ * \author
+ *
+ * Attaches to the ring written by evolve::log::SharedMemoryLoggerReporter and
+ * prints its records in the text format of the other reporters. The logging
+ * process is never blocked: when the reader falls behind, the overwritten
+ * records are counted and reported instead.
+ *
+ * Usage: evolve_logtail <name> [--level LEVEL] [--thread INDEX] [--pattern PATTERN]
+ *                       [--output FILE] [--from-now] [--no-follow]
+ * PATTERN is a LogLayout pattern, the reporters default layout if omitted.
+ */
+
+#include <evolve/log/log.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+/**
+ * Polling delays in milliseconds, doubled from the first to the second while the ring is idle
+ */
+static const unsigned int MinDelay = 10;
+static const unsigned int MaxDelay = 500;
+
+static int Usage() {
+	std::cerr << "usage: evolve_logtail <name> [--level LEVEL] [--thread INDEX] [--pattern PATTERN] [--output FILE] [--from-now] [--no-follow]" << std::endl;
+	return EXIT_FAILURE;
+}
+
+int main(int argc, char** argv) {
+	const char* aName = NULL;
+	evolve::log::LogLevel aLevel = evolve::log::LEVEL_DEBUG;
+	long long aThread = -1;
+	const char* aPattern = EVOLVE_LOG_DEFAULT_PATTERN;
+	const char* aOutput = NULL;
+	bool aFromStart = true;
+	bool aFollow = true;
+
+	for (int i = 1; i < argc; ++i) {
+		const bool aHasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--level") == 0 && aHasValue) {
+			aLevel = evolve::log::Logger::ParseLevel(argv[++i], evolve::log::LEVEL_OFF);
+			if (aLevel == evolve::log::LEVEL_OFF) {
+				return Usage();
+			}
+		}
+		else if (std::strcmp(argv[i], "--thread") == 0 && aHasValue) {
+			aThread = std::atoll(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--pattern") == 0 && aHasValue) {
+			aPattern = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--output") == 0 && aHasValue) {
+			aOutput = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--from-now") == 0) {
+			aFromStart = false;
+		}
+		else if (std::strcmp(argv[i], "--no-follow") == 0) {
+			aFollow = false;
+		}
+		else if (aName == NULL && argv[i][0] != '-') {
+			aName = argv[i];
+		}
+		else {
+			return Usage();
+		}
+	}
+	if (aName == NULL) {
+		return Usage();
+	}
+
+	std::ofstream aFile;
+	if (aOutput != NULL) {
+		aFile.open(aOutput, std::ofstream::out | std::ofstream::app);
+		if (!aFile.is_open()) {
+			std::cerr << "Can't open " << aOutput << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	std::ostream& aOut = aOutput != NULL ? static_cast<std::ostream&>(aFile) : std::cout;
+
+	std::unique_ptr<evolve::log::SharedMemoryLogReader> aReader(new evolve::log::SharedMemoryLogReader(aName, aFromStart));
+	if (!aReader->isOpen()) {
+		std::cerr << "Can't open shared log ring " << aName << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	evolve::log::BinaryLogRecord aRecord;
+	evolve::log::LogLayout aLayout(aPattern);
+	std::string aLine;
+	unsigned long long aLost = 0;
+	unsigned int aIdle = 0;
+	unsigned int aDelay = MinDelay;
+	while (true) {
+		bool aRead = false;
+		while (aReader->next(aRecord)) {
+			aRead = true;
+			if (aReader->getLostCount() != aLost) {
+				aOut << "-- " << aReader->getLostCount() - aLost << " records overwritten before being read --\n";
+				aLost = aReader->getLostCount();
+			}
+			if (aRecord._level < aLevel
+				|| (aThread >= 0 && aRecord._threadIndex != static_cast<unsigned long long>(aThread))) {
+				continue;
+			}
+			aLine.clear();
+			aLayout.append(aRecord, aLine);
+			aOut << aLine << '\n';
+		}
+		if (aRead) {
+			aOut.flush();
+			aIdle = 0;
+			aDelay = MinDelay;
+		}
+
+		if (!aFollow) {
+			break;
+		}
+		//a closed ring is checked on each wake up, a live one now and then in case its writer crashed;
+		//only the header generation is read, the new ring is mapped once it is there
+		if ((aReader->isClosed() || ++aIdle % 16 == 0) && aReader->isReplaced()) {
+			std::unique_ptr<evolve::log::SharedMemoryLogReader> aNext(new evolve::log::SharedMemoryLogReader(aName, true));
+			if (aNext->isOpen()) {
+				aOut << "-- " << aName << " restarted --\n";
+				aReader.swap(aNext);
+				aLost = 0;
+				aIdle = 0;
+				aDelay = MinDelay;
+				continue;
+			}
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(aDelay));
+		//back off while nothing is published
+		if (!aRead) {
+			aDelay = aDelay * 2 < MaxDelay ? aDelay * 2 : MaxDelay;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,157 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file logtests/asyncfilewritertests.cpp
+ * \brief evolve_logtests, background file writes
+ * \author
+ *
+ */
+
+#include "logtests.h"
+#include <evolve/log/asyncfilewriter.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifndef WIN32
+#include <csignal>
+#include <sys/resource.h>
+#endif
+
+using evolve::log::AsyncFileWriter;
+
+static const char* ASYNC_FILE = "evolve_logtests_async.log";
+
+static std::string ReadFile(const char* iPath) {
+	std::ifstream aFile(iPath, std::ifstream::in | std::ifstream::binary);
+	std::stringstream aSs;
+	aSs << aFile.rdbuf();
+	return aSs.str();
+}
+
+//buffers of different sizes, the first ones much larger, so later ones tend to complete first
+static std::string Chunk(unsigned int iIndex) {
+	std::stringstream aSs;
+	const unsigned int aRepeat = iIndex < 4 ? 20000 : iIndex % 7 + 1;
+	for (unsigned int i = 0; i < aRepeat; ++i) {
+		aSs << "buffer " << iIndex << "\n";
+	}
+	return aSs.str();
+}
+
+//every buffer lands at its submission offset, whatever order the writes complete in
+static void CheckOrder(bool iPool) {
+	std::remove(ASYNC_FILE);
+	std::string aExpected;
+	{
+		AsyncFileWriter aWriter(4, 1024);
+		if (iPool) {
+			EVOLVE_CHECK(!aWriter.isUring());
+		}
+		EVOLVE_CHECK(aWriter.open(ASYNC_FILE));
+		std::string aBuffer;
+		for (unsigned int i = 0; i < 200; ++i) {
+			aBuffer = Chunk(i);
+			aExpected += aBuffer;
+			aWriter.write(aBuffer);
+			EVOLVE_CHECK(aBuffer.empty());
+		}
+		aWriter.wait();
+		EVOLVE_CHECK(!aWriter.hasFailed());
+		EVOLVE_CHECK(ReadFile(ASYNC_FILE) == aExpected);
+
+		//a reopened file is written after its end
+		EVOLVE_CHECK(aWriter.open(ASYNC_FILE));
+		aBuffer = "reopened\n";
+		aExpected += aBuffer;
+		aWriter.write(aBuffer);
+	}
+	EVOLVE_CHECK(ReadFile(ASYNC_FILE) == aExpected);
+	std::remove(ASYNC_FILE);
+}
+
+void TestAsyncFileWriter() {
+	//whichever back end the system has, then the thread pool
+	CheckOrder(false);
+#ifdef WIN32
+	_putenv_s("EVOLVE_LOG_IO_URING", "0");
+#else
+	setenv("EVOLVE_LOG_IO_URING", "0", 1);
+#endif
+	CheckOrder(true);
+
+#ifndef WIN32
+	//a write failing half way: the file ends at the first byte not written, later buffers are dropped.
+	//a read-only descriptor can't be truncated either, a file size limit fails writes past an offset instead
+	{
+		std::remove(ASYNC_FILE);
+		struct rlimit aLimit;
+		getrlimit(RLIMIT_FSIZE, &aLimit);
+		struct rlimit aSmall = aLimit;
+		aSmall.rlim_cur = 150;
+		void (*aHandler)(int) = std::signal(SIGXFSZ, SIG_IGN);
+		setrlimit(RLIMIT_FSIZE, &aSmall);
+
+		std::string aWritten;
+		{
+			AsyncFileWriter aWriter(4, 1024);
+			EVOLVE_CHECK(!aWriter.isUring());
+			EVOLVE_CHECK(aWriter.open(ASYNC_FILE));
+			for (char c = 'a'; c < 'd'; ++c) {
+				std::string aBuffer(100, c);
+				aWritten += aBuffer;
+				aWriter.write(aBuffer);
+			}
+			aWriter.wait();
+			EVOLVE_CHECK(aWriter.hasFailed());
+
+			std::string aLate(10, 'z');
+			aWriter.write(aLate);
+			EVOLVE_CHECK(aLate.empty());
+			aWriter.wait();
+			EVOLVE_CHECK(ReadFile(ASYNC_FILE) == aWritten.substr(0, 150));
+
+			//reopening clears the failure, writes go on from the cut
+			setrlimit(RLIMIT_FSIZE, &aLimit);
+			EVOLVE_CHECK(aWriter.open(ASYNC_FILE));
+			EVOLVE_CHECK(!aWriter.hasFailed());
+			std::string aNext("next\n");
+			aWriter.write(aNext);
+		}
+		EVOLVE_CHECK(ReadFile(ASYNC_FILE) == aWritten.substr(0, 150) + "next\n");
+
+		setrlimit(RLIMIT_FSIZE, &aLimit);
+		std::signal(SIGXFSZ, aHandler);
+		std::remove(ASYNC_FILE);
+	}
+#endif
+
+#ifdef WIN32
+	_putenv_s("EVOLVE_LOG_IO_URING", "");
+#else
+	unsetenv("EVOLVE_LOG_IO_URING");
+#endif
+}
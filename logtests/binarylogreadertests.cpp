@@ -0,0 +1,164 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file logtests/binarylogreadertests.cpp
+ * \brief evolve_logtests, binary reporter and reader round trip
+ * \author
+ *
+ */
+
+#include "logtests.h"
+#include <evolve/log/binaryfileloggerreporter.h>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <thread>
+
+using evolve::log::BinaryFileLoggerReporter;
+using evolve::log::BinaryLogReader;
+using evolve::log::BinaryLogRecord;
+using evolve::log::LogMessage;
+
+static const char* BINARY_FILE = "evolve_logtests.evbin";
+static const char* TRUNCATED_FILE = "evolve_logtests_truncated.evbin";
+
+static void WriteSession(const LogMessage* iMessages, std::size_t iCount) {
+	BinaryFileLoggerReporter aReporter(BINARY_FILE);
+	aReporter.logBatch(iMessages, iCount);
+}
+
+static std::string ReadAll(const char* iFile) {
+	std::ifstream aStream(iFile, std::ifstream::in | std::ifstream::binary);
+	return std::string(std::istreambuf_iterator<char>(aStream), std::istreambuf_iterator<char>());
+}
+
+void TestBinaryLogReader() {
+	std::remove(BINARY_FILE);
+	std::remove(TRUNCATED_FILE);
+
+	//a missing file is reported, not read
+	{
+		BinaryLogReader aReader(BINARY_FILE);
+		BinaryLogRecord aRecord;
+		EVOLVE_CHECK(!aReader.isOpen());
+		EVOLVE_CHECK(!aReader.next(aRecord));
+	}
+
+	//two sessions appended to the same file, the second one restarts the string ids
+	const LogMessage aFirst[] = {
+		TestMessage("first", evolve::log::LEVEL_INFO, EVOLVE_TEST_TIME + 10, 3, 10, "load"),
+		TestMessage("", evolve::log::LEVEL_WARNING, EVOLVE_TEST_TIME + 11, 3, 11, "load"),
+		TestMessage(std::string(300, 'z').c_str(), evolve::log::LEVEL_ERROR, EVOLVE_TEST_TIME + 12, 3, 12, "save"),
+	};
+	const LogMessage aSecond[] = {
+		TestMessage("second", evolve::log::LEVEL_DEBUG, EVOLVE_TEST_TIME + 20, 3, 20, "unload"),
+	};
+	WriteSession(aFirst, 3);
+	WriteSession(aSecond, 1);
+
+	{
+		BinaryLogReader aReader(BINARY_FILE);
+		BinaryLogRecord aRecord;
+		EVOLVE_CHECK(aReader.isOpen());
+
+		EVOLVE_CHECK(aReader.next(aRecord));
+		EVOLVE_CHECK_EQUAL(aRecord._time, 1500000000123456799ULL);
+		EVOLVE_CHECK(aRecord._level == evolve::log::LEVEL_INFO);
+		EVOLVE_CHECK_EQUAL(aRecord._file, "chunk.cpp");
+		EVOLVE_CHECK_EQUAL(aRecord._func, "load");
+		EVOLVE_CHECK_EQUAL(aRecord._line, 10u);
+		EVOLVE_CHECK_EQUAL(aRecord._threadIndex, 3u);
+		EVOLVE_CHECK_EQUAL(aRecord._threadId, static_cast<unsigned long long>(std::hash<std::thread::id>()(std::this_thread::get_id())));
+		EVOLVE_CHECK_EQUAL(aRecord._message, "first");
+
+		EVOLVE_CHECK(aReader.next(aRecord));
+		EVOLVE_CHECK(aRecord._level == evolve::log::LEVEL_WARNING);
+		EVOLVE_CHECK_EQUAL(aRecord._func, "load");
+		EVOLVE_CHECK_EQUAL(aRecord._message, "");
+
+		EVOLVE_CHECK(aReader.next(aRecord));
+		EVOLVE_CHECK(aRecord._level == evolve::log::LEVEL_ERROR);
+		EVOLVE_CHECK_EQUAL(aRecord._func, "save");
+		EVOLVE_CHECK_EQUAL(aRecord._message, std::string(300, 'z'));
+
+		EVOLVE_CHECK(aReader.next(aRecord));
+		EVOLVE_CHECK(aRecord._level == evolve::log::LEVEL_DEBUG);
+		EVOLVE_CHECK_EQUAL(aRecord._file, "chunk.cpp");
+		EVOLVE_CHECK_EQUAL(aRecord._func, "unload");
+		EVOLVE_CHECK_EQUAL(aRecord._line, 20u);
+		EVOLVE_CHECK_EQUAL(aRecord._message, "second");
+
+		EVOLVE_CHECK(!aReader.next(aRecord));
+	}
+
+	//file and function names are written once per session
+	{
+		const std::string aContent = ReadAll(BINARY_FILE);
+		std::size_t aCount = 0;
+		for (std::size_t aPos = aContent.find("load"); aPos != std::string::npos; aPos = aContent.find("load", aPos + 1)) {
+			++aCount;
+		}
+		//"load" in the first session, "unload" in the second
+		EVOLVE_CHECK_EQUAL(aCount, 2u);
+	}
+
+	//a record cut short by a crash ends the reading after the complete ones
+	{
+		const std::string aContent = ReadAll(BINARY_FILE);
+		{
+			std::ofstream aTruncated(TRUNCATED_FILE, std::ofstream::out | std::ofstream::binary);
+			aTruncated.write(aContent.data(), aContent.size() - 3);
+		}
+		BinaryLogReader aReader(TRUNCATED_FILE);
+		BinaryLogRecord aRecord;
+		std::size_t aCount = 0;
+		while (aReader.next(aRecord)) {
+			++aCount;
+		}
+		EVOLVE_CHECK_EQUAL(aCount, 3u);
+	}
+
+	//an unknown record type stops the reading instead of decoding garbage
+	{
+		std::string aContent = ReadAll(BINARY_FILE);
+		aContent += '\x7F';
+		aContent += ReadAll(BINARY_FILE);
+		{
+			std::ofstream aCorrupted(TRUNCATED_FILE, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+			aCorrupted.write(aContent.data(), aContent.size());
+		}
+		BinaryLogReader aReader(TRUNCATED_FILE);
+		BinaryLogRecord aRecord;
+		std::size_t aCount = 0;
+		while (aReader.next(aRecord)) {
+			++aCount;
+		}
+		EVOLVE_CHECK_EQUAL(aCount, 4u);
+	}
+
+	std::remove(BINARY_FILE);
+	std::remove(TRUNCATED_FILE);
+}
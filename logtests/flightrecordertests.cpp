@@ -0,0 +1,120 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file logtests/flightrecordertests.cpp
+ * \brief evolve_logtests, flight recorder dumps
+ * \author
+ *
+ */
+
+#include "logtests.h"
+#include <evolve/log/flightrecorder.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using evolve::log::FlightRecorder;
+
+static const char* FLIGHT_FILE = "evolve_logtests_flight.log";
+
+//thread indexes no living thread of the test takes
+static const unsigned int FLIGHT_THREAD = EVOLVE_THREAD_REGISTRY_SIZE - 3;
+
+static void Record(unsigned int iThread, unsigned int iIndex) {
+	const std::string aText = "flight " + std::to_string(iIndex);
+	FlightRecorder::Record(TestMessage(aText.c_str(), evolve::log::LEVEL_INFO, EVOLVE_TEST_TIME + iIndex, FLIGHT_THREAD + iThread));
+}
+
+//indexes of the recorded messages in the dump file, in file order
+static std::vector<unsigned int> ReadDump() {
+	std::vector<unsigned int> aIndexes;
+	std::ifstream aFile(FLIGHT_FILE);
+	std::string aLine;
+	while (std::getline(aFile, aLine)) {
+		const std::size_t aFound = aLine.find("flight ");
+		if (aFound != std::string::npos && aLine.compare(0, 4, "----") != 0) {
+			aIndexes.push_back(static_cast<unsigned int>(std::stoul(aLine.substr(aFound + 7))));
+		}
+	}
+	std::remove(FLIGHT_FILE);
+	return aIndexes;
+}
+
+void TestFlightRecorder() {
+	//small recorders, nothing logged by the other tests is recorded meanwhile
+	FlightRecorder::Enable(evolve::log::LEVEL_OFF, 4096);
+	std::remove(FLIGHT_FILE);
+
+	//three threads recorded one after the other, their messages interleaved in time
+	for (unsigned int t = 0; t < 3; ++t) {
+		for (unsigned int i = t; i < 15; i += 3) {
+			Record(t, i);
+		}
+	}
+	EVOLVE_CHECK_EQUAL(FlightRecorder::Dump(FLIGHT_FILE, "test"), 15u);
+	std::vector<unsigned int> aDumped = ReadDump();
+	EVOLVE_CHECK_EQUAL(aDumped.size(), 15u);
+	for (std::size_t i = 0; i < aDumped.size(); ++i) {
+		EVOLVE_CHECK_EQUAL(aDumped[i], i);
+	}
+
+	//an overwritten buffer keeps its newest messages, still merged with the other threads
+	for (unsigned int i = 15; i < 1015; ++i) {
+		Record(0, i);
+	}
+	Record(1, 1015);
+	const std::size_t aCount = FlightRecorder::Dump(FLIGHT_FILE, "test");
+	aDumped = ReadDump();
+	EVOLVE_CHECK_EQUAL(aDumped.size(), aCount);
+	EVOLVE_CHECK(aCount > 11 && aCount < 1011);
+	if (aDumped.size() > 10) {
+		//the messages of threads 1 and 2 first, then the end of thread 0, then the last one of thread 1
+		const unsigned int aOthers[] = { 1, 2, 4, 5, 7, 8, 10, 11, 13, 14 };
+		for (std::size_t i = 0; i < 10; ++i) {
+			EVOLVE_CHECK_EQUAL(aDumped[i], aOthers[i]);
+		}
+		for (std::size_t i = 11; i < aDumped.size(); ++i) {
+			EVOLVE_CHECK_EQUAL(aDumped[i], aDumped[i - 1] + 1);
+		}
+		EVOLVE_CHECK_EQUAL(aDumped.back(), 1015u);
+	}
+
+	//automatic dumps only write what a previous automatic dump did not
+	EVOLVE_CHECK(FlightRecorder::SetDumpFile(FLIGHT_FILE));
+	EVOLVE_CHECK_EQUAL(FlightRecorder::DumpAutomatic("first"), aCount);
+	Record(2, 1016);
+	Record(0, 1017);
+	EVOLVE_CHECK_EQUAL(FlightRecorder::DumpAutomatic("second"), 2u);
+	EVOLVE_CHECK_EQUAL(FlightRecorder::DumpAutomatic("third"), 0u);
+	EVOLVE_CHECK(FlightRecorder::SetDumpFile(NULL));
+	aDumped = ReadDump();
+	EVOLVE_CHECK_EQUAL(aDumped.size(), aCount + 2);
+	if (aDumped.size() == aCount + 2) {
+		EVOLVE_CHECK_EQUAL(aDumped[aCount], 1016u);
+		EVOLVE_CHECK_EQUAL(aDumped[aCount + 1], 1017u);
+	}
+
+	FlightRecorder::Disable();
+}
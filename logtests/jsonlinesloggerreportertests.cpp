@@ -0,0 +1,131 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file logtests/jsonlinesloggerreportertests.cpp
+ * \brief evolve_logtests, JSON lines output and string escaping
+ * \author
+ *
+ */
+
+#include "logtests.h"
+#include <evolve/log/jsonlinesloggerreporter.h>
+#include <evolve/utils/threadutils.h>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+using evolve::log::JsonLinesLoggerReporter;
+using evolve::log::LogMessage;
+
+static const char* JSON_FILE = "evolve_logtests.jsonl";
+
+//no registered thread, so no thread_name member
+static LogMessage Message(const char* iText) {
+	return TestMessage(iText, evolve::log::LEVEL_WARNING, EVOLVE_TEST_TIME, EVOLVE_THREAD_REGISTRY_SIZE);
+}
+
+static std::vector<std::string> WriteLines(const LogMessage* iMessages, std::size_t iCount) {
+	std::remove(JSON_FILE);
+	{
+		JsonLinesLoggerReporter aReporter(JSON_FILE);
+		aReporter.logBatch(iMessages, iCount);
+	}
+	std::vector<std::string> aLines;
+	std::ifstream aStream(JSON_FILE);
+	std::string aLine;
+	while (std::getline(aStream, aLine)) {
+		aLines.push_back(aLine);
+	}
+	std::remove(JSON_FILE);
+	return aLines;
+}
+
+//everything after the time string, which depends on the time zone
+static std::string Tail(const std::string& iLine) {
+	const std::size_t aPos = iLine.find(",\"time_ns\":");
+	return aPos != std::string::npos ? iLine.substr(aPos) : iLine;
+}
+
+void TestJsonLinesLoggerReporter() {
+	//one object per line, members in a fixed order
+	{
+		const LogMessage aMessage = Message("chunk loaded");
+		const std::vector<std::string> aLines = WriteLines(&aMessage, 1);
+		EVOLVE_CHECK_EQUAL(aLines.size(), 1u);
+		if (aLines.size() == 1) {
+			EVOLVE_CHECK(aLines[0].compare(0, 9, "{\"time\":\"") == 0);
+			EVOLVE_CHECK_EQUAL(Tail(aLines[0]), ",\"time_ns\":1500000000123456789,\"level\":\"WARNING\",\"thread\":256"
+				",\"file\":\"chunk.cpp\",\"line\":42,\"func\":\"load\",\"message\":\"chunk loaded\"}");
+		}
+	}
+
+	//quotes, backslashes and control characters are escaped, other bytes go through
+	{
+		const LogMessage aMessage = Message("say \"hi\"\\ \n\r\t\x01\x1f caf\xc3\xa9");
+		const std::vector<std::string> aLines = WriteLines(&aMessage, 1);
+		EVOLVE_CHECK_EQUAL(aLines.size(), 1u);
+		if (aLines.size() == 1) {
+			const std::string aExpected("\"message\":\"say \\\"hi\\\"\\\\ \\n\\r\\t\\u0001\\u001f caf\xc3\xa9\"}");
+			EVOLVE_CHECK(aLines[0].size() >= aExpected.size()
+				&& aLines[0].compare(aLines[0].size() - aExpected.size(), aExpected.size(), aExpected) == 0);
+		}
+	}
+
+	//missing source location is written as null
+	{
+		LogMessage aMessage = Message("no location");
+		aMessage._file = NULL;
+		aMessage._func = NULL;
+		const std::vector<std::string> aLines = WriteLines(&aMessage, 1);
+		EVOLVE_CHECK(aLines.size() == 1 && aLines[0].find(",\"file\":null,\"line\":42,\"func\":null,") != std::string::npos);
+	}
+
+	//fields go to a nested object with their JSON type, non finite numbers become null
+	{
+		LogMessage aMessage = Message("fields");
+		aMessage._fields.pack("count", -3, "size", 18446744073709551615ULL, "ratio", 0.5, "dirty", true,
+			"name", "a\"b", "nan", std::numeric_limits<double>::quiet_NaN(), "inf", std::numeric_limits<double>::infinity(),
+			"mark", 'x');
+		const std::vector<std::string> aLines = WriteLines(&aMessage, 1);
+		EVOLVE_CHECK_EQUAL(aLines.size(), 1u);
+		if (aLines.size() == 1) {
+			EVOLVE_CHECK_EQUAL(aLines[0].substr(aLines[0].find(",\"fields\":")),
+				",\"fields\":{\"count\":-3,\"size\":18446744073709551615,\"ratio\":0.5,\"dirty\":true,"
+				"\"name\":\"a\\\"b\",\"nan\":null,\"inf\":null,\"mark\":\"x\"}}");
+		}
+	}
+
+	//each message of a batch on its own line
+	{
+		const LogMessage aMessages[] = { Message("one"), Message("two\nlines"), Message("three") };
+		const std::vector<std::string> aLines = WriteLines(aMessages, 3);
+		EVOLVE_CHECK_EQUAL(aLines.size(), 3u);
+		if (aLines.size() == 3) {
+			EVOLVE_CHECK(aLines[1].find("\"message\":\"two\\nlines\"") != std::string::npos);
+			EVOLVE_CHECK(aLines[2].find("\"message\":\"three\"") != std::string::npos);
+		}
+	}
+}
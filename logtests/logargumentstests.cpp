@@ -0,0 +1,115 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file logtests/logargumentstests.cpp
+ * \brief evolve_logtests, deferred formatting arguments
+ * \author
+ *
+ */
+
+#include "logtests.h"
+#include <evolve/log/logarguments.h>
+#include <evolve/log/logtext.h>
+#include <string>
+
+using evolve::log::LogArgument;
+using evolve::log::LogArguments;
+using evolve::log::LogText;
+
+static std::string Format(const LogArguments& iArguments, const char* iFormat) {
+	LogText aText;
+	iArguments.format(iFormat, aText);
+	return aText.str();
+}
+
+void TestLogArguments() {
+	//every type renders like the streamed message would
+	{
+		LogArguments aArguments;
+		const std::string aName("chunk");
+		aArguments.pack(-12, 7u, 2.5, true, 'x', "text", aName, -3LL, 18446744073709551615ULL);
+		EVOLVE_CHECK_EQUAL(Format(aArguments, "{} {} {} {} {} {} {} {} {}"), "-12 7 2.5 true x text chunk -3 18446744073709551615");
+		EVOLVE_CHECK(!aArguments.isTruncated());
+	}
+
+	//literal text around placeholders, and a lone brace, are kept
+	{
+		LogArguments aArguments;
+		aArguments.pack(1, 2);
+		EVOLVE_CHECK_EQUAL(Format(aArguments, "a{}b{ c}{}d"), "a1b{ c}2d");
+		EVOLVE_CHECK_EQUAL(Format(aArguments, "no placeholder"), "no placeholder");
+		EVOLVE_CHECK_EQUAL(Format(aArguments, ""), "");
+	}
+
+	//more placeholders than arguments: the extra ones stay as they are
+	{
+		LogArguments aArguments;
+		aArguments.pack(1);
+		EVOLVE_CHECK_EQUAL(Format(aArguments, "{} {}"), "1 {}");
+	}
+
+	//arguments are decoded back with their type, in order
+	{
+		LogArguments aArguments;
+		aArguments.pack(static_cast<short>(-5), static_cast<unsigned char>(200), 1.5f, "ab");
+		std::size_t aOffset = 0;
+		LogArgument aArgument;
+		EVOLVE_CHECK(aArguments.read(aOffset, aArgument) && aArgument._type == evolve::log::ARGUMENT_INT && aArgument._int == -5);
+		EVOLVE_CHECK(aArguments.read(aOffset, aArgument) && aArgument._type == evolve::log::ARGUMENT_UINT && aArgument._uint == 200);
+		EVOLVE_CHECK(aArguments.read(aOffset, aArgument) && aArgument._type == evolve::log::ARGUMENT_DOUBLE && aArgument._double == 1.5);
+		EVOLVE_CHECK(aArguments.read(aOffset, aArgument) && aArgument._type == evolve::log::ARGUMENT_STRING
+			&& std::string(aArgument._string, aArgument._length) == "ab");
+		EVOLVE_CHECK(!aArguments.read(aOffset, aArgument));
+	}
+
+	//the strings are copied, the caller's buffer may change right after the call
+	{
+		char aBuffer[] = "before";
+		LogArguments aArguments;
+		aArguments.pack(aBuffer);
+		aBuffer[0] = 'X';
+		EVOLVE_CHECK_EQUAL(Format(aArguments, "{}"), "before");
+	}
+
+	//arguments past the inline buffer are dropped and rendered as "..."
+	{
+		const std::string aLong(100, 'a');
+		LogArguments aArguments;
+		aArguments.pack(aLong, aLong, 42);
+		EVOLVE_CHECK(aArguments.isTruncated());
+		const std::string aText = Format(aArguments, "{}|{}|{}");
+		EVOLVE_CHECK(aText.compare(0, 101, aLong + "|") == 0);
+		EVOLVE_CHECK(aText.size() >= 3 && aText.compare(aText.size() - 3, 3, "...") == 0);
+	}
+
+	//clear() makes the record reusable
+	{
+		LogArguments aArguments;
+		aArguments.pack(std::string(200, 'b'), std::string(200, 'c'));
+		aArguments.clear();
+		EVOLVE_CHECK(!aArguments.isTruncated());
+		aArguments.pack(3);
+		EVOLVE_CHECK_EQUAL(Format(aArguments, "{}"), "3");
+	}
+}
@@ -0,0 +1,127 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file logtests/logfieldstests.cpp
+ * \brief evolve_logtests, typed key/value fields of structured messages
+ * \author
+ *
+ */
+
+#include "logtests.h"
+#include <evolve/log/logfields.h>
+#include <string>
+
+using evolve::log::LogField;
+using evolve::log::LogFields;
+
+void TestLogFields() {
+	//an empty record has no field to read
+	{
+		LogFields aFields;
+		EVOLVE_CHECK(aFields.empty());
+		EVOLVE_CHECK_EQUAL(aFields.size(), 0u);
+		std::size_t aIndex = 0;
+		std::size_t aOffset = 0;
+		LogField aField;
+		EVOLVE_CHECK(!aFields.read(aIndex, aOffset, aField));
+	}
+
+	//keys are kept by pointer, values keep their type, fields come back in order
+	{
+		static const char* KEY_CHUNK = "chunk";
+		LogFields aFields;
+		aFields.pack(KEY_CHUNK, 12, "size", 4096ULL, "ratio", 0.25, "dirty", false, "name", std::string("terrain"));
+		aFields.add("offset", -8LL);
+		EVOLVE_CHECK_EQUAL(aFields.size(), 6u);
+
+		std::size_t aIndex = 0;
+		std::size_t aOffset = 0;
+		LogField aField;
+		EVOLVE_CHECK(aFields.read(aIndex, aOffset, aField) && aField._key == KEY_CHUNK
+			&& aField._value._type == evolve::log::ARGUMENT_INT && aField._value._int == 12);
+		EVOLVE_CHECK(aFields.read(aIndex, aOffset, aField) && std::string(aField._key) == "size"
+			&& aField._value._type == evolve::log::ARGUMENT_UINT && aField._value._uint == 4096);
+		EVOLVE_CHECK(aFields.read(aIndex, aOffset, aField) && std::string(aField._key) == "ratio"
+			&& aField._value._type == evolve::log::ARGUMENT_DOUBLE && aField._value._double == 0.25);
+		EVOLVE_CHECK(aFields.read(aIndex, aOffset, aField) && std::string(aField._key) == "dirty"
+			&& aField._value._type == evolve::log::ARGUMENT_BOOL && !aField._value._bool);
+		EVOLVE_CHECK(aFields.read(aIndex, aOffset, aField) && std::string(aField._key) == "name"
+			&& aField._value._type == evolve::log::ARGUMENT_STRING
+			&& std::string(aField._value._string, aField._value._length) == "terrain");
+		EVOLVE_CHECK(aFields.read(aIndex, aOffset, aField) && std::string(aField._key) == "offset"
+			&& aField._value._type == evolve::log::ARGUMENT_INT && aField._value._int == -8);
+		EVOLVE_CHECK(!aFields.read(aIndex, aOffset, aField));
+	}
+
+	//fields past EVOLVE_LOG_FIELDS_COUNT are dropped, the others are kept
+	{
+		LogFields aFields;
+		for (int i = 0; i < EVOLVE_LOG_FIELDS_COUNT + 3; ++i) {
+			aFields.add("index", i);
+		}
+		EVOLVE_CHECK_EQUAL(aFields.size(), static_cast<std::size_t>(EVOLVE_LOG_FIELDS_COUNT));
+
+		std::size_t aIndex = 0;
+		std::size_t aOffset = 0;
+		LogField aField;
+		int aExpected = 0;
+		while (aFields.read(aIndex, aOffset, aField)) {
+			EVOLVE_CHECK_EQUAL(aField._value._int, aExpected);
+			++aExpected;
+		}
+		EVOLVE_CHECK_EQUAL(aExpected, EVOLVE_LOG_FIELDS_COUNT);
+	}
+
+	//a long string is cut to the room left, a value with no room left drops its key too
+	{
+		LogFields aFields;
+		aFields.add("small", 1);
+		aFields.add("huge", std::string(4096, 'h'));
+		aFields.add("after", 2);
+		EVOLVE_CHECK_EQUAL(aFields.size(), 2u);
+
+		std::size_t aIndex = 0;
+		std::size_t aOffset = 0;
+		LogField aField;
+		EVOLVE_CHECK(aFields.read(aIndex, aOffset, aField) && std::string(aField._key) == "small" && aField._value._int == 1);
+		EVOLVE_CHECK(aFields.read(aIndex, aOffset, aField) && std::string(aField._key) == "huge"
+			&& aField._value._type == evolve::log::ARGUMENT_STRING && aField._value._length > 0
+			&& std::string(aField._value._string, aField._value._length) == std::string(aField._value._length, 'h'));
+		EVOLVE_CHECK(!aFields.read(aIndex, aOffset, aField));
+	}
+
+	//clear() makes the record reusable
+	{
+		LogFields aFields;
+		aFields.pack("a", 1, "b", 2);
+		aFields.clear();
+		EVOLVE_CHECK(aFields.empty());
+		aFields.add("c", 3);
+		std::size_t aIndex = 0;
+		std::size_t aOffset = 0;
+		LogField aField;
+		EVOLVE_CHECK(aFields.read(aIndex, aOffset, aField) && std::string(aField._key) == "c" && aField._value._int == 3);
+		EVOLVE_CHECK(!aFields.read(aIndex, aOffset, aField));
+	}
+}
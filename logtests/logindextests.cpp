@@ -0,0 +1,209 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file logtests/logindextests.cpp
+ * \brief evolve_logtests, sidecar index of log files
+ * \author
+ *
+ */
+
+#include "logtests.h"
+#include <evolve/log/logindex.h>
+#include <evolve/log/loggerreporter.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using evolve::log::FileFlushPolicy;
+using evolve::log::FileLoggerReporter;
+using evolve::log::LogIndexEntry;
+using evolve::log::LogIndexWriter;
+using evolve::log::LogMessage;
+
+static const char* INDEXED_FILE = "evolve_logtests.log";
+
+static LogIndexEntry Entry(unsigned long long iOffset, unsigned long long iSize) {
+	LogIndexEntry aEntry;
+	aEntry.reset(iOffset);
+	aEntry.add(TestMessage("chunk loaded", evolve::log::LEVEL_INFO, 1000 + iOffset, 1));
+	aEntry._size = iSize;
+	return aEntry;
+}
+
+static void RemoveFiles() {
+	std::remove(INDEXED_FILE);
+	std::remove((std::string(INDEXED_FILE) + EVOLVE_LOG_INDEX_EXTENSION).c_str());
+}
+
+static std::size_t FileSize(const std::string& iPath) {
+	std::ifstream aStream(iPath.c_str(), std::ifstream::in | std::ifstream::binary | std::ifstream::ate);
+	return aStream.is_open() ? static_cast<std::size_t>(aStream.tellg()) : 0;
+}
+
+void TestLogIndex() {
+	RemoveFiles();
+
+	//an entry keeps the level counts, the thread bitmap and the true time range
+	{
+		LogIndexEntry aEntry;
+		aEntry.reset(128);
+		EVOLVE_CHECK_EQUAL(aEntry._offset, 128u);
+		EVOLVE_CHECK_EQUAL(aEntry.getCount(), 0u);
+		EVOLVE_CHECK(!aEntry.hasLevel(evolve::log::LEVEL_DEBUG));
+
+		aEntry.add(TestMessage("chunk loaded", evolve::log::LEVEL_INFO, 500, 3));
+		aEntry.add(TestMessage("chunk loaded", evolve::log::LEVEL_WARNING, 300, 70));
+		aEntry.add(TestMessage("chunk loaded", evolve::log::LEVEL_INFO, 900, 3));
+		EVOLVE_CHECK_EQUAL(aEntry.getCount(), 3u);
+		EVOLVE_CHECK_EQUAL(aEntry._firstTime, 300u);
+		EVOLVE_CHECK_EQUAL(aEntry._lastTime, 900u);
+		EVOLVE_CHECK(aEntry.hasLevel(evolve::log::LEVEL_DEBUG));
+		EVOLVE_CHECK(aEntry.hasLevel(evolve::log::LEVEL_WARNING));
+		EVOLVE_CHECK(!aEntry.hasLevel(evolve::log::LEVEL_ERROR));
+		EVOLVE_CHECK(aEntry.hasThread(3) && aEntry.hasThread(70));
+		EVOLVE_CHECK(!aEntry.hasThread(4));
+		//thread indexes wrap around the bitmap, a false positive is allowed, a false negative is not
+		EVOLVE_CHECK(aEntry.hasThread(3 + EVOLVE_LOG_INDEX_THREAD_BITS));
+
+		aEntry.reset(512);
+		EVOLVE_CHECK_EQUAL(aEntry._offset, 512u);
+		EVOLVE_CHECK_EQUAL(aEntry.getCount(), 0u);
+		EVOLVE_CHECK(!aEntry.hasThread(3));
+	}
+
+	//no index, no entry
+	{
+		std::vector<LogIndexEntry> aEntries(1);
+		EVOLVE_CHECK(!evolve::log::ReadLogIndex(INDEXED_FILE, aEntries));
+		EVOLVE_CHECK(aEntries.empty());
+	}
+
+	//entries are read back in file order, reopening appends to them
+	{
+		LogIndexWriter aWriter;
+		EVOLVE_CHECK(aWriter.open(INDEXED_FILE, 0));
+		std::vector<LogIndexEntry> aEntries;
+		aEntries.push_back(Entry(0, 100));
+		aEntries.push_back(Entry(100, 50));
+		aWriter.write(aEntries);
+		aWriter.close();
+
+		EVOLVE_CHECK(aWriter.open(INDEXED_FILE, 150));
+		aEntries.assign(1, Entry(150, 10));
+		aWriter.write(aEntries);
+		aWriter.close();
+
+		EVOLVE_CHECK(evolve::log::ReadLogIndex(INDEXED_FILE, aEntries));
+		EVOLVE_CHECK_EQUAL(aEntries.size(), 3u);
+		if (aEntries.size() == 3) {
+			EVOLVE_CHECK(aEntries[0]._offset == 0 && aEntries[0]._size == 100 && aEntries[0]._firstTime == 1000);
+			EVOLVE_CHECK(aEntries[1]._offset == 100 && aEntries[1]._size == 50 && aEntries[1]._firstTime == 1100);
+			EVOLVE_CHECK(aEntries[2]._offset == 150 && aEntries[2]._size == 10);
+		}
+	}
+
+	//a log file shorter than the index says was replaced: the entries past its end are dropped
+	{
+		LogIndexWriter aWriter;
+		EVOLVE_CHECK(aWriter.open(INDEXED_FILE, 120));
+		aWriter.close();
+		std::vector<LogIndexEntry> aEntries;
+		EVOLVE_CHECK(evolve::log::ReadLogIndex(INDEXED_FILE, aEntries));
+		EVOLVE_CHECK_EQUAL(aEntries.size(), 1u);
+	}
+
+	//a truncated last entry, from a crash during its write, is ignored
+	{
+		const std::string aPath = std::string(INDEXED_FILE) + EVOLVE_LOG_INDEX_EXTENSION;
+		{
+			std::ofstream aStream(aPath.c_str(), std::ofstream::out | std::ofstream::app | std::ofstream::binary);
+			aStream.write("partial", 7);
+		}
+		std::vector<LogIndexEntry> aEntries;
+		EVOLVE_CHECK(evolve::log::ReadLogIndex(INDEXED_FILE, aEntries));
+		EVOLVE_CHECK_EQUAL(aEntries.size(), 1u);
+
+		//and the writer starts over from the valid entries instead of appending after the garbage
+		LogIndexWriter aWriter;
+		EVOLVE_CHECK(aWriter.open(INDEXED_FILE, 100));
+		aEntries.assign(1, Entry(100, 20));
+		aWriter.write(aEntries);
+		aWriter.close();
+		EVOLVE_CHECK(evolve::log::ReadLogIndex(INDEXED_FILE, aEntries));
+		EVOLVE_CHECK(aEntries.size() == 2 && aEntries[1]._offset == 100);
+	}
+
+	//a file of another format is not an index
+	{
+		const std::string aPath = std::string(INDEXED_FILE) + EVOLVE_LOG_INDEX_EXTENSION;
+		{
+			std::ofstream aStream(aPath.c_str(), std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+			aStream << "EVLOGBIN not an index at all";
+		}
+		std::vector<LogIndexEntry> aEntries;
+		EVOLVE_CHECK(!evolve::log::ReadLogIndex(INDEXED_FILE, aEntries));
+	}
+
+	RemoveFiles();
+
+	//a file reporter cuts contiguous blocks covering the whole file, between messages
+	{
+		const unsigned int aCount = 200;
+		{
+			FileLoggerReporter aReporter(INDEXED_FILE, FileFlushPolicy::Buffered(512, 0, evolve::log::LEVEL_OFF).withIndex(1024));
+			for (unsigned int i = 0; i < aCount; ++i) {
+				aReporter.log(TestMessage("chunk loaded", i % 10 == 0 ? evolve::log::LEVEL_ERROR : evolve::log::LEVEL_INFO, 1000 + i, i % 4));
+			}
+		}
+
+		std::vector<LogIndexEntry> aEntries;
+		EVOLVE_CHECK(evolve::log::ReadLogIndex(INDEXED_FILE, aEntries));
+		EVOLVE_CHECK(aEntries.size() > 1);
+		unsigned long long aEnd = 0;
+		unsigned long long aMessages = 0;
+		unsigned long long aErrors = 0;
+		for (std::size_t i = 0; i < aEntries.size(); ++i) {
+			EVOLVE_CHECK_EQUAL(aEntries[i]._offset, aEnd);
+			EVOLVE_CHECK(aEntries[i]._firstTime <= aEntries[i]._lastTime);
+			aEnd = aEntries[i]._offset + aEntries[i]._size;
+			aMessages += aEntries[i].getCount();
+			aErrors += aEntries[i]._levels[evolve::log::LEVEL_ERROR];
+		}
+		EVOLVE_CHECK_EQUAL(aEnd, FileSize(INDEXED_FILE));
+		EVOLVE_CHECK_EQUAL(aMessages, aCount);
+		EVOLVE_CHECK_EQUAL(aErrors, aCount / 10);
+
+		//each block starts on a line
+		std::ifstream aStream(INDEXED_FILE, std::ifstream::in | std::ifstream::binary);
+		for (std::size_t i = 1; i < aEntries.size(); ++i) {
+			char aPrevious = '\0';
+			aStream.seekg(static_cast<std::streamoff>(aEntries[i]._offset - 1));
+			aStream.get(aPrevious);
+			EVOLVE_CHECK_EQUAL(aPrevious, '\n');
+		}
+	}
+
+	RemoveFiles();
+}
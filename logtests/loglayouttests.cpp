@@ -0,0 +1,194 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file logtests/loglayouttests.cpp
+ * \brief evolve_logtests, pattern based line formatting
+ * \author
+ *
+ */
+
+#include "logtests.h"
+#include <evolve/log/loglayout.h>
+#include <evolve/log/binaryfileloggerreporter.h>
+#include <evolve/utils/threadutils.h>
+#include <string>
+#include <thread>
+
+using evolve::log::LogLayout;
+using evolve::log::LogMessage;
+
+//thread names are looked up in the registry, the hashed id is given
+static std::string Format(const char* iPattern, const LogMessage& iMessage, unsigned int iFractionDigits = 3) {
+	LogLayout aLayout(iPattern, iFractionDigits);
+	std::string aLine;
+	aLayout.append(iMessage, 255, aLine);
+	return aLine;
+}
+
+void TestLogLayout() {
+	//the default pattern reproduces the historical layout
+	{
+		const std::string aLine = Format(EVOLVE_LOG_DEFAULT_PATTERN, TestMessage());
+		EVOLVE_CHECK_EQUAL(aLine, "[2017-07-14 02:40:00.123 | Thread: 7   (0000000000000255) | " + std::string(33, ' ') + "chunk.cpp#  42 > "
+			+ std::string(46, ' ') + "load |    ERROR] chunk lost");
+	}
+
+	//a NULL pattern is the default one
+	{
+		EVOLVE_CHECK_EQUAL(Format(NULL, TestMessage()), Format(EVOLVE_LOG_DEFAULT_PATTERN, TestMessage()));
+	}
+
+	//width, left alignment and zero padding
+	{
+		EVOLVE_CHECK_EQUAL(Format("%l|%6l|%-6l|%06l|%2l", TestMessage()), "42|    42|42    |000042|42");
+		EVOLVE_CHECK_EQUAL(Format("%-8L|%8L|%3L", TestMessage()), "ERROR   |   ERROR|ERROR");
+	}
+
+	//%% and unknown or unfinished conversions are copied as is
+	{
+		EVOLVE_CHECK_EQUAL(Format("100%% %q %5z %m%", TestMessage()), "100% %q %5z chunk lost%");
+		EVOLVE_CHECK_EQUAL(Format("", TestMessage()), "");
+	}
+
+	//time with the requested fraction digits
+	{
+		EVOLVE_CHECK_EQUAL(Format("%T", TestMessage(), 0), "2017-07-14 02:40:00");
+		EVOLVE_CHECK_EQUAL(Format("%T", TestMessage(), 6), "2017-07-14 02:40:00.123456");
+		EVOLVE_CHECK_EQUAL(Format("%T", TestMessage(), 9), "2017-07-14 02:40:00.123456789");
+	}
+
+	//missing file and function are written empty
+	{
+		LogMessage aMessage = TestMessage();
+		aMessage._file = NULL;
+		aMessage._func = NULL;
+		EVOLVE_CHECK_EQUAL(Format("<%f|%F|%3F>", aMessage), "<||   >");
+	}
+
+	//fields as " key=value" each, nothing without fields
+	{
+		LogMessage aMessage = TestMessage();
+		EVOLVE_CHECK_EQUAL(Format("%m%k", aMessage), "chunk lost");
+		aMessage._fields.pack("id", -4, "size", 16u, "ratio", 0.5, "dirty", true, "name", "terrain", "mark", 'x');
+		EVOLVE_CHECK_EQUAL(Format("%m%k", aMessage), "chunk lost id=-4 size=16 ratio=0.5 dirty=true name=terrain mark=x");
+	}
+
+	//%t is the thread name once set, its index otherwise; decoded messages never look names up
+	{
+		std::string aNamed;
+		std::string aDecoded;
+		unsigned int aIndex = 0;
+		std::thread aThread([&aNamed, &aDecoded, &aIndex]() {
+			evolve::utils::SetCurrentThreadName("evolve.tests");
+			LogMessage aMessage = TestMessage();
+			aIndex = aMessage._threadIndex = evolve::utils::GetCurrentThreadIndex();
+			LogLayout aLayout("%t|%n|%i");
+			aLayout.format(aMessage, aNamed);
+			aLayout.append(aMessage, 0, aDecoded);
+		});
+		aThread.join();
+		const std::string aIndexText = std::to_string(aIndex);
+		EVOLVE_CHECK_EQUAL(aNamed, "evolve.tests|evolve.tests|" + aIndexText);
+		EVOLVE_CHECK_EQUAL(aDecoded, aIndexText + "||" + aIndexText);
+	}
+
+	//registered channels by name, the default one empty
+	{
+		LogMessage aMessage = TestMessage();
+		EVOLVE_CHECK_EQUAL(Format("<%c>", aMessage), "<>");
+		aMessage._channel = evolve::log::Logger::RegisterChannel("tests.layout");
+		LogLayout aLayout("<%c>");
+		std::string aLine;
+		aLayout.format(aMessage, aLine);
+		EVOLVE_CHECK_EQUAL(aLine, "<tests.layout>");
+	}
+
+	//format() replaces the line, append() adds to it
+	{
+		LogLayout aLayout("%m");
+		std::string aLine("old");
+		aLayout.format(TestMessage(), aLine);
+		EVOLVE_CHECK_EQUAL(aLine, "chunk lost");
+		aLayout.append(TestMessage(), aLine);
+		EVOLVE_CHECK_EQUAL(aLine, "chunk lostchunk lost");
+	}
+
+	//records read back format like the message they were written from, without name lookups
+	{
+		evolve::log::BinaryLogRecord aRecord;
+		aRecord._time = EVOLVE_TEST_TIME;
+		aRecord._level = evolve::log::LEVEL_ERROR;
+		aRecord._file = "chunk.cpp";
+		aRecord._func = "load";
+		aRecord._line = 42;
+		aRecord._threadIndex = 7;
+		aRecord._threadId = 255;
+		aRecord._message = "chunk lost";
+		LogLayout aLayout;
+		std::string aLine;
+		aLayout.append(aRecord, aLine);
+		EVOLVE_CHECK_EQUAL(aLine, Format(EVOLVE_LOG_DEFAULT_PATTERN, TestMessage()));
+	}
+
+	//%T parses back, command line times may also be seconds since epoch
+	{
+		unsigned long long aTime = 0;
+		EVOLVE_CHECK(evolve::utils::Clock::Parse("2017-07-14 02:40:00.123", aTime));
+		EVOLVE_CHECK_EQUAL(aTime, 1500000000123000000ULL);
+		EVOLVE_CHECK(evolve::utils::Clock::Parse("2017-7-14T02:40:00", aTime));
+		EVOLVE_CHECK_EQUAL(aTime, 1500000000000000000ULL);
+		EVOLVE_CHECK(evolve::utils::Clock::Parse("1500000000.5", aTime));
+		EVOLVE_CHECK_EQUAL(aTime, 1500000000500000000ULL);
+		EVOLVE_CHECK(!evolve::utils::Clock::Parse("2017-07-14 02:40", aTime));
+		EVOLVE_CHECK(!evolve::utils::Clock::Parse("2017-07-14 02:40:00.", aTime));
+		EVOLVE_CHECK(!evolve::utils::Clock::Parse("yesterday", aTime));
+	}
+
+	//lines read back: time to the formatted digits, level, thread index or name, continuation lines refused
+	{
+		LogLayout aLayout;
+		const std::string aLine = Format(EVOLVE_LOG_DEFAULT_PATTERN, TestMessage());
+		evolve::log::LogLineHeader aHeader;
+		EVOLVE_CHECK(aLayout.parse(aLine.data(), aLine.size(), aHeader));
+		EVOLVE_CHECK(aHeader._hasTime && aHeader._hasLevel && aHeader._hasThread);
+		EVOLVE_CHECK_EQUAL(aHeader._time, 1500000000123000000ULL);
+		EVOLVE_CHECK_EQUAL(aHeader._level, evolve::log::LEVEL_ERROR);
+		EVOLVE_CHECK_EQUAL(aHeader._threadIndex, 7ULL);
+		EVOLVE_CHECK(!aLayout.parse("second line", 11, aHeader));
+
+		const std::string aNamed = "[2017-07-14 02:40:00.123 | Thread: evolve.sink (0000000000000255) | chunk.cpp#  42 > load |     INFO] a | b";
+		EVOLVE_CHECK(aLayout.parse(aNamed.data(), aNamed.size(), aHeader));
+		EVOLVE_CHECK(!aHeader._hasThread);
+		EVOLVE_CHECK_EQUAL(aHeader._threadName, "evolve.sink");
+		EVOLVE_CHECK_EQUAL(aHeader._level, evolve::log::LEVEL_INFO);
+
+		//reading stops at the message, and at conversions which can't be told apart
+		LogLayout aTail("%m [%L]");
+		EVOLVE_CHECK(aTail.parse("x [DEBUG]", 9, aHeader));
+		EVOLVE_CHECK(!aHeader._hasLevel);
+		LogLayout aGlued("%i%L");
+		EVOLVE_CHECK(aGlued.parse("7ERROR", 6, aHeader));
+		EVOLVE_CHECK(!aHeader._hasThread && !aHeader._hasLevel);
+	}
+}
@@ -0,0 +1,130 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file logtests/logsamplertests.cpp
+ * \brief evolve_logtests, per call site sampling
+ * \author
+ *
+ */
+
+#include "logtests.h"
+#include <evolve/log/logsampler.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using evolve::log::LogSampler;
+
+static const unsigned int THREAD_COUNT = 4;
+
+void TestLogSampler() {
+	//everyN keeps the first occurrence then one out of n, with the skipped count
+	{
+		LogSampler aSampler;
+		std::vector<unsigned int> aSampled;
+		std::vector<unsigned long long> aSkipped;
+		for (unsigned int i = 0; i < 12; ++i) {
+			unsigned long long aCount = 99;
+			if (aSampler.everyN(4, aCount)) {
+				aSampled.push_back(i);
+				aSkipped.push_back(aCount);
+			}
+		}
+		EVOLVE_CHECK_EQUAL(aSampled.size(), 3u);
+		if (aSampled.size() == 3) {
+			EVOLVE_CHECK(aSampled[0] == 0 && aSampled[1] == 4 && aSampled[2] == 8);
+			EVOLVE_CHECK(aSkipped[0] == 0 && aSkipped[1] == 3 && aSkipped[2] == 3);
+		}
+	}
+
+	//everyN with 0 or 1 keeps everything
+	{
+		LogSampler aZero;
+		LogSampler aOne;
+		unsigned int aKept = 0;
+		for (unsigned int i = 0; i < 10; ++i) {
+			unsigned long long aSkipped = 99;
+			aKept += aZero.everyN(0, aSkipped) && aSkipped == 0 ? 1 : 0;
+			aKept += aOne.everyN(1, aSkipped) && aSkipped == 0 ? 1 : 0;
+		}
+		EVOLVE_CHECK_EQUAL(aKept, 20u);
+	}
+
+	//firstN keeps the first n occurrences, even between threads
+	{
+		LogSampler aSampler;
+		unsigned int aKept = 0;
+		for (unsigned int i = 0; i < 10; ++i) {
+			aKept += aSampler.firstN(3) ? 1 : 0;
+		}
+		EVOLVE_CHECK_EQUAL(aKept, 3u);
+		EVOLVE_CHECK(!aSampler.firstN(0));
+
+		LogSampler aShared;
+		std::atomic<unsigned int> aSharedKept(0);
+		std::vector<std::thread> aThreads;
+		for (unsigned int t = 0; t < THREAD_COUNT; ++t) {
+			aThreads.push_back(std::thread([&aShared, &aSharedKept]() {
+				for (unsigned int i = 0; i < 10000; ++i) {
+					if (aShared.firstN(100)) {
+						++aSharedKept;
+					}
+				}
+			}));
+		}
+		for (std::size_t t = 0; t < aThreads.size(); ++t) {
+			aThreads[t].join();
+		}
+		EVOLVE_CHECK_EQUAL(aSharedKept.load(), 100u);
+	}
+
+	//everyMs keeps one occurrence per interval, the next one carries the skipped count
+	{
+		LogSampler aSampler;
+		unsigned long long aSkipped = 99;
+		EVOLVE_CHECK(aSampler.everyMs(20, aSkipped));
+		EVOLVE_CHECK_EQUAL(aSkipped, 0u);
+		unsigned int aKept = 0;
+		for (unsigned int i = 0; i < 5; ++i) {
+			aKept += aSampler.everyMs(20, aSkipped) ? 1 : 0;
+		}
+		EVOLVE_CHECK_EQUAL(aKept, 0u);
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(60));
+		EVOLVE_CHECK(aSampler.everyMs(20, aSkipped));
+		EVOLVE_CHECK_EQUAL(aSkipped, 5u);
+	}
+
+	//everyMs with no interval keeps everything
+	{
+		LogSampler aSampler;
+		unsigned int aKept = 0;
+		for (unsigned int i = 0; i < 10; ++i) {
+			unsigned long long aSkipped = 99;
+			aKept += aSampler.everyMs(0, aSkipped) && aSkipped == 0 ? 1 : 0;
+		}
+		EVOLVE_CHECK_EQUAL(aKept, 10u);
+	}
+}
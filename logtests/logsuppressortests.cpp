@@ -0,0 +1,185 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file logtests/logsuppressortests.cpp
+ * \brief evolve_logtests, duplicate message suppression and rate limiting
+ * \author
+ *
+ */
+
+#include "logtests.h"
+#include <evolve/log/logsuppressor.h>
+#include <evolve/utils/clock.h>
+#include <string>
+#include <vector>
+
+using evolve::log::LogMessage;
+using evolve::log::LogSuppressor;
+
+static const unsigned long long SECOND = 1000000000ULL;
+
+static const char* SUMMARY_FILE = "chunk.cpp";
+static const char* SUMMARY_FUNCTION = "load";
+
+//admit iCount occurrences labelled "chunk <id> lost"
+static unsigned long long Repeat(LogSuppressor& ioSuppressor, unsigned long long iId, unsigned long long iCallSite, unsigned int iCount,
+	unsigned int& oAdmitted) {
+	const std::string aLabel = "chunk " + std::to_string(iId) + " lost";
+	unsigned long long aSuppressed = 0;
+	oAdmitted = 0;
+	for (unsigned int i = 0; i < iCount; ++i) {
+		if (ioSuppressor.admit(iId, iCallSite, aSuppressed, evolve::log::LEVEL_WARNING, SUMMARY_FILE, 42, SUMMARY_FUNCTION, aLabel.c_str())) {
+			++oAdmitted;
+		}
+	}
+	return aSuppressed;
+}
+
+void TestLogSuppressor() {
+	//drop what earlier checks may have left behind
+	{
+		std::vector<LogMessage> aMessages;
+		LogSuppressor::Expire(evolve::utils::Clock::Now(true), true, aMessages);
+	}
+
+	//within the window only the first occurrence is logged, the others are counted
+	{
+		LogSuppressor aSuppressor(60000, 10, 0);
+		unsigned int aAdmitted = 0;
+		Repeat(aSuppressor, 1, 100, 50, aAdmitted);
+		EVOLVE_CHECK_EQUAL(aAdmitted, 1u);
+
+		//still in the window: the count waits for the next logged occurrence
+		std::vector<LogMessage> aMessages;
+		LogSuppressor::Expire(evolve::utils::Clock::Now(true), false, aMessages);
+		EVOLVE_CHECK(aMessages.empty());
+
+		//window over with no new occurrence: the logger thread reports the count at the call site
+		LogSuppressor::Expire(evolve::utils::Clock::Now(true) + 61 * SECOND, false, aMessages);
+		EVOLVE_CHECK_EQUAL(aMessages.size(), 1u);
+		if (aMessages.size() == 1) {
+			EVOLVE_CHECK_EQUAL(aMessages[0]._message.str(), "last message repeated 49 times: chunk 1 lost");
+			EVOLVE_CHECK(aMessages[0]._level == evolve::log::LEVEL_WARNING);
+			EVOLVE_CHECK(aMessages[0]._file == SUMMARY_FILE);
+			EVOLVE_CHECK_EQUAL(aMessages[0]._line, 42u);
+			EVOLVE_CHECK(aMessages[0]._func == SUMMARY_FUNCTION);
+		}
+
+		//a count is reported only once
+		aMessages.clear();
+		LogSuppressor::Expire(evolve::utils::Clock::Now(true) + 120 * SECOND, true, aMessages);
+		EVOLVE_CHECK(aMessages.empty());
+	}
+
+	//keys are (message id, call site) pairs, each one has its own window
+	{
+		LogSuppressor aSuppressor(60000, 10, 0);
+		unsigned int aAdmitted = 0;
+		Repeat(aSuppressor, 1, 100, 3, aAdmitted);
+		EVOLVE_CHECK_EQUAL(aAdmitted, 1u);
+		Repeat(aSuppressor, 2, 100, 3, aAdmitted);
+		EVOLVE_CHECK_EQUAL(aAdmitted, 1u);
+		Repeat(aSuppressor, 1, 200, 3, aAdmitted);
+		EVOLVE_CHECK_EQUAL(aAdmitted, 1u);
+
+		//closing reports every pending count, in or out of the window, labelled by key
+		std::vector<LogMessage> aMessages;
+		LogSuppressor::Expire(evolve::utils::Clock::Now(true), true, aMessages);
+		EVOLVE_CHECK_EQUAL(aMessages.size(), 3u);
+		unsigned int aFirst = 0;
+		unsigned int aSecond = 0;
+		for (std::size_t i = 0; i < aMessages.size(); ++i) {
+			aFirst += aMessages[i]._message.str() == "last message repeated 2 times: chunk 1 lost" ? 1 : 0;
+			aSecond += aMessages[i]._message.str() == "last message repeated 2 times: chunk 2 lost" ? 1 : 0;
+		}
+		EVOLVE_CHECK_EQUAL(aFirst, 2u);
+		EVOLVE_CHECK_EQUAL(aSecond, 1u);
+	}
+
+	//labels given once admitted, as EVOLVE_LOG_SUPPRESSED does, are kept to the first line and cut when too long
+	{
+		LogSuppressor aSuppressor(60000, 10, 0);
+		unsigned long long aSuppressed = 0;
+		EVOLVE_CHECK(aSuppressor.admit(5, 100, aSuppressed));
+		aSuppressor.label(5, 100, "first\nsecond", 12);
+		aSuppressor.label(5, 100, "later", 5);
+		EVOLVE_CHECK(!aSuppressor.admit(5, 100, aSuppressed));
+		EVOLVE_CHECK(aSuppressor.admit(6, 100, aSuppressed));
+		const std::string aLong(200, 'x');
+		aSuppressor.label(6, 100, aLong.data(), aLong.size());
+		EVOLVE_CHECK(!aSuppressor.admit(6, 100, aSuppressed));
+		EVOLVE_CHECK(aSuppressor.admit(8, 100, aSuppressed));
+		EVOLVE_CHECK(!aSuppressor.admit(8, 100, aSuppressed));
+
+		std::vector<LogMessage> aMessages;
+		LogSuppressor::Expire(evolve::utils::Clock::Now(true), true, aMessages);
+		EVOLVE_CHECK_EQUAL(aMessages.size(), 3u);
+		unsigned int aLabelled = 0;
+		for (std::size_t i = 0; i < aMessages.size(); ++i) {
+			const std::string aText = aMessages[i]._message.str();
+			aLabelled += aText == "last message repeated 1 times: first..." ? 1 : 0;
+			aLabelled += aText == "last message repeated 1 times: " + std::string(EVOLVE_LOG_SUPPRESSOR_LABEL_SIZE - 4, 'x') + "..." ? 1 : 0;
+			aLabelled += aText == "last message repeated 1 times" ? 1 : 0;
+		}
+		EVOLVE_CHECK_EQUAL(aLabelled, 3u);
+	}
+
+	//without a window, the token bucket limits the rate: the burst goes through, then the rest is counted
+	{
+		LogSuppressor aSuppressor(0, 1, 5);
+		unsigned int aAdmitted = 0;
+		Repeat(aSuppressor, 7, 100, 20, aAdmitted);
+		EVOLVE_CHECK_EQUAL(aAdmitted, 5u);
+
+		std::vector<LogMessage> aMessages;
+		LogSuppressor::Expire(evolve::utils::Clock::Now(true), true, aMessages);
+		EVOLVE_CHECK_EQUAL(aMessages.size(), 1u);
+		if (aMessages.size() == 1) {
+			EVOLVE_CHECK_EQUAL(aMessages[0]._message.str(), "last message repeated 15 times: chunk 7 lost");
+		}
+	}
+
+	//both disabled: everything is logged
+	{
+		LogSuppressor aSuppressor(0, 0, 0);
+		unsigned int aAdmitted = 0;
+		EVOLVE_CHECK_EQUAL(Repeat(aSuppressor, 3, 100, 10, aAdmitted), 0u);
+		EVOLVE_CHECK_EQUAL(aAdmitted, 10u);
+	}
+
+	//a suppressor destroyed with pending counts leaves them to the next expiry
+	{
+		{
+			LogSuppressor aSuppressor(60000, 10, 0);
+			unsigned int aAdmitted = 0;
+			Repeat(aSuppressor, 4, 100, 8, aAdmitted);
+		}
+		std::vector<LogMessage> aMessages;
+		LogSuppressor::Expire(evolve::utils::Clock::Now(true), false, aMessages);
+		EVOLVE_CHECK_EQUAL(aMessages.size(), 1u);
+		if (aMessages.size() == 1) {
+			EVOLVE_CHECK_EQUAL(aMessages[0]._message.str(), "last message repeated 7 times: chunk 4 lost");
+		}
+	}
+}
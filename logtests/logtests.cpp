@@ -0,0 +1,82 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file logtests/logtests.cpp
+ * \brief evolve_logtests, behaviour checks of the log components
+ * \author
+ *
+ * Runs every component test in turn and prints the failed checks.
+ * Exits with EXIT_FAILURE if any check failed, so a build script can run it.
+ */
+
+#include "logtests.h"
+#include <cstdlib>
+#include <thread>
+
+int gFailures = 0;
+
+evolve::log::LogMessage TestMessage(const char* iText, evolve::log::LogLevel iLevel, unsigned long long iTime, unsigned int iThreadIndex,
+	unsigned int iLine, const char* iFunc) {
+	evolve::log::LogMessage aMessage;
+	aMessage._level = iLevel;
+	aMessage._time = iTime;
+	aMessage._file = "chunk.cpp";
+	aMessage._line = iLine;
+	aMessage._func = iFunc;
+	aMessage._threadId = std::this_thread::get_id();
+	aMessage._threadIndex = iThreadIndex;
+	aMessage._message = iText;
+	return aMessage;
+}
+
+/**
+ * \brief Run one component test and print its outcome
+ */
+static void Run(const char* iName, void (*iTest)()) {
+	const int aFailures = gFailures;
+	iTest();
+	std::cout << iName << (gFailures == aFailures ? ": ok" : ": FAILED") << std::endl;
+}
+
+int main() {
+	Run("LogArguments", &TestLogArguments);
+	Run("BinaryLogReader", &TestBinaryLogReader);
+	Run("SpscRingBuffer", &TestSpscRingBuffer);
+	Run("LogSuppressor", &TestLogSuppressor);
+	Run("LogFields", &TestLogFields);
+	Run("JsonLinesLoggerReporter", &TestJsonLinesLoggerReporter);
+	Run("LogLayout", &TestLogLayout);
+	Run("LogSampler", &TestLogSampler);
+	Run("LogIndex", &TestLogIndex);
+	Run("AsyncFileWriter", &TestAsyncFileWriter);
+	Run("SharedMemoryLogReader", &TestSharedMemoryLogReader);
+	Run("LogText", &TestLogText);
+	Run("FlightRecorder", &TestFlightRecorder);
+
+	if (gFailures != 0) {
+		std::cerr << gFailures << " checks failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file logtests/logtests.h
+ * \brief evolve_logtests, checks shared by the component tests
+ * \author
+ *
+ */
+
+#ifndef EVOLVE_LOGTESTS_H
+#define EVOLVE_LOGTESTS_H
+
+#include <evolve/log/logger.h>
+#include <iostream>
+
+/**
+ * Number of failed checks since the start of the run
+ */
+extern int gFailures;
+
+/**
+ * Count and report a failed check, the test goes on
+ */
+#define EVOLVE_CHECK(condition) \
+	do{ \
+		if (!(condition)) { \
+			std::cerr << __FILE__ << "#" << __LINE__ << ": check failed: " << #condition << std::endl; \
+			++gFailures; \
+		} \
+	} while(0)
+
+/**
+ * Compare two values, both printed on failure
+ */
+#define EVOLVE_CHECK_EQUAL(actual, expected) \
+	do{ \
+		if (!((actual) == (expected))) { \
+			std::cerr << __FILE__ << "#" << __LINE__ << ": check failed: " << #actual << " is \"" << (actual) \
+				<< "\", expected \"" << (expected) << "\"" << std::endl; \
+			++gFailures; \
+		} \
+	} while(0)
+
+/**
+ * Time of the fixture messages, 2017-07-14 02:40:00.123456789 UTC
+ */
+#define EVOLVE_TEST_TIME 1500000000123456789ULL
+
+/**
+ * \brief Build a fixture message, logged from "chunk.cpp" on the calling thread
+ *
+ * \param[in] iText message text
+ * \param[in] iLevel message level
+ * \param[in] iTime nanoseconds since epoch
+ * \param[in] iThreadIndex thread index, the thread id is the caller's
+ * \param[in] iLine source line
+ * \param[in] iFunc function name, must outlive the message
+ * \return the message
+ */
+evolve::log::LogMessage TestMessage(const char* iText = "chunk lost", evolve::log::LogLevel iLevel = evolve::log::LEVEL_ERROR,
+	unsigned long long iTime = EVOLVE_TEST_TIME, unsigned int iThreadIndex = 7, unsigned int iLine = 42, const char* iFunc = "load");
+
+void TestLogArguments();
+void TestBinaryLogReader();
+void TestSpscRingBuffer();
+void TestLogSuppressor();
+void TestLogFields();
+void TestJsonLinesLoggerReporter();
+void TestLogLayout();
+void TestLogSampler();
+void TestLogIndex();
+void TestAsyncFileWriter();
+void TestSharedMemoryLogReader();
+void TestLogText();
+void TestFlightRecorder();
+
+#endif
@@ -0,0 +1,128 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file logtests/logtexttests.cpp
+ * \brief evolve_logtests, message text storage
+ * \author
+ *
+ */
+
+#include "logtests.h"
+#include <evolve/log/logtext.h>
+#include <iomanip>
+#include <string>
+
+using evolve::log::LogStream;
+using evolve::log::LogText;
+using evolve::log::LogTextPool;
+
+//streaming it builds another message on the same thread
+struct Nested {
+	std::string _text;
+};
+
+static std::ostream& operator<<(std::ostream& ioStream, const Nested& iNested) {
+	LogText aText;
+	{
+		LogStream::Scope aScope(aText);
+		aScope.get() << "inner " << std::hex << 255;
+	}
+	EVOLVE_CHECK_EQUAL(aText.str(), "inner ff");
+	return ioStream << iNested._text;
+}
+
+void TestLogText() {
+	const std::string aShort(EVOLVE_LOG_INLINE_TEXT_SIZE - 1, 's');
+	const std::string aLong(EVOLVE_LOG_INLINE_TEXT_SIZE, 'l');
+
+	//the longest inline text, then the shortest spilled one
+	LogText aText;
+	aText = aShort;
+	EVOLVE_CHECK_EQUAL(aText.capacity(), static_cast<std::size_t>(EVOLVE_LOG_INLINE_TEXT_SIZE));
+	EVOLVE_CHECK_EQUAL(aText.str(), aShort);
+	aText = aLong;
+	EVOLVE_CHECK(aText.capacity() > static_cast<std::size_t>(EVOLVE_LOG_INLINE_TEXT_SIZE));
+	EVOLVE_CHECK_EQUAL(aText.str(), aLong);
+	EVOLVE_CHECK_EQUAL(aText.c_str()[aText.size()], '\0');
+
+	//a move steals the block, a copy gets its own
+	const char* aBlock = aText.data();
+	LogText aMoved(std::move(aText));
+	EVOLVE_CHECK(aMoved.data() == aBlock);
+	EVOLVE_CHECK(aText.empty());
+	EVOLVE_CHECK_EQUAL(aText.capacity(), static_cast<std::size_t>(EVOLVE_LOG_INLINE_TEXT_SIZE));
+	LogText aCopy(aMoved);
+	EVOLVE_CHECK(aCopy.data() != aBlock);
+	EVOLVE_CHECK_EQUAL(aCopy.str(), aLong);
+	aText = std::move(aCopy);
+	EVOLVE_CHECK_EQUAL(aText.str(), aLong);
+	EVOLVE_CHECK(aCopy.empty());
+
+	//clearing keeps the block, a short text goes back inline
+	aMoved.clear();
+	EVOLVE_CHECK(aMoved.data() == aBlock);
+	EVOLVE_CHECK(aMoved.empty());
+	aMoved = "short";
+	EVOLVE_CHECK(aMoved.data() != aBlock);
+	EVOLVE_CHECK_EQUAL(aMoved.capacity(), static_cast<std::size_t>(EVOLVE_LOG_INLINE_TEXT_SIZE));
+	EVOLVE_CHECK_EQUAL(aMoved.str(), "short");
+
+	//grown byte by byte through every size class, then past the largest one
+	std::string aExpected;
+	LogText aGrown;
+	for (std::size_t i = 0; i < 100000; ++i) {
+		const char aChar = static_cast<char>('a' + i % 26);
+		aGrown += aChar;
+		aExpected += aChar;
+	}
+	EVOLVE_CHECK(aGrown.str() == aExpected);
+	EVOLVE_CHECK(aGrown.capacity() > aGrown.size());
+
+	//released blocks are handed out again, no new slab is carved
+	{
+		LogText aWarmup;
+		aWarmup.assign(aExpected.data(), 1000);
+	}
+	const std::size_t aReserved = LogTextPool::GetReservedSize();
+	for (unsigned int i = 0; i < 10000; ++i) {
+		LogText aSpilled;
+		aSpilled.assign(aExpected.data(), 1000);
+		LogText aOther(std::move(aSpilled));
+		EVOLVE_CHECK_EQUAL(aOther.size(), 1000u);
+	}
+	EVOLVE_CHECK_EQUAL(LogTextPool::GetReservedSize(), aReserved);
+
+	//streamed texts spill too, the format state does not leak from one message to the next
+	LogText aStreamed;
+	{
+		LogStream::Scope aScope(aStreamed);
+		aScope.get() << std::hex << 255 << ' ' << aExpected;
+	}
+	EVOLVE_CHECK(aStreamed.str() == "ff " + aExpected);
+	{
+		LogStream::Scope aScope(aStreamed);
+		aScope.get() << 255 << ' ' << Nested{ aLong } << ' ' << std::setw(4) << 1;
+	}
+	EVOLVE_CHECK_EQUAL(aStreamed.str(), "255 " + aLong + "    1");
+}
@@ -0,0 +1,141 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file logtests/sharedmemorylogreadertests.cpp
+ * \brief evolve_logtests, shared memory ring read back
+ * \author
+ *
+ */
+
+#include "logtests.h"
+#include <evolve/log/sharedmemoryloggerreporter.h>
+#include <string>
+
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
+
+using evolve::log::BinaryLogRecord;
+using evolve::log::SharedMemoryLoggerReporter;
+using evolve::log::SharedMemoryLogReader;
+
+static const char* SHARED_RING = "/evolve_logtests_ring";
+
+static void Publish(SharedMemoryLoggerReporter& ioWriter, unsigned int iFirst, unsigned int iCount) {
+	for (unsigned int i = iFirst; i < iFirst + iCount; ++i) {
+		const std::string aText = "record " + std::to_string(i);
+		ioWriter.log(TestMessage(aText.c_str(), evolve::log::LEVEL_INFO, EVOLVE_TEST_TIME + i, 7, i));
+	}
+}
+
+//reads every available record, they must follow each other from iFirst
+static unsigned int Consume(SharedMemoryLogReader& ioReader, unsigned int iFirst) {
+	BinaryLogRecord aRecord;
+	unsigned int aCount = 0;
+	while (ioReader.next(aRecord)) {
+		const unsigned int aIndex = iFirst + aCount;
+		EVOLVE_CHECK_EQUAL(aRecord._message, "record " + std::to_string(aIndex));
+		EVOLVE_CHECK_EQUAL(aRecord._time, EVOLVE_TEST_TIME + aIndex);
+		EVOLVE_CHECK_EQUAL(aRecord._line, aIndex);
+		EVOLVE_CHECK_EQUAL(aRecord._file, "chunk.cpp");
+		EVOLVE_CHECK_EQUAL(aRecord._func, "load");
+		EVOLVE_CHECK(aRecord._level == evolve::log::LEVEL_INFO);
+		++aCount;
+	}
+	return aCount;
+}
+
+void TestSharedMemoryLogReader() {
+	{
+		//the smallest ring, records cross its end several times
+		SharedMemoryLoggerReporter aWriter(SHARED_RING, 4096);
+		SharedMemoryLogReader aReader(SHARED_RING);
+		EVOLVE_CHECK(aReader.isOpen());
+		EVOLVE_CHECK(!aReader.isClosed());
+		EVOLVE_CHECK(!aReader.isReplaced());
+
+		unsigned int aNext = 0;
+		for (unsigned int aRound = 0; aRound < 10; ++aRound) {
+			Publish(aWriter, aNext, 20);
+			EVOLVE_CHECK_EQUAL(Consume(aReader, aNext), 20u);
+			aNext += 20;
+		}
+		EVOLVE_CHECK_EQUAL(aReader.getLostCount(), 0ULL);
+
+		//a slow reader: the oldest records are overwritten, reading resumes at the oldest one kept
+		Publish(aWriter, aNext, 500);
+		BinaryLogRecord aRecord;
+		EVOLVE_CHECK(aReader.next(aRecord));
+		const unsigned long long aLost = aReader.getLostCount();
+		EVOLVE_CHECK(aLost > 0 && aLost < 500);
+		EVOLVE_CHECK_EQUAL(aRecord._message, "record " + std::to_string(aNext + aLost));
+		const unsigned int aKept = 1 + Consume(aReader, static_cast<unsigned int>(aNext + aLost + 1));
+		EVOLVE_CHECK_EQUAL(aLost + aKept, 500ULL);
+		EVOLVE_CHECK_EQUAL(aReader.getLostCount(), aLost);
+		aNext += 500;
+
+		//a reader from the newest record only sees what comes after it
+		SharedMemoryLogReader aLate(SHARED_RING, false);
+		EVOLVE_CHECK(!aLate.next(aRecord));
+		Publish(aWriter, aNext, 1);
+		EVOLVE_CHECK_EQUAL(Consume(aLate, aNext), 1u);
+		EVOLVE_CHECK_EQUAL(Consume(aReader, aNext), 1u);
+		++aNext;
+
+		//a reader from the start gets the kept records, without counting the older ones as lost
+		SharedMemoryLogReader aEarly(SHARED_RING);
+		EVOLVE_CHECK(aEarly.next(aRecord));
+		const unsigned int aOldest = static_cast<unsigned int>(std::stoul(aRecord._message.substr(7)));
+		EVOLVE_CHECK(aOldest + aKept + 1 >= aNext);
+		EVOLVE_CHECK_EQUAL(Consume(aEarly, aOldest + 1), aNext - aOldest - 1);
+		EVOLVE_CHECK_EQUAL(aEarly.getLostCount(), 0ULL);
+	}
+
+	{
+		//records stay readable once the writer is gone, until a new writer replaces the ring
+		SharedMemoryLogReader* aReader = NULL;
+		{
+			SharedMemoryLoggerReporter aWriter(SHARED_RING, 4096);
+			aReader = new SharedMemoryLogReader(SHARED_RING);
+			Publish(aWriter, 0, 3);
+		}
+		EVOLVE_CHECK(aReader->isClosed());
+		EVOLVE_CHECK(!aReader->isReplaced());
+		EVOLVE_CHECK_EQUAL(Consume(*aReader, 0), 3u);
+
+		SharedMemoryLoggerReporter aWriter(SHARED_RING, 4096);
+		EVOLVE_CHECK(aReader->isReplaced());
+		delete aReader;
+
+		SharedMemoryLogReader aReopened(SHARED_RING);
+		EVOLVE_CHECK(!aReopened.isClosed());
+		EVOLVE_CHECK(!aReopened.isReplaced());
+		Publish(aWriter, 0, 2);
+		EVOLVE_CHECK_EQUAL(Consume(aReopened, 0), 2u);
+	}
+
+#ifndef WIN32
+	::shm_unlink(SHARED_RING);
+#endif
+}
@@ -0,0 +1,162 @@
+/******************************************************************
+* This source file is part of Evolve (Easy VOxeL Vulkan Engine)  *
+*                                                                *
+* Copyright (c) 2017 Ratouit Thomas                              *
+*                                                                *
+* Licensed to the Apache Software Foundation (ASF) under one     *
+* or more contributor license agreements.  See the NOTICE file   *
+* distributed with this work for additional information          *
+* regarding copyright ownership.  The ASF licenses this file     *
+* to you under the Apache License, Version 2.0 (the              *
+* "License"); you may not use this file except in compliance     *
+* with the License.  You may obtain a copy of the License at     *
+*                                                                *
+* http://www.apache.org/licenses/LICENSE-2.0                     *
+*                                                                *
+* Unless required by applicable law or agreed to in writing,     *
+* software distributed under the License is distributed on an    *
+* "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY         *
+* KIND, either express or implied.  See the License for the      *
+* specific language governing permissions and limitations        *
+* under the License.                                             *
+******************************************************************/
+
+/**
+ * \file logtests/spscringbuffertests.cpp
+ * \brief evolve_logtests, lock-free ring between a logging thread and its sink
+ * \author
+ *
+ */
+
+#include "logtests.h"
+#include <evolve/utils/spscringbuffer.h>
+#include <memory>
+#include <string>
+#include <thread>
+
+using evolve::utils::SpscRingBuffer;
+
+static const unsigned int THREADED_COUNT = 200000;
+
+void TestSpscRingBuffer() {
+	//the capacity is rounded up to a power of two
+	{
+		SpscRingBuffer<int> aRing(5);
+		EVOLVE_CHECK_EQUAL(aRing.capacity(), 8u);
+		EVOLVE_CHECK(aRing.empty());
+		EVOLVE_CHECK_EQUAL(aRing.size(), 0u);
+	}
+
+	//items come out in order, a full ring refuses new ones
+	{
+		SpscRingBuffer<int> aRing(4);
+		for (int i = 0; i < 4; ++i) {
+			EVOLVE_CHECK(aRing.tryPush(i));
+		}
+		EVOLVE_CHECK(!aRing.tryPush(4));
+		EVOLVE_CHECK_EQUAL(aRing.size(), 4u);
+
+		int aItems[8];
+		EVOLVE_CHECK_EQUAL(aRing.popBulk(aItems, 3), 3u);
+		EVOLVE_CHECK(aItems[0] == 0 && aItems[1] == 1 && aItems[2] == 2);
+		EVOLVE_CHECK(aRing.tryPush(4));
+		EVOLVE_CHECK_EQUAL(aRing.popBulk(aItems, 8), 2u);
+		EVOLVE_CHECK(aItems[0] == 3 && aItems[1] == 4);
+		EVOLVE_CHECK_EQUAL(aRing.popBulk(aItems, 8), 0u);
+		EVOLVE_CHECK(aRing.empty());
+	}
+
+	//a refused move leaves the item to the caller
+	{
+		SpscRingBuffer<std::unique_ptr<int> > aRing(2);
+		EVOLVE_CHECK(aRing.tryPush(std::unique_ptr<int>(new int(1))));
+		EVOLVE_CHECK(aRing.tryPush(std::unique_ptr<int>(new int(2))));
+		std::unique_ptr<int> aKept(new int(3));
+		EVOLVE_CHECK(!aRing.tryPush(std::move(aKept)));
+		EVOLVE_CHECK(aKept && *aKept == 3);
+	}
+
+	//pushOverwrite drops the oldest item only when the ring is full
+	{
+		SpscRingBuffer<std::string> aRing(2);
+		EVOLVE_CHECK(!aRing.pushOverwrite(std::string("a")));
+		EVOLVE_CHECK(!aRing.pushOverwrite(std::string("b")));
+		EVOLVE_CHECK(aRing.pushOverwrite(std::string("c")));
+		EVOLVE_CHECK_EQUAL(aRing.size(), 2u);
+
+		std::string aItems[4];
+		EVOLVE_CHECK_EQUAL(aRing.popBulk(aItems, 4), 2u);
+		EVOLVE_CHECK_EQUAL(aItems[0], "b");
+		EVOLVE_CHECK_EQUAL(aItems[1], "c");
+	}
+
+	//one producer, one consumer: nothing lost, nothing reordered
+	{
+		SpscRingBuffer<unsigned int> aRing(64);
+		std::thread aProducer([&aRing]() {
+			for (unsigned int i = 0; i < THREADED_COUNT; ++i) {
+				while (!aRing.tryPush(i)) {
+					std::this_thread::yield();
+				}
+			}
+		});
+
+		unsigned int aExpected = 0;
+		bool aOrdered = true;
+		unsigned int aItems[16];
+		while (aExpected < THREADED_COUNT) {
+			const std::size_t aCount = aRing.popBulk(aItems, 16);
+			if (aCount == 0) {
+				std::this_thread::yield();
+			}
+			for (std::size_t i = 0; i < aCount; ++i) {
+				aOrdered = aOrdered && aItems[i] == aExpected;
+				++aExpected;
+			}
+		}
+		aProducer.join();
+		EVOLVE_CHECK(aOrdered);
+		EVOLVE_CHECK(aRing.empty());
+	}
+
+	//overwriting while the consumer pops: order is kept, every item is either popped or counted as dropped
+	{
+		SpscRingBuffer<unsigned int> aRing(16);
+		unsigned int aDropped = 0;
+		std::thread aProducer([&aRing, &aDropped]() {
+			for (unsigned int i = 1; i <= THREADED_COUNT; ++i) {
+				if (aRing.pushOverwrite(i)) {
+					++aDropped;
+				}
+			}
+			//end marker, pushed once the consumer made room
+			while (!aRing.tryPush(0)) {
+				std::this_thread::yield();
+			}
+		});
+
+		unsigned int aPopped = 0;
+		unsigned int aLast = 0;
+		bool aOrdered = true;
+		bool aDone = false;
+		unsigned int aItems[16];
+		while (!aDone) {
+			const std::size_t aCount = aRing.popBulk(aItems, 16);
+			if (aCount == 0) {
+				std::this_thread::yield();
+			}
+			for (std::size_t i = 0; i < aCount; ++i) {
+				if (aItems[i] == 0) {
+					aDone = true;
+					break;
+				}
+				aOrdered = aOrdered && aItems[i] > aLast;
+				aLast = aItems[i];
+				++aPopped;
+			}
+		}
+		aProducer.join();
+		EVOLVE_CHECK(aOrdered);
+		EVOLVE_CHECK_EQUAL(aPopped + aDropped, THREADED_COUNT);
+	}
+}